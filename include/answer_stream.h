@@ -0,0 +1,61 @@
+#ifndef ANSWER_STREAM_H
+#define ANSWER_STREAM_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include "search_engine.h"
+
+class FetchBudget;
+
+// Progressive answer protocol: retrieval results first, then LLM tokens,
+// then the finished answer with confidence and citations
+enum AnswerEventType {
+    ANSWER_EVENT_PARTIAL,   // Sources + extractive summary (retrieval done)
+    ANSWER_EVENT_TOKEN,     // Incremental LLM output
+    ANSWER_EVENT_FINAL      // Complete answer, no more events follow
+};
+
+struct AnswerEvent {
+    AnswerEventType type;
+    std::string token;      // ANSWER_EVENT_TOKEN only
+    Answer answer;          // ANSWER_EVENT_PARTIAL / ANSWER_EVENT_FINAL
+};
+
+// Thread-safe channel between the search worker (producer) and
+// UI::Update (consumer)
+class AnswerStream {
+public:
+    AnswerStream();
+    ~AnswerStream();
+    
+    // Producer side
+    void PushPartial(const Answer& answer);
+    void PushToken(const std::string& token);
+    void PushFinal(const Answer& answer);
+    
+    // Consumer side (non-blocking)
+    bool Poll(AnswerEvent& outEvent);
+    bool IsFinished() const { return finished; }
+    
+    // Cancellation (consumer asks, producer checks). A budget set by the
+    // producer is cancelled too, so its fetches stop at once; one set after
+    // Cancel is cancelled as it is set
+    void Cancel();
+    bool IsCancelled() const { return cancelled; }
+    void SetBudget(FetchBudget* budget);  // nullptr before deleting it
+    
+    void Reset();
+    
+private:
+    std::mutex mutex;
+    std::deque<AnswerEvent> events;
+    std::atomic<bool> finished;
+    std::atomic<bool> cancelled;
+    FetchBudget* budget;    // Under mutex
+    
+    void Push(const AnswerEvent& event);
+};
+
+#endif // ANSWER_STREAM_H
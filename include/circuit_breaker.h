@@ -0,0 +1,43 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+// Per-host failure tracking, so a dead or overloaded site stops costing a
+// full timeout per URL. After failureThreshold consecutive failures the
+// host's circuit opens and requests to it are refused at once. Once
+// openSeconds have passed one trial request goes through (half-open): a
+// success closes the circuit, a failure opens it again for twice as long,
+// up to maxOpenSeconds.
+class CircuitBreaker {
+public:
+    typedef std::chrono::steady_clock Clock;
+    
+    CircuitBreaker(int failureThreshold, int openSeconds, int maxOpenSeconds);
+    
+    // Whether a request to host may go out now
+    bool Allow(const std::string& host, Clock::time_point now);
+    
+    void RecordSuccess(const std::string& host);
+    void RecordFailure(const std::string& host, Clock::time_point now);
+    
+private:
+    struct Circuit {
+        int failures;             // Consecutive
+        bool open;
+        int openSeconds;          // Current open period
+        Clock::time_point retryAt;  // Next trial request while open
+    };
+    
+    int failureThreshold;
+    int baseOpenSeconds;
+    int maxOpenSeconds;
+    
+    std::mutex mutex;
+    std::map<std::string, Circuit> circuits;  // Hosts with recent failures only
+};
+
+#endif // CIRCUIT_BREAKER_H
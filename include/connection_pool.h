@@ -0,0 +1,71 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include <cstdint>
+#include "http_transport.h"
+
+// Acquire error: every connection stayed busy for the whole timeout
+static const int POOL_ERROR_BUSY = -1;
+
+struct PoolStats {
+    uint64_t opened;   // New connections (a handshake each)
+    uint64_t reused;   // Requests served on a kept-alive connection
+    uint64_t expired;  // Idle connections closed by the idle timeout
+    
+    PoolStats() : opened(0), reused(0), expired(0) {}
+};
+
+// Keep-alive connections per origin. A finished request hands its
+// connection back and the next request to the same origin picks it up,
+// skipping the TCP and TLS handshakes. At most maxConnections are open at
+// once (busy plus idle); when the pool is full an idle connection to some
+// other origin is closed to make room, and if every connection is busy
+// Acquire waits for one. Idle connections are closed after idleTimeoutSec
+// since servers drop them around then anyway.
+class ConnectionPool {
+public:
+    ConnectionPool(HttpTransport* transport, int maxConnections = 4,
+                   int maxIdlePerOrigin = 2, int idleTimeoutSec = 30);
+    ~ConnectionPool();
+    
+    // Idle connection to the URL's origin, or a new one (timeoutSec bounds
+    // both the wait for a free slot and the connect). reused tells the
+    // caller a failed send may just be a connection the server closed.
+    // nullptr on failure (error holds the transport code)
+    HttpConnection* Acquire(const HttpUrl& url, int timeoutSec, bool& reused, int& error);
+    
+    // Back to the idle list when reusable, otherwise closed
+    void Release(HttpConnection* conn, const HttpUrl& url, bool reusable);
+    
+    // Closes idle connections past the idle timeout (all of them when force)
+    void CloseIdle(bool force = false);
+    
+    PoolStats GetStats();
+    
+private:
+    struct IdleEntry {
+        std::string origin;
+        HttpConnection* conn;
+        time_t idleSince;
+    };
+    
+    HttpTransport* transport;
+    int maxConnections;
+    int maxIdlePerOrigin;
+    int idleTimeoutSec;
+    
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<IdleEntry> idle;  // Oldest first
+    int busy;
+    PoolStats stats;
+    
+    void ExpireIdle(time_t now, std::vector<HttpConnection*>& closing);
+};
+
+#endif // CONNECTION_POOL_H
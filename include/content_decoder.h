@@ -0,0 +1,58 @@
+#ifndef CONTENT_DECODER_H
+#define CONTENT_DECODER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "http_transport.h"
+
+// Streaming Content-Encoding decoder. Compressed bytes go in as they come
+// off the connection; decoded output comes out through the callback in
+// pieces of at most DECODE_WINDOW_BYTES, so a page is never held twice.
+// "deflate" accepts both zlib-wrapped and raw streams (servers send either).
+class ContentDecoder {
+public:
+    enum Encoding {
+        ENCODING_IDENTITY,
+        ENCODING_GZIP,
+        ENCODING_DEFLATE,
+        ENCODING_UNSUPPORTED
+    };
+    
+    static const size_t DECODE_WINDOW_BYTES = 16384;
+    
+    ContentDecoder();
+    ~ContentDecoder();
+    
+    // Content-Encoding header value ("" = identity)
+    static Encoding ParseEncoding(const std::string& header);
+    
+    bool Begin(Encoding encoding);
+    
+    // False on corrupt data, or when onChunk asked to stop (Stopped())
+    bool Decode(const char* data, size_t length, const ChunkCallback& onChunk);
+    
+    // Whether the compressed stream ended properly
+    bool IsComplete() const;
+    bool Stopped() const { return stopped; }
+    Encoding GetEncoding() const { return encoding; }
+    
+    uint64_t GetBytesIn() const { return bytesIn; }
+    uint64_t GetBytesOut() const { return bytesOut; }
+    
+private:
+    Encoding encoding;
+    void* stream;       // z_stream, kept out of this header
+    bool started;       // Inflate initialized (deflate waits for its first byte)
+    bool finished;      // Z_STREAM_END seen
+    bool stopped;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    std::vector<char> window;  // Output buffer, allocated once (off the worker stacks)
+    
+    bool Start(const char* firstBytes, size_t length);
+    void End();
+};
+
+#endif // CONTENT_DECODER_H
@@ -4,6 +4,16 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include "html_tokenizer.h"
+#include "page_metadata.h"
+
+// Quote with context
+struct Quote {
+    std::string text;
+    std::string speaker;  // Attributed speaker ("" when not found)
+    std::string context;  // Surrounding text
+    int position;  // Position in document
+};
 
 // Extracted content structure
 struct ExtractedContent {
@@ -13,19 +23,15 @@ struct ExtractedContent {
     std::string domain;
     std::string mainText;
     std::string snippet;  // First ~500 chars
-    std::vector<std::string> quotes;  // Text in quotation marks
+    std::vector<Quote> quotes;  // Text in quotation marks
+    std::vector<std::string> steps;     // <ol> items or "1." / "Step 1:" lines
+    std::vector<std::string> warnings;  // Warning/caution sentences
+    std::vector<std::string> bullets;   // <ul> items
     std::string language;
     int wordCount;
     bool hasPaywall;
 };
 
-// Quote with context
-struct Quote {
-    std::string text;
-    std::string context;  // Surrounding text
-    int position;  // Position in document
-};
-
 class ContentExtractor {
 public:
     ContentExtractor();
@@ -41,6 +47,9 @@ public:
     std::string ExtractMainContent(const std::string& html);
     std::vector<Quote> ExtractQuotes(const std::string& html, int maxLength = 200);
     
+    // Ingest-time structure so answer builders never re-parse text
+    void ExtractStructure(const std::string& html, ExtractedContent& content);
+    
     // Cleaning
     std::string StripHTML(const std::string& html);
     std::string RemoveScriptsAndStyles(const std::string& html);
@@ -55,34 +64,119 @@ public:
     void SetMaxQuoteLength(int length) { maxQuoteLength = length; }
     
 private:
+    friend class ExtractionStream;
+    
     int maxTextLength;  // Max words to extract (default 2000)
     int maxQuoteLength;  // Max quote length (default 200 chars)
     
-    // Readability-like extraction
+    // Byte range in PageModel::text
+    struct TextRange {
+        size_t start;
+        size_t end;
+    };
+    
+    // Readability-like candidate: an element that contains scored paragraphs
     struct ContentBlock {
-        std::string tag;
-        std::string content;
-        int textLength;
-        int linkDensity;
+        TextRange range;
         float score;
     };
     
-    std::vector<ContentBlock> FindContentBlocks(const std::string& html);
-    ContentBlock SelectBestBlock(const std::vector<ContentBlock>& blocks);
+    struct ListItem {
+        TextRange range;
+        bool ordered;
+        float linkDensity;
+    };
+    
+    // Element on the open-tag stack
+    struct OpenElement {
+        std::string name;  // Lowercase
+        size_t textStart;
+        size_t linkStart;
+        bool ordered;  // <li> inside an <ol>
+        bool hasBlockChild;
+        bool scored;  // Received score from a descendant paragraph
+        float weight;  // Tag and class/id bias
+        float contentScore;
+    };
+    
+    // Everything the extraction stages need, gathered in one token pass
+    struct PageModel {
+        std::string text;  // Visible body text, '\n' at block boundaries
+        std::string title;
+        std::string h1;
+        PageMetadata meta;  // <meta>, <link>, <time> and JSON-LD
+        std::vector<ContentBlock> candidates;
+        std::vector<ListItem> listItems;
+        bool hasPaywall;
+        
+        // Parser state
+        std::vector<OpenElement> stack;
+        size_t linkChars;
+        int linkDepth;
+        int h1State;  // 0 = not seen, 1 = inside the first <h1>, 2 = done
+        bool inHead;
+        bool inTitle;
+        bool inJsonLd;
+        std::string jsonLd;  // Body of the ld+json script being read
+        
+        PageModel();
+    };
+    
+    void ParsePage(const std::string& html, PageModel& page);
+    void FinishPage(PageModel& page);
+    ExtractedContent BuildContent(PageModel& page, const std::string& url);
+    bool HasEnoughContent(const PageModel& page) const;
+    void ConsumeToken(const HtmlToken& token, PageModel& page);
+    void ConsumeHeadTag(const HtmlToken& token, PageModel& page);
+    void AppendText(PageModel& page, const HtmlSpan& text);
+    void AppendBreak(PageModel& page);
+    void CloseElement(PageModel& page);
+    void ScoreParagraph(PageModel& page, const TextRange& range);
+    float ElementWeight(const HtmlToken& token);
+    
+    bool FindMainRegion(const PageModel& page, TextRange& region);
+    std::string SelectMainText(const PageModel& page, TextRange& region);
+    std::string PageTitle(const PageModel& page);
+    
+    // Structure helpers
+    void CollectStructure(const PageModel& page, const TextRange& region, ExtractedContent& content);
+    std::vector<std::string> FindNumberedSteps(const std::string& text);
+    std::vector<std::string> FindWarnings(const std::string& text);
     
     // Helpers
-    std::string FindBetween(const std::string& str, const std::string& start, const std::string& end);
-    std::vector<std::string> FindAllBetween(const std::string& str, const std::string& start, const std::string& end);
     int CountWords(const std::string& text);
-    float CalculateLinkDensity(const std::string& html);
-    
-    // Meta tag extraction
-    std::string GetMetaTag(const std::string& html, const std::string& name);
-    std::string GetMetaProperty(const std::string& html, const std::string& property);
     
     // Quote extraction helpers
+    std::vector<Quote> FindQuotes(const std::string& text, int maxLength);
     std::vector<Quote> FindQuotedText(const std::string& text, const std::string& openQuote, const std::string& closeQuote);
     std::string GetQuoteContext(const std::string& text, int position, int contextWords = 10);
+    std::string FindSpeaker(const std::string& text, size_t quoteStart, size_t quoteEnd);
+};
+
+// Incremental extraction for pages that arrive in chunks: keeps tokenizer
+// and page state between chunks, so the HTML is never held in full
+class ExtractionStream {
+public:
+    ExtractionStream(ContentExtractor* extractor, const std::string& url);
+    
+    // Consumes the next chunk; false once enough content has been seen
+    // and the rest of the download can be dropped
+    bool Feed(const char* data, size_t length);
+    
+    // Flushes the held-back tail and builds the result
+    ExtractedContent Finish();
+    
+    size_t GetBytesFed() const { return bytesFed; }
+    
+private:
+    ContentExtractor* extractor;
+    std::string url;
+    ContentExtractor::PageModel page;
+    HtmlTokenizer tokenizer;
+    std::string carry;  // Partial token left over from the previous chunk
+    size_t bytesFed;
+    
+    void Consume(const char* data, size_t length, bool final);
 };
 
 #endif // CONTENT_EXTRACTOR_H
@@ -0,0 +1,19 @@
+#ifndef CURATED_QUESTIONS_H
+#define CURATED_QUESTIONS_H
+
+// Fixed entries shown on the Scenarios and Manuals screens. The answer for
+// each key is precomputed on the host (tools/materializer) and stored in
+// the pack's answers table, so opening one never runs a search.
+struct CuratedQuestion {
+    const char* key;        // answers.answer_key
+    const char* label;      // List label in the UI
+    const char* question;   // Query used to build (or live-fallback) the answer
+};
+
+extern const CuratedQuestion SCENARIO_QUESTIONS[];
+extern const int SCENARIO_QUESTION_COUNT;
+
+extern const CuratedQuestion MANUAL_QUESTIONS[];
+extern const int MANUAL_QUESTION_COUNT;
+
+#endif // CURATED_QUESTIONS_H
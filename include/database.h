@@ -4,7 +4,20 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include <cstdint>
+#include <mutex>
+#include <functional>
 #include "sqlite3.h"
+#include "fts_rank.h"
+#include "item_identity.h"
+
+// One attributed quote (quotes table, one row per quote)
+struct VaultQuote {
+    std::string text;
+    std::string speaker;
+    std::string context;
+    int position;           // Offset in the source text
+};
 
 struct VaultItem {
     std::string id;
@@ -21,15 +34,60 @@ struct VaultItem {
     std::string language;
     std::string content_type;
     std::string license_note;
+    std::vector<std::string> steps;      // Ordered instructions found at ingest
+    std::vector<std::string> warnings;   // Cautions/warnings found at ingest
+    std::vector<std::string> bullets;    // Unordered list items found at ingest
+    std::vector<VaultQuote> quotes;      // Written to the quotes table on insert
+    uint64_t simhash;                    // Body fingerprint, computed by InsertItem
     float relevance_score;
 };
 
+// Feed entry kept locally, so Ask-time searches never download feeds
+struct FeedItem {
+    std::string id;           // ComputeItemId(link)
+    std::string feed_url;
+    std::string source;       // Feed name
+    std::string title;
+    std::string link;
+    std::string description;
+    std::string author;
+    time_t published_at;      // 0 = unknown
+    time_t fetched_at;
+    float score;              // bm25 (lower is better), SearchFeedItems only
+};
+
+// Refresh bookkeeping, one row per configured feed
+struct FeedState {
+    std::string url;
+    time_t last_fetched;      // 0 = never
+    int item_count;           // Items in the last successful parse
+    int poll_interval;        // Learned polling interval in seconds, 0 = none yet
+    time_t next_poll;         // 0 = due now
+    time_t newest_item;       // Newest item date seen, 0 = none
+    double item_gap;          // Average seconds between items, 0 = unknown
+    
+    FeedState() : last_fetched(0), item_count(0), poll_interval(0), next_poll(0),
+                  newest_item(0), item_gap(0.0) {}
+};
+
 struct SearchResult {
     VaultItem item;
     float score;
     std::vector<std::string> matched_snippets;
+    std::vector<VaultQuote> quotes;      // Matched quotes (SearchQuotes only)
+};
+
+// Final ordering knobs for SearchFTS (evaluated inside SQLite)
+struct RankingOptions {
+    float recencyWeight;        // 0 = ignore age, 1 = age decay fully applied
+    float halfLifeDays;         // Age at which the recency boost halves
+    float authorityStrength;    // Exponent on the domain authority weight
+    
+    RankingOptions() : recencyWeight(0.2f), halfLifeDays(365.0f), authorityStrength(1.0f) {}
 };
 
+// The ask worker, the feed refresher and the fetch workers share one
+// connection; every method takes the lock, so calls never interleave
 class Database {
 public:
     Database();
@@ -48,17 +106,62 @@ public:
     bool DeleteItem(const std::string& id);
     bool UpdateItem(const VaultItem& item);
     
+    // In-memory prefilter of stored IDs (loaded on open): false means the
+    // item is definitely new; true means "almost certainly stored"
+    bool MayHaveItem(const std::string& id) const;
+    
+    // Near-duplicate lookup: any stored body within SIMHASH_MAX_DISTANCE bits,
+    // found through 4 indexed band probes (pigeonhole on 16-bit bands)
+    bool FindNearDuplicate(uint64_t simhash, std::string& outId);
+    
     // Search operations
-    std::vector<SearchResult> SearchFTS(const std::string& query, int limit = 10);
+    std::vector<SearchResult> SearchFTS(const std::string& query, int limit = 10,
+                                        const RankingOptions& ranking = RankingOptions());
+    // Same ranking, but only id, title, snippet, domain, published_at and
+    // simhash are read: enough to rerank, bodies come from GetItemById
+    std::vector<SearchResult> SearchFTSCandidates(const std::string& query, int limit = 10,
+                                                  const RankingOptions& ranking = RankingOptions());
     std::vector<SearchResult> SearchByTag(const std::string& tag, int limit = 10);
     std::vector<SearchResult> SearchByAuthor(const std::string& author, int limit = 10);
+    // Speaker + topic match on the quotes index; one result per item holding
+    // its matched quotes, at most `limit` quotes in total
     std::vector<SearchResult> SearchQuotes(const std::string& person, const std::string& topic = "", int limit = 10);
     
+    // Materialized answers (serialized Answer blobs keyed by scenario/manual)
+    bool StoreAnswer(const std::string& key, const std::string& query, const std::string& blob);
+    bool GetAnswer(const std::string& key, std::string& outBlob);
+    
+    // Feed item store: written by the background refresher, searched at Ask
+    // time. StoreFeedItems returns how many items were new.
+    int StoreFeedItems(const std::vector<FeedItem>& items);
+    std::vector<FeedItem> SearchFeedItems(const std::string& query, int limit = 20);
+    bool PruneFeedItems(time_t olderThan);
+    int GetFeedItemCount();
+    bool GetFeedState(const std::string& url, FeedState& state);
+    bool SetFeedState(const FeedState& state);
+    
+    // HTTP validators per URL for conditional GETs (ETag / Last-Modified and
+    // the size of the response they came with)
+    bool GetHttpValidators(const std::string& url, std::string& etag,
+                           std::string& lastModified, int64_t& bodyBytes);
+    bool SetHttpValidators(const std::string& url, const std::string& etag,
+                           const std::string& lastModified, int64_t bodyBytes);
+    bool PruneHttpValidators(time_t olderThan);
+    
+    // Per-domain authority used by the ranking function (1.0 = neutral)
+    float GetSourceAuthority(const std::string& domain);
+    bool SetSourceAuthority(const std::string& domain, float weight);
+    
     // Stats
     int GetTotalItems();
     std::vector<std::string> GetAllTags();
     time_t GetLastUpdated();
     
+    // Batched writes (bulk imports): runs work inside one transaction while
+    // holding the database, so other threads wait. Commits when work
+    // returns true, rolls back when it returns false or COMMIT fails
+    bool RunInTransaction(const std::function<bool()>& work);
+    
     // Maintenance
     bool Vacuum();
     bool OptimizeFTS();
@@ -67,15 +170,57 @@ private:
     sqlite3* db;
     bool isOpen;
     
+    // Held around each statement and transaction (recursive: methods nest)
+    mutable std::recursive_mutex mutex;
+    
     // Prepared statements (for performance)
     sqlite3_stmt* stmt_insert;
     sqlite3_stmt* stmt_search;
     sqlite3_stmt* stmt_get_by_id;
+    sqlite3_stmt* stmt_store_answer;
+    sqlite3_stmt* stmt_get_answer;
+    sqlite3_stmt* stmt_insert_quote;
+    sqlite3_stmt* stmt_delete;
+    sqlite3_stmt* stmt_get_rowid;
+    sqlite3_stmt* stmt_insert_band;
+    sqlite3_stmt* stmt_find_band;
+    sqlite3_stmt* stmt_insert_feed_item;
+    
+    BloomFilter knownIds;
+    
+    // survival_boost() state; falls back to plain rank when unavailable
+    AuthorityMap authority;
+    RankSignalMap rankSignals;
+    bool hasSurvivalBoost;
     
     bool PrepareStatements();
+    bool MigrateSchema();
+    bool AddColumnIfMissing(const std::string& table, const std::string& column,
+                            const std::string& decl);
     void FinalizeStatements();
+    std::vector<SearchResult> SearchFTSRows(const std::string& query, int limit,
+                                            const RankingOptions& ranking, bool fullRows);
+    // InsertItem inside its savepoint; oldRowid is the replaced row's (0 = none)
+    bool InsertItemRows(const VaultItem& item, sqlite3_int64& rowid, sqlite3_int64& oldRowid);
+    bool DeleteItemRow(const std::string& id, sqlite3_int64& rowid);
+    bool InsertQuotes(sqlite3_int64 itemRowid, const VaultItem& item);
+    bool BackfillQuotes();
+    bool InsertSimHashBands(sqlite3_int64 itemRowid, uint64_t simhash);
+    bool BackfillSimHashes();
+    bool LoadKnownIds();
+    bool LoadSourceAuthority();
+    bool LoadRankSignals();
     
     std::string EscapeString(const std::string& str);
 };
 
+// Bodies within this many differing bits are treated as the same article
+static const int SIMHASH_MAX_DISTANCE = 3;
+
+// Fingerprint used for items.simhash (0 for bodies too short to compare)
+uint64_t ComputeBodySimHash(const std::string& text);
+
+// JSON array of quote texts for the items.quotes_json column
+std::string EncodeQuotesJson(const std::vector<VaultQuote>& quotes);
+
 #endif // DATABASE_H
@@ -0,0 +1,61 @@
+#ifndef FEED_SCHEDULER_H
+#define FEED_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstddef>
+#include "rss_parser.h"
+#include "database.h"
+
+// Decides when each feed is polled. Every feed learns its own publishing
+// gap from the timestamps of the items it delivers and is polled about
+// twice per expected item: busy feeds tighten toward the minimum, feeds
+// that come back empty (or 304) back off geometrically. Higher-priority
+// feeds get proportionally shorter intervals and go first when the hourly
+// byte/connection budget runs short. Feeds coming due close together are
+// fetched in one batch so the radio wakes once instead of once per feed.
+//
+// No I/O here; the caller loads FeedState rows, fetches, and stores them.
+class FeedScheduler {
+public:
+    FeedScheduler();
+    
+    // Interval for a feed with no history yet
+    void SetDefaultInterval(int seconds);
+    // 0 = unlimited
+    void SetBudget(size_t bytesPerHour, int fetchesPerHour);
+    
+    // Indexes into feeds that should be fetched now, most urgent first.
+    // Nothing is returned until at least one enabled feed is actually due
+    std::vector<size_t> GetDueFeeds(const std::vector<FeedConfig>& feeds,
+                                    const std::vector<FeedState>& states, time_t now) const;
+    
+    // Seconds until the earliest enabled feed comes due (0 = due now)
+    int GetSecondsUntilDue(const std::vector<FeedConfig>& feeds,
+                           const std::vector<FeedState>& states, time_t now) const;
+    
+    // Hourly budget; a fetch is charged after it completes
+    bool HasBudget(time_t now);
+    void ChargeFetch(size_t bytes, time_t now);
+    
+    // After a poll: learns from the item dates and sets poll_interval and
+    // next_poll. newItems is how many items the store had not seen before
+    void UpdateSchedule(FeedState& state, const FeedConfig& feed,
+                        const std::vector<time_t>& itemDates, int newItems,
+                        bool success, time_t now) const;
+    
+private:
+    int defaultInterval;
+    size_t bytesPerHour;
+    int fetchesPerHour;
+    
+    // Current budget window
+    time_t windowStart;
+    size_t bytesUsed;
+    int fetchesUsed;
+    
+    int EffectiveInterval(int baseInterval, int priority) const;
+};
+
+#endif // FEED_SCHEDULER_H
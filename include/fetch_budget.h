@@ -0,0 +1,68 @@
+#ifndef FETCH_BUDGET_H
+#define FETCH_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "http_transport.h"
+
+// Limits on the network work done for one query: a wall-clock deadline,
+// body bytes read off the network and requests sent (0 = no limit). The
+// fetches a query runs at once share one budget. Out of time or bytes (or
+// cancelled), queued fetches are dropped, running ones are aborted, and
+// the caller goes on with what has arrived; out of requests, only new
+// requests are refused. Bytes are counted per 16KB chunk, so a fetch may
+// go over by one chunk.
+class FetchBudget {
+public:
+    typedef std::chrono::steady_clock Clock;
+    
+    FetchBudget(int timeMs, uint64_t maxBytes, int maxRequests);
+    
+    // Takes one request; false when the budget is spent
+    bool BeginRequest();
+    
+    // Counts body bytes; false when the fetch must stop reading
+    bool AddBytes(size_t bytes);
+    
+    // Stops everything under this budget, e.g. the answer was closed:
+    // connections attached now are aborted, later requests refused
+    void Cancel();
+    
+    // Out of time or bytes, or cancelled: nothing more may be read
+    bool IsExhausted() const;
+    
+    // The connection a fetch is using, so Cancel can abort it. Detach it
+    // before it goes back to the pool
+    void Attach(HttpConnection* conn);
+    void Detach(HttpConnection* conn);
+    
+    // timeoutSec cut down to the time left (at least a second), so a
+    // stalled read can't outlast the deadline
+    int ClampTimeout(int timeoutSec) const;
+    
+    // Milliseconds to the deadline, -1 when there is none
+    int GetRemainingMs() const;
+    int GetRemainingRequests() const;  // -1 when unlimited
+    
+    uint64_t GetBytesUsed() const { return bytesUsed; }
+    int GetRequestsUsed() const { return requestsUsed; }
+    
+private:
+    bool hasDeadline;
+    Clock::time_point deadline;
+    uint64_t maxBytes;
+    int maxRequests;
+    
+    std::atomic<uint64_t> bytesUsed;
+    std::atomic<int> requestsUsed;
+    std::atomic<bool> cancelled;
+    
+    std::mutex mutex;  // Guards inFlight against Cancel
+    std::vector<HttpConnection*> inFlight;
+};
+
+#endif // FETCH_BUDGET_H
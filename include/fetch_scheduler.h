@@ -0,0 +1,85 @@
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+// Politeness limits per host: a token bucket refilled at requestsPerSecond
+// (bursts up to burst requests) and at most maxActive requests in flight.
+// Shared by every batch, so back-to-back queries stay polite too.
+class HostThrottle {
+public:
+    typedef std::chrono::steady_clock Clock;
+    
+    // requestsPerSecond <= 0 disables the bucket
+    HostThrottle(double requestsPerSecond, int burst, int maxActive);
+    
+    // Takes a token and an in-flight slot for host; when there is none,
+    // retryAt says when to look again
+    bool TryAcquire(const std::string& host, Clock::time_point now, Clock::time_point& retryAt);
+    void Release(const std::string& host);
+    
+private:
+    struct Bucket {
+        double tokens;
+        Clock::time_point refilled;
+        int active;
+    };
+    
+    double requestsPerSecond;
+    int burst;
+    int maxActive;
+    
+    std::mutex mutex;
+    std::map<std::string, Bucket> buckets;
+    
+    void Refill(Bucket& bucket, Clock::time_point now);
+};
+
+// Runs queued work on a fixed set of worker threads (the global
+// concurrency cap). A job whose host is rate-limited waits in the queue
+// while jobs for other hosts go ahead, so a batch spread over several
+// sites takes about as long as its slowest fetch.
+class FetchScheduler {
+public:
+    // throttle may be null (no per-host limits)
+    FetchScheduler(HostThrottle* throttle, int workers);
+    ~FetchScheduler();  // Drops work not yet started and joins the workers
+    
+    void Submit(const std::string& host, const std::function<void()>& work);
+    
+    // Blocks until everything submitted has run
+    void Wait();
+    
+    // Wait() for at most timeoutMs; true when everything has run
+    bool WaitFor(int timeoutMs);
+    
+    // Drops queued work; running jobs finish
+    void Cancel();
+    
+private:
+    struct Job {
+        std::string host;
+        std::function<void()> work;
+    };
+    
+    HostThrottle* throttle;
+    std::vector<std::thread> threads;
+    
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Job> queue;
+    int running;
+    bool stopping;
+    
+    void WorkerLoop();
+};
+
+#endif // FETCH_SCHEDULER_H
@@ -0,0 +1,35 @@
+#ifndef FTS_RANK_H
+#define FTS_RANK_H
+
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <ctime>
+#include "sqlite3.h"
+
+// Domain -> authority multiplier (1.0 = neutral)
+typedef std::map<std::string, float> AuthorityMap;
+
+// Per-item ranking inputs, kept in memory so ranking never reads items rows
+struct RankSignal {
+    time_t published_at;    // 0 = unknown
+    float authority;        // LookupAuthority of the item's domain
+};
+
+// items.rowid -> signals
+typedef std::unordered_map<sqlite3_int64, RankSignal> RankSignalMap;
+
+// Registers the survival_boost() SQL function on db:
+//
+//   survival_boost(rowid, now, half_life_days, recency_weight, authority_strength)
+//
+// It returns a positive multiplier for bm25(): exponential age decay times
+// the authority of the domain (1.0 for rows missing from the map). The map
+// must outlive the connection.
+bool RegisterSurvivalBoost(sqlite3* db, const RankSignalMap* signals);
+
+// Authority lookup that falls back to parent domains
+// ("www.cdc.gov" -> "cdc.gov" -> "gov")
+float LookupAuthority(const AuthorityMap& authority, const std::string& domain);
+
+#endif // FTS_RANK_H
@@ -0,0 +1,73 @@
+#ifndef HTML_TOKENIZER_H
+#define HTML_TOKENIZER_H
+
+#include <string>
+#include <cstddef>
+
+// View into the tokenizer's source buffer (not NUL terminated)
+struct HtmlSpan {
+    const char* data;
+    size_t length;
+    
+    HtmlSpan() : data(nullptr), length(0) {}
+    HtmlSpan(const char* d, size_t l) : data(d), length(l) {}
+    
+    bool Empty() const { return length == 0; }
+    bool Equals(const char* str) const;         // ASCII case-insensitive
+    bool Contains(const char* needle) const;    // ASCII case-insensitive
+    std::string ToString() const { return std::string(data ? data : "", length); }
+};
+
+enum HtmlTokenType {
+    HTML_TEXT,
+    HTML_START_TAG,
+    HTML_END_TAG,
+    HTML_RAW_TEXT  // Body of script/style/noscript/template, possibly in pieces
+};
+
+struct HtmlToken {
+    HtmlTokenType type;
+    HtmlSpan raw;          // Whole token as it appears in the source
+    HtmlSpan name;         // Tag name (tags only)
+    HtmlSpan attributes;   // Everything between the name and '>' (start tags)
+    HtmlSpan text;         // Character data, entities not decoded (text/raw text)
+    bool selfClosing;
+};
+
+// Single-pass pull tokenizer. Tokens are views into the buffer passed in,
+// so nothing is copied; comments, doctypes and processing instructions are
+// skipped, CDATA sections come out as text, and the contents of script,
+// style, noscript and template come out as HTML_RAW_TEXT without being
+// parsed for markup (most consumers just ignore them).
+//
+// For streaming, pass final = false: a tag, comment or text run cut off by
+// the end of the buffer is not emitted, and GetOffset() tells where the
+// unconsumed tail starts. Carry the tail into the next buffer and Reset();
+// raw-text state survives the Reset.
+class HtmlTokenizer {
+public:
+    HtmlTokenizer(const char* data, size_t length, bool final = true);
+    explicit HtmlTokenizer(const std::string& html);
+    
+    // False once the buffer is exhausted (or only a partial token is left)
+    bool Next(HtmlToken& token);
+    
+    void Reset(const char* data, size_t length, bool final);
+    size_t GetOffset() const { return pos; }
+    
+    // Value of attribute `name` on a start tag, quotes stripped
+    static bool GetAttribute(const HtmlToken& token, const char* name, HtmlSpan& value);
+    
+private:
+    const char* data;
+    size_t length;
+    size_t pos;
+    bool final;
+    char rawTag[12];    // Raw-text element being read ("" when none)
+    
+    bool ReadRawText(HtmlToken& token);
+    bool ReadTag(HtmlToken& token);
+    bool ReadText(HtmlToken& token, size_t from);
+};
+
+#endif // HTML_TOKENIZER_H
@@ -0,0 +1,135 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include "http_transport.h"
+
+// Cached response, keyed by canonical URL
+struct CacheEntry {
+    std::string url;           // CanonicalizeUrl form
+    std::string file;          // Hash of the stored bytes, also the file name
+    size_t bodyBytes;          // Decoded size
+    size_t storedBytes;        // gzip size on disk
+    time_t fetchedAt;
+    time_t expiresAt;          // Fresh before this
+    time_t lastUsed;
+    bool complete;             // False when the download stopped early
+    std::string etag;
+    std::string lastModified;
+    
+    CacheEntry() : bodyBytes(0), storedBytes(0), fetchedAt(0), expiresAt(0),
+                   lastUsed(0), complete(true) {}
+    bool IsFresh(time_t now) const { return now < expiresAt; }
+};
+
+struct CacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    
+    CacheStats() : hits(0), misses(0), evictions(0) {}
+};
+
+class HttpCacheWriter;
+
+// Response bodies on disk, gzip-compressed and named by the hash of their
+// bytes, so the same body under several URLs is stored once. The index
+// is an append-only journal replayed on Open and compacted now and then;
+// stored bodies are held to a byte budget by evicting the least recently
+// used entries. Lets pages fetched before a reboot, or while online, be
+// extracted again with no network.
+class HttpCache {
+public:
+    HttpCache();
+    ~HttpCache();
+    
+    bool Open(const std::string& directory, size_t budgetBytes);
+    void Close();
+    bool IsOpen() const { return journal != nullptr; }
+    
+    // Entry for url (any freshness); marks it used
+    bool Lookup(const std::string& url, CacheEntry& entry);
+    
+    // Inflates the stored body to onChunk; false when unreadable (the
+    // entry is dropped) or onChunk stopped early
+    bool ReadBody(const CacheEntry& entry, const ChunkCallback& onChunk);
+    
+    // After a 304: the stored body is current again
+    void Revalidate(const std::string& url, time_t expiresAt, const std::string& etag,
+                    const std::string& lastModified);
+    void Remove(const std::string& url);
+    
+    // Streams a body to a temp file. bodyIsGzip: the bytes written are
+    // already gzip (Content-Encoding: gzip as received), so they are kept
+    // as-is instead of being compressed again
+    HttpCacheWriter* BeginStore(bool bodyIsGzip);
+    
+    // Files the body under entry.url (filling entry.file and storedBytes)
+    // and evicts down to the budget. Both delete the writer
+    bool CommitStore(HttpCacheWriter* writer, CacheEntry& entry);
+    void AbortStore(HttpCacheWriter* writer);
+    
+    // Freshness lifetime from response headers (Cache-Control max-age /
+    // no-cache, then Expires, then 10% of the Last-Modified age up to a
+    // day). False when the response must not be stored (no-store, Vary)
+    static bool ComputeExpiry(const std::string& cacheControl, const std::string& expires,
+                              const std::string& lastModified, const std::string& vary,
+                              time_t now, time_t& expiresAt);
+    
+    size_t GetStoredBytes();
+    size_t GetEntryCount();
+    CacheStats GetStats();
+    
+private:
+    std::string directory;
+    size_t budgetBytes;
+    
+    std::mutex mutex;
+    std::map<std::string, CacheEntry> entries;
+    std::map<std::string, int> fileRefs;  // Entries sharing each body file
+    size_t storedBytes;
+    CacheStats stats;
+    
+    FILE* journal;
+    int journalRecords;
+    unsigned int tempCounter;
+    
+    void Replay(const std::string& line);
+    void AppendRecord(const std::string& line);
+    void WriteEntry(const CacheEntry& entry);
+    void CompactIfNeeded();
+    void AddEntry(const CacheEntry& entry);
+    void DropEntry(const std::string& url, bool removeFile);
+    void EvictToBudget();
+    std::string BodyPath(const std::string& file) const;
+};
+
+// One body being stored; see HttpCache::BeginStore
+class HttpCacheWriter {
+public:
+    // False once the body is past the per-entry limit or the disk failed
+    bool Write(const char* data, size_t length);
+    
+private:
+    friend class HttpCache;
+    
+    HttpCacheWriter(FILE* file, const std::string& tempPath, bool bodyIsGzip);
+    ~HttpCacheWriter();
+    
+    FILE* file;
+    std::string tempPath;
+    void* deflater;        // z_stream when compressing here
+    uint64_t hash;         // FNV-1a of the stored bytes
+    size_t storedBytes;
+    bool failed;
+    
+    bool Put(const char* data, size_t length);
+    bool Finish();
+};
+
+#endif // HTTP_CACHE_H
@@ -0,0 +1,94 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// HTTP headers
+struct HttpHeader {
+    std::string name;
+    std::string value;
+};
+
+// Receives the body as it arrives; return false to stop the download
+typedef std::function<bool(const char* data, size_t length)> ChunkCallback;
+
+// Pieces of an absolute http(s) URL
+struct HttpUrl {
+    std::string scheme;  // Lowercase, "http" or "https"
+    std::string host;    // Lowercase
+    int port;            // Explicit or the scheme default
+    std::string path;    // Path and query, "/" when empty; no fragment
+    
+    HttpUrl() : port(0) {}
+    
+    // "scheme://host:port", the key connections are pooled under
+    std::string Origin() const;
+};
+
+bool ParseHttpUrl(const std::string& url, HttpUrl& out);
+
+struct HttpRequest {
+    std::string method;  // "GET", "HEAD"
+    std::string url;
+    std::vector<HttpHeader> headers;
+    int timeoutSec;  // Send and receive: how long the server may stall
+    
+    HttpRequest() : method("GET"), timeoutSec(30) {}
+};
+
+// One connection to one origin, carrying requests one after another.
+// A request is: SendRequest, any number of ReadBody calls, EndRequest.
+// IsReusable() afterwards says whether another request may follow
+// (the server kept the connection alive and the body was read to the end).
+class HttpConnection {
+public:
+    virtual ~HttpConnection() {}
+    
+    // Sends the request and reads the status line and headers
+    virtual bool SendRequest(const HttpRequest& request, int& statusCode) = 0;
+    
+    // Response header value, "" when absent
+    virtual std::string GetResponseHeader(const char* name) = 0;
+    
+    // Every response header, in order (for recording)
+    virtual void GetResponseHeaders(std::vector<HttpHeader>& headers) = 0;
+    
+    // Declared body length, -1 when unknown
+    virtual int64_t GetContentLength() = 0;
+    
+    // Body bytes into buffer; 0 at the end, negative on error
+    virtual int ReadBody(char* buffer, size_t size) = 0;
+    
+    virtual void EndRequest() = 0;
+    virtual bool IsReusable() const = 0;
+    
+    // Called from another thread: a SendRequest or ReadBody in progress (or
+    // started later) fails at once, and the connection is not reused
+    virtual void Abort() = 0;
+    
+    // Transport error code of the last failure
+    virtual int GetLastError() const = 0;
+};
+
+// Opens connections; the pool decides when
+class HttpTransport {
+public:
+    virtual ~HttpTransport() {}
+    
+    // nullptr on failure with a transport error code in error. timeoutSec
+    // bounds name resolution and connecting
+    virtual HttpConnection* Connect(const HttpUrl& url, int timeoutSec, int& error) = 0;
+};
+
+// Plain HTTP/1.1 over POSIX sockets (no TLS: https URLs fail to connect).
+// Runs the pooling and fetch logic on a Linux host against a local server
+class PosixHttpTransport : public HttpTransport {
+public:
+    HttpConnection* Connect(const HttpUrl& url, int timeoutSec, int& error);
+};
+
+#endif // HTTP_TRANSPORT_H
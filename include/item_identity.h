@@ -0,0 +1,40 @@
+#ifndef ITEM_IDENTITY_H
+#define ITEM_IDENTITY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Normalizes a URL so the same article always maps to the same string:
+// lowercases scheme and host, drops default ports, the fragment and
+// tracking parameters (utm_*, fbclid, gclid, ...), sorts the remaining
+// query parameters and gives an empty path "/"
+std::string CanonicalizeUrl(const std::string& url);
+
+// Item ID: MurmurHash3 x64 128-bit of the canonical URL as 32 hex chars
+// (pc_collector.py computes the same value)
+std::string ComputeItemId(const std::string& url);
+
+void MurmurHash3_x64_128(const void* data, size_t length, uint32_t seed, uint64_t out[2]);
+
+// Fixed-size Bloom filter over strings. False positives only; items can't
+// be removed (deleted IDs stay "maybe present" until the next reload)
+class BloomFilter {
+public:
+    BloomFilter();
+    
+    // Sizes the bit array for expectedItems at the given false positive rate
+    void Reset(size_t expectedItems, double falsePositiveRate);
+    
+    void Add(const std::string& key);
+    bool MightContain(const std::string& key) const;
+    size_t GetCount() const { return count; }
+    
+private:
+    std::vector<uint64_t> bits;
+    uint64_t bitCount;
+    int hashCount;
+    size_t count;
+};
+
+#endif // ITEM_IDENTITY_H
@@ -3,9 +3,57 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#ifdef __vita__
 #include <psp2/net/net.h>
 #include <psp2/net/netctl.h>
 #include <psp2/net/http.h>
+#endif
+#include "http_transport.h"
+#include "connection_pool.h"
+#include "fetch_scheduler.h"
+#include "http_cache.h"
+#include "circuit_breaker.h"
+#include "fetch_budget.h"
+
+// Validators from an earlier 200 response, sent back as If-None-Match /
+// If-Modified-Since so an unchanged resource costs a 304 instead of a body
+struct HttpValidators {
+    std::string etag;
+    std::string lastModified;
+    size_t bodyBytes;  // Size of that response, counted as saved on a 304
+    
+    HttpValidators() : bodyBytes(0) {}
+    bool Empty() const { return etag.empty() && lastModified.empty(); }
+};
+
+// Persistent validator storage (the vault database in the app); called
+// from several fetch workers at once, so it must be thread-safe
+typedef std::function<bool(const std::string& url, HttpValidators& validators)> ValidatorLookup;
+typedef std::function<void(const std::string& url, const HttpValidators& validators)> ValidatorUpdate;
+
+// Transfer counters since startup
+struct NetStats {
+    uint64_t requests;
+    uint64_t notModified;  // 304 responses
+    uint64_t bytesRead;    // Body bytes received (compressed, as sent)
+    uint64_t bytesDecoded; // Body bytes after decompression
+    uint64_t bytesSaved;   // Body bytes a 304 spared us
+    uint64_t connectionsOpened;
+    uint64_t connectionsReused;  // Requests that skipped the handshakes
+    uint64_t cacheHits;          // Bodies served from the on-disk cache
+    uint64_t retries;            // Extra attempts after transient failures
+    uint64_t hostRejections;     // Requests refused by an open host circuit
+    uint64_t budgetStops;        // Fetches not sent or cut short by a query's budget
+    
+    NetStats() : requests(0), notModified(0), bytesRead(0), bytesDecoded(0), bytesSaved(0),
+                 connectionsOpened(0), connectionsReused(0), cacheHits(0), retries(0),
+                 hostRejections(0), budgetStops(0) {}
+};
 
 // Network result structure
 struct FetchResult {
@@ -14,21 +62,29 @@ struct FetchResult {
     int statusCode;
     bool success;
     std::string error;
+    size_t bytesRead;     // Body bytes off the network
+    size_t bytesDecoded;  // Body bytes handed to the caller (after gzip/deflate)
+    bool stoppedEarly;  // Chunk callback asked to stop; html is partial
+    bool truncated;     // Cut off at the body size cap; html is partial
+    bool notModified;   // 304 to a conditional fetch: the stored copy is current, no body
+    bool fromCache;     // Body came from the HTTP cache (fresh, revalidated, or offline)
+    bool overBudget;    // The FetchBudget ran out first; any body is partial
+    HttpValidators validators;  // ETag / Last-Modified of this response
 };
 
-// HTTP headers
-struct HttpHeader {
-    std::string name;
-    std::string value;
-};
+// Batch callbacks, called on a worker thread with the URL's index
+typedef std::function<void(size_t index)> FetchWork;
+typedef std::function<void(size_t index, const FetchResult& result)> FetchCallback;
 
 class NetFetcher {
 public:
     NetFetcher();
     ~NetFetcher();
     
-    // Initialization
-    bool Initialize();
+    // Initialization. Without a transport, sceHttp is used (POSIX sockets
+    // in host builds); any other transport (a recorder, a replay archive)
+    // must outlive the fetcher
+    bool Initialize(HttpTransport* customTransport = nullptr);
     void Shutdown();
     
     // Connectivity
@@ -36,39 +92,108 @@ public:
     bool CheckWiFiConnection();
     std::string GetConnectionType();
     
-    // HTTP operations
-    FetchResult FetchURL(const std::string& url, int timeoutSec = 30);
+    // HTTP operations. A conditional fetch sends the validators stored for
+    // the URL; callers must cope with notModified (success, empty body).
+    // timeoutSec bounds each send and receive (how long the server may
+    // stall); connecting has its own, shorter deadline (SetConnectTimeout).
+    // Connect/send failures, 5xx and 429 are retried with backoff.
+    // Under a budget every attempt takes a request from it, timeouts are cut
+    // to its deadline, and reading stops (overBudget) when it runs out
+    FetchResult FetchURL(const std::string& url, int timeoutSec = 30, bool conditional = false,
+                         FetchBudget* budget = nullptr);
+    
+    // Streams the body to onChunk in 16KB pieces instead of buffering it
+    // (result.html stays empty). gzip/deflate bodies are inflated on the fly
+    FetchResult FetchURLStreaming(const std::string& url, const ChunkCallback& onChunk,
+                                  int timeoutSec = 30, bool conditional = false,
+                                  FetchBudget* budget = nullptr);
     FetchResult FetchWithHeaders(const std::string& url, 
                                  const std::vector<HttpHeader>& headers,
                                  int timeoutSec = 30);
     
-    // Batch operations
+    // Batch operations. Up to maxConcurrent fetches run at once; each host
+    // is held to a few requests per second, so other hosts go ahead while
+    // one is throttled. Results come back in input order, and onComplete
+    // sees each one as soon as it finishes
     std::vector<FetchResult> FetchMultiple(const std::vector<std::string>& urls,
-                                          int maxConcurrent = 3);
+                                          int maxConcurrent = 3,
+                                          const FetchCallback& onComplete = FetchCallback());
+    
+    // Same scheduling for callers doing their own fetch per URL (streaming
+    // extraction); returns once work has run for every index. Once budget
+    // is exhausted, indexes still queued are dropped without running work
+    void RunFetches(const std::vector<std::string>& urls, int maxConcurrent, const FetchWork& work,
+                    FetchBudget* budget = nullptr);
+    
+    // Where conditional fetches keep their validators
+    void SetValidatorStore(const ValidatorLookup& lookup, const ValidatorUpdate& update);
+    
+    // Response cache consulted before the network (plain GETs only). Fresh
+    // entries need no request, stale ones are revalidated, and any entry is
+    // served when the network is down. Must outlive the fetcher
+    void SetCache(HttpCache* httpCache);
     
     // Settings
     void SetUserAgent(const std::string& ua);
     void SetTimeout(int seconds);
-    void SetMaxRetries(int retries);
+    void SetConnectTimeout(int seconds);
+    void SetMaxRetries(int retries);  // Attempts after the first one
     
     // Status
     bool IsInitialized() const { return initialized; }
     int GetLastError() const { return lastError; }
+    NetStats GetStats();
+    
+    // Drops kept-alive connections, e.g. before the radio goes idle
+    void CloseIdleConnections();
     
 private:
     bool initialized;
     int netMemId;
     int httpMemId;
-    int lastError;
+    std::atomic<int> lastError;  // Set by whichever fetch worker failed last
     
     std::string userAgent;
     int timeoutSeconds;
+    int connectTimeoutSeconds;
     int maxRetries;
     
+    ValidatorLookup validatorLookup;
+    ValidatorUpdate validatorUpdate;
+    
+    HttpCache* cache;
+    
+    // Fetches run on the feed refresher and the Ask thread
+    std::mutex statsMutex;
+    NetStats stats;
+    std::minstd_rand retryJitter;  // Also under statsMutex
+    
+    // Keep-alive connections per host, shared by all fetches
+    HttpTransport* transport;
+    bool ownsTransport;
+    ConnectionPool* pool;
+    
+    // Per-host politeness across all batches
+    HostThrottle hostThrottle;
+    
+    // Hosts that keep failing are skipped for a while
+    CircuitBreaker breaker;
+    
     // HTTP helpers
-    int CreateHTTPTemplate(const std::string& url, const char* method);
-    bool ReadResponse(int connId, std::string& outHtml);
-    void CleanupHTTP(int tmplId, int connId, int reqId);
+    FetchResult Fetch(const std::string& url, int timeoutSec, const std::vector<HttpHeader>& headers,
+                      bool conditional, const ChunkCallback& onChunk, FetchBudget* budget);
+    HttpConnection* OpenRequest(const HttpUrl& target, const HttpRequest& request,
+                                int connectTimeoutSec, FetchBudget* budget, FetchResult& result,
+                                bool& hostFailed);
+    void ReleaseConnection(HttpConnection* conn, const HttpUrl& target, bool keep,
+                           FetchBudget* budget);
+    int GetRetryDelayMs(int attempt, HttpConnection* conn);
+    bool ReadResponse(HttpConnection* conn, const ChunkCallback& onChunk, HttpCacheWriter* store,
+                      FetchBudget* budget, FetchResult& result);
+    bool ServeFromCache(const CacheEntry& entry, const ChunkCallback& onChunk, FetchResult& result);
+    bool GetCacheExpiry(HttpConnection* conn, time_t now, time_t& expiresAt);
+    void ReadValidators(HttpConnection* conn, FetchResult& result);
+    void CountTransfer(const FetchResult& result, size_t bytesSaved);
     
     // Network module management
     bool InitNetModules();
@@ -3,10 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
 #include "net_fetcher.h"
 #include "rss_parser.h"
 #include "content_extractor.h"
 #include "database.h"
+#include "feed_scheduler.h"
 
 // Online search result
 struct OnlineResult {
@@ -25,6 +29,13 @@ struct OnlineSearchSettings {
     int timeoutSeconds;
     bool saveAutomatically;
     int cacheSizeLimitMB;
+    int feedRefreshMinutes;   // First poll interval; each feed then adapts to how often it publishes
+    int feedBudgetKBPerHour;  // Feed download budget (0 = unlimited)
+    int feedFetchesPerHour;   // Feed connection budget (0 = unlimited)
+    int feedItemMaxAgeDays;   // Stored feed items older than this are pruned
+    int searchBudgetSeconds;  // Per query: time spent fetching pages (0 = unlimited)
+    int searchBudgetKB;       // Per query: page bytes downloaded (0 = unlimited)
+    int searchBudgetRequests; // Per query: requests sent, retries included (0 = unlimited)
     std::vector<std::string> enabledFeeds;
 };
 
@@ -36,17 +47,36 @@ public:
     void Initialize(NetFetcher* net, RSSParser* rss, 
                    ContentExtractor* extractor, Database* db);
     
-    // Main online search flow
+    // Main online search flow, held to the per-query budget in the settings
     bool SearchAndSave(const std::string& query, std::vector<VaultItem>& outItems);
     
-    // Component operations
-    std::vector<OnlineResult> SearchRSSFeeds(const std::string& query, int limit = 10);
-    bool FetchAndExtract(const std::string& url, VaultItem& outItem);
+    // That per-query budget, for callers that need to cancel it (caller deletes)
+    FetchBudget* CreateSearchBudget() const;
+    
+    // Same under the caller's budget. When it runs out, fetches in flight
+    // are stopped and the pages that made it in are saved and returned
+    bool SearchAndSave(const std::string& query, std::vector<VaultItem>& outItems,
+                       FetchBudget& budget);
+    
+    // Component operations; feed search reads the local feed store only
+    // (nothing is returned once budget is exhausted)
+    std::vector<OnlineResult> SearchRSSFeeds(const std::string& query, int limit = 10,
+                                             FetchBudget* budget = nullptr);
+    bool FetchAndExtract(const std::string& url, VaultItem& outItem,
+                         FetchBudget* budget = nullptr);
     bool SaveToVault(const VaultItem& item);
     
     // Batch operations
     bool FetchMultipleAndSave(const std::vector<std::string>& urls, 
-                             std::vector<VaultItem>& outItems);
+                             std::vector<VaultItem>& outItems,
+                             FetchBudget* budget = nullptr);
+    
+    // Feed store refresh: a background thread re-downloads feeds as they
+    // come due, so Ask never waits on a feed download. force fetches every
+    // enabled feed regardless of schedule and budget
+    bool StartFeedRefresh();
+    void StopFeedRefresh();
+    int RefreshFeeds(bool force = false);  // Returns feeds fetched
     
     // Settings
     void LoadSettings(const std::string& configPath);
@@ -72,9 +102,26 @@ private:
     
     OnlineSearchSettings settings;
     
+    // Background feed refresh
+    std::thread refreshThread;
+    std::atomic<bool> refreshCancel;
+    std::mutex refreshMutex;  // One refresh pass at a time; guards scheduler
+    FetchBudget* refreshBudget;  // No limits; cancelled to stop fetches in flight
+    FeedScheduler scheduler;
+    
+    void RefreshLoop();
+    bool RefreshFeed(const FeedConfig& feed);
+    std::vector<FeedState> LoadFeedStates(const std::vector<FeedConfig>& feeds);
+    int GetSecondsUntilRefresh();
+    
+    // Fetches, extracts and saves up to limit new items
+    void FetchAndSaveAll(const std::vector<std::string>& urls, int limit,
+                         std::vector<VaultItem>& outItems, FetchBudget* budget);
+    
     // Deduplication
     bool IsDuplicate(const VaultItem& item);
-    std::string GenerateItemHash(const std::string& url, const std::string& title, time_t published);
+    std::string GenerateItemHash(const std::string& url);
+    bool IsKnownUrl(const std::string& url);
     
     // Filtering
     std::vector<OnlineResult> FilterAndRank(const std::vector<OnlineResult>& results,
@@ -82,8 +129,7 @@ private:
     float CalculateRelevance(const OnlineResult& result, const std::string& query);
     
     // RSS search
-    std::vector<OnlineResult> SearchFeed(const FeedConfig& feed, const std::string& query);
-    bool FeedItemMatches(const RSSItem& item, const std::string& query);
+    bool FeedItemMatches(const FeedItem& item, const std::string& query);
 };
 
 #endif // ONLINE_SEARCH_H
@@ -0,0 +1,53 @@
+#ifndef PAGE_METADATA_H
+#define PAGE_METADATA_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstddef>
+
+// Dates as they appear in meta tags, JSON-LD and feeds: ISO 8601
+// ("2024-06-15", "2024-06-15T10:30:00.000+02:00"), RFC 822 ("Sat, 15 Jun
+// 2024 10:30:00 GMT") and "June 15, 2024". Returns UTC seconds, or 0 when
+// the text is not a date. Works in place, nothing is allocated.
+time_t ParseWebDate(const char* text, size_t length);
+time_t ParseWebDate(const std::string& text);
+
+// Structured metadata gathered while the page is tokenized: <meta> tags
+// keyed by their lowercase property/name/itemprop ("og:title", "author"),
+// <link> tags as "link:<rel>", <time datetime> as "time:datetime", and the
+// first Article-typed JSON-LD object as "ld:<field>". The first value for a
+// key wins, so head tags take precedence over repeats in the body.
+class PageMetadata {
+public:
+    PageMetadata();
+    
+    // Value is entity-decoded and collapsed to one line
+    void Set(const char* key, size_t keyLength, const char* value, size_t valueLength);
+    void Set(const std::string& key, const std::string& value);
+    
+    // "" when absent
+    const std::string& Get(const char* key) const;
+    bool Has(const char* key) const { return !Get(key).empty(); }
+    size_t GetCount() const { return entries.size(); }
+    
+    // Body of a <script type="application/ld+json">; false when it held no article
+    bool AddJsonLd(const char* json, size_t length);
+    
+    std::string GetTitle() const;
+    std::string GetAuthor() const;
+    time_t GetPublishDate() const;
+    
+private:
+    struct Entry {
+        std::string key;  // Lowercase
+        std::string value;
+    };
+    
+    std::vector<Entry> entries;
+    bool hasArticle;  // Article JSON-LD already recorded
+    
+    friend class JsonLdReader;
+};
+
+#endif // PAGE_METADATA_H
@@ -0,0 +1,122 @@
+#ifndef REPLAY_TRANSPORT_H
+#define REPLAY_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+#include "http_transport.h"
+
+// One HTTP exchange as it went over the wire
+struct RecordedResponse {
+    std::string method;
+    std::string url;
+    int statusCode;
+    std::vector<HttpHeader> headers;
+    std::string body;   // As received: still gzip/deflate encoded
+    bool complete;      // False when the client stopped reading early
+    int connectMs;      // Connection setup (0 on a kept-alive connection)
+    int firstByteMs;    // Request sent to status and headers in
+    int totalMs;        // Request sent to end of body
+    
+    RecordedResponse() : statusCode(0), complete(false), connectMs(0), firstByteMs(0),
+                         totalMs(0) {}
+};
+
+// Archive of recorded exchanges, one per method and URL. The file is a
+// sequence of records (REQUEST, STATUS, HEADER lines, then the raw BODY
+// bytes) that recorders append to; on load a later record replaces an
+// earlier one for the same request, except that a body read to the end
+// is never replaced by a partial one.
+class HttpArchive {
+public:
+    bool Load(const std::string& path);
+    
+    // nullptr when the request was never recorded
+    const RecordedResponse* Find(const std::string& method, const std::string& url) const;
+    size_t GetCount() const { return responses.size(); }
+    
+    // Appends to an open archive file (the header goes first in an empty one)
+    static bool Write(FILE* file, const RecordedResponse& response);
+    
+private:
+    std::map<std::string, RecordedResponse> responses;  // "METHOD url"
+};
+
+// Wraps a live transport and appends every response read through it to an
+// archive, with its timings. 304s are not recorded: the replay transport
+// answers conditional requests itself.
+class RecordingHttpTransport : public HttpTransport {
+public:
+    RecordingHttpTransport(HttpTransport* inner, const std::string& archivePath);
+    ~RecordingHttpTransport();
+    
+    bool IsOpen() const { return file != nullptr; }
+    HttpConnection* Connect(const HttpUrl& url, int timeoutSec, int& error);
+    
+    size_t GetRecordedCount();
+    
+    // Called by the connections as each request ends
+    void Save(const RecordedResponse& response);
+    
+private:
+    HttpTransport* inner;
+    std::mutex mutex;
+    FILE* file;
+    size_t recorded;
+};
+
+// Network conditions for a replay. With recorded timings each request
+// waits as long as it did when recorded; otherwise latencyMs is charged
+// per connection and per request. bytesPerSecond (0 = unlimited) paces
+// the body in both cases.
+struct ReplayProfile {
+    bool recordedTimings;
+    int latencyMs;
+    int bytesPerSecond;
+    
+    ReplayProfile() : recordedTimings(false), latencyMs(0), bytesPerSecond(0) {}
+};
+
+struct ReplayStats {
+    uint64_t served;       // Recorded responses replayed
+    uint64_t notModified;  // Conditional requests answered with a 304
+    uint64_t missing;      // Requests not in the archive (answered 404)
+    
+    ReplayStats() : served(0), notModified(0), missing(0) {}
+};
+
+// Serves an archive instead of the network, so the online pipeline runs
+// the same way every time on a host with no connection. A conditional
+// request whose ETag / Last-Modified match the recorded response gets a
+// 304; an unrecorded one gets a 404. A body recorded partially fails when
+// read past its end.
+class ReplayHttpTransport : public HttpTransport {
+public:
+    static const int REPLAY_ERROR_TRUNCATED = -2;
+    static const int REPLAY_ERROR_ABORTED = -3;
+    
+    ReplayHttpTransport();
+    
+    bool Load(const std::string& archivePath);
+    void SetProfile(const ReplayProfile& profile);
+    
+    HttpConnection* Connect(const HttpUrl& url, int timeoutSec, int& error);
+    
+    ReplayStats GetStats();
+    
+    // Used by the connections
+    const RecordedResponse* Find(const HttpRequest& request, bool& notModified);
+    ReplayProfile GetProfile() const { return profile; }
+    
+private:
+    HttpArchive archive;
+    ReplayProfile profile;
+    
+    std::mutex mutex;
+    ReplayStats stats;
+};
+
+#endif // REPLAY_TRANSPORT_H
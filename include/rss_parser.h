@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include "html_tokenizer.h"
 
 // RSS feed item
 struct RSSItem {
@@ -38,7 +39,8 @@ public:
     RSSParser();
     ~RSSParser();
     
-    // Parse RSS/Atom feeds
+    // Parse RSS/Atom feeds (the format is taken from the root element, so
+    // these accept either; kept for callers that already know the format)
     bool ParseRSS(const std::string& xmlContent, RSSFeed& outFeed);
     bool ParseAtom(const std::string& xmlContent, RSSFeed& outFeed);
     
@@ -59,14 +61,72 @@ public:
     std::vector<FeedConfig> GetFeedsByCategory(const std::string& category);
     
 private:
+    friend class FeedStream;
+    
     std::vector<FeedConfig> feeds;
     
-    // XML parsing helpers
-    std::string ExtractTag(const std::string& xml, const std::string& tag);
-    std::vector<std::string> ExtractAllTags(const std::string& xml, const std::string& tag);
+    // Field text helpers
     std::string StripTags(const std::string& html);
     time_t ParseRFC822Date(const std::string& dateStr);
     time_t ParseISO8601Date(const std::string& dateStr);
 };
 
+// Single-pass pull parser for RSS 0.9x/2.0, RSS 1.0 (RDF) and Atom. Items are
+// filled in place as their elements close, and the XML can arrive in chunks,
+// so a feed is parsed while it downloads without keeping the document.
+// Namespaced elements are matched by namespace URI, not by whatever prefix
+// the feed declared ("dc:creator" works when the feed calls it "d:creator").
+class FeedStream {
+public:
+    FeedStream(RSSParser* parser, RSSFeed& feed);
+    
+    void Feed(const char* data, size_t length);
+    
+    // Flushes the held-back tail; false when the feed had no items
+    bool Finish();
+    
+private:
+    enum FeedFormat {
+        FORMAT_UNKNOWN,
+        FORMAT_RSS,
+        FORMAT_ATOM,
+        FORMAT_OTHER  // Root element is not a feed; everything is ignored
+    };
+    
+    // xmlns:prefix declaration mapped to the prefix we match against
+    struct Namespace {
+        std::string prefix;
+        const char* alias;
+    };
+    
+    RSSParser* parser;
+    RSSFeed& feed;
+    HtmlTokenizer tokenizer;
+    std::string carry;  // Partial token left over from the previous chunk
+    std::vector<Namespace> namespaces;
+    FeedFormat format;
+    
+    // Element depths (0 = not inside one)
+    int depth;
+    int channelDepth;
+    int itemDepth;
+    int authorDepth;
+    
+    // Element whose text is being collected
+    int fieldDepth;
+    std::string* fieldText;
+    time_t* fieldDate;
+    bool fieldFallback;  // Date only used when no better one was seen
+    std::string text;
+    
+    void Consume(const char* data, size_t length, bool final);
+    void ConsumeToken(const HtmlToken& token);
+    void StartElement(const HtmlToken& token, int level);
+    void StartItemElement(const HtmlToken& token, const char* name, int level);
+    void StartField(int level, std::string* target, time_t* date, bool fallback);
+    void EndField();
+    void ReadNamespaces(const HtmlToken& token);
+    void QualifiedName(const HtmlSpan& name, char* buffer, size_t size) const;
+};
+
 #endif // RSS_PARSER_H
@@ -62,6 +62,7 @@ struct QueryAnalysis {
 
 class OnlineSearch; // Forward declaration
 class LLMEngine; // Forward declaration
+class AnswerStream; // Forward declaration
 
 class SearchEngine {
 public:
@@ -77,6 +78,10 @@ public:
     Answer AskOffline(const std::string& query);
     Answer AskOnline(const std::string& query);
     
+    // Progressive mode: publishes sources/summary, LLM tokens and the final
+    // answer to the stream as each stage completes (run on a worker thread)
+    Answer AskStreaming(const std::string& query, AnswerStream& stream);
+    
     // Component searches
     std::vector<SearchResult> SearchVault(const std::string& query, int limit = 10);
     std::vector<ZIMSearchResult> SearchWikipedia(const std::string& query, int limit = 10);
@@ -89,11 +94,17 @@ public:
     // LLM-enhanced answer generation
     Answer GenerateAnswerWithLLM(const std::string& query,
                                 const QueryAnalysis& analysis,
-                                const std::vector<SearchResult>& results);
+                                const std::vector<SearchResult>& results,
+                                AnswerStream* stream = nullptr);
     
     // Intent detection
     QueryAnalysis AnalyzeQuery(const std::string& query);
     
+    // Pre-materialized answers (Scenarios/Manuals): one indexed read, no
+    // search and no LLM at runtime
+    bool GetMaterializedAnswer(const std::string& key, Answer& outAnswer);
+    bool MaterializeAnswer(const std::string& key, const std::string& query);
+    
 private:
     Database* database;
     ZIMReader* zimReader;
@@ -110,6 +121,10 @@ private:
     Answer BuildSummaryAnswer(const QueryAnalysis& analysis,
                              const std::vector<SearchResult>& results);
     
+    // MMR re-ranking: keeps the best `limit` results that are not
+    // near-copies of each other (syndicated wire stories etc.)
+    void DiversifyResults(std::vector<SearchResult>& results, int limit);
+    
     // Helpers
     std::vector<std::string> ExtractKeywords(const std::string& query);
     float CalculateRelevance(const std::string& query, const std::string& text);
@@ -121,4 +136,8 @@ private:
     bool MatchesWhatPattern(const std::string& query);
 };
 
+// Compact binary encoding of Answer for the answers table
+std::string SerializeAnswer(const Answer& answer);
+bool DeserializeAnswer(const std::string& blob, Answer& outAnswer);
+
 #endif // SEARCH_ENGINE_H
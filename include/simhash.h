@@ -0,0 +1,21 @@
+#ifndef SIMHASH_H
+#define SIMHASH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 64-bit SimHash over lowercase words: near-identical texts differ in only
+// a few bits, unrelated texts in about half of them
+uint64_t ComputeSimHash(const std::string& text);
+int HammingDistance(uint64_t a, uint64_t b);
+
+// 0..1 similarity from two fingerprints (>= 32 differing bits counts as 0)
+float SimHashSimilarity(uint64_t a, uint64_t b);
+
+// Sorted, de-duplicated hashes of lowercase word bigrams (single word
+// texts fall back to that word) for cheap Jaccard comparisons of titles
+std::vector<uint32_t> WordShingles(const std::string& text);
+float ShingleJaccard(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+#endif // SIMHASH_H
@@ -18,6 +18,10 @@
 #define CACHE_PATH DATA_PATH "cache/"
 #define VOICE_PATH DATA_PATH "voice/"
 
+// Fetched pages and feeds kept for offline re-reads
+#define HTTP_CACHE_PATH CACHE_PATH "http/"
+#define HTTP_CACHE_BUDGET_BYTES (32 * 1024 * 1024)
+
 // Screen dimensions
 #define SCREEN_WIDTH 960
 #define SCREEN_HEIGHT 544
@@ -51,6 +55,7 @@ class ZIMReader;
 class SearchEngine;
 class VoiceSystem;
 class NetFetcher;
+class HttpCache;
 class RSSParser;
 class ContentExtractor;
 class OnlineSearch;
@@ -67,6 +72,7 @@ struct AppContext {
     
     // Online components
     NetFetcher* netFetcher;
+    HttpCache* httpCache;
     RSSParser* rssParser;
     ContentExtractor* extractor;
     OnlineSearch* onlineSearch;
@@ -0,0 +1,23 @@
+#ifndef TEXT_NORMALIZE_H
+#define TEXT_NORMALIZE_H
+
+#include <string>
+#include <cstddef>
+
+enum TextNormalizeFlags {
+    TEXT_DECODE_ENTITIES = 1,  // &amp; &#8217; &nbsp; ... -> UTF-8
+    TEXT_COLLAPSE_SPACE = 2,   // Whitespace runs (incl. U+00A0) -> one ' '
+    TEXT_KEEP_NEWLINES = 4     // ...or one '\n' when the run contained one
+};
+
+// Appends data to out in one pass: decodes entities, collapses whitespace
+// and replaces invalid UTF-8 with U+FFFD. Collapsing continues across calls
+// (no leading space when out already ends in whitespace), so text can be
+// appended piece by piece. Plain runs are found 16 bytes at a time with
+// SSE2 or NEON when available.
+void AppendNormalizedText(std::string& out, const char* data, size_t length, int flags);
+
+// Whole-string form; also trims surrounding whitespace when collapsing
+std::string NormalizeText(const std::string& text, int flags);
+
+#endif // TEXT_NORMALIZE_H
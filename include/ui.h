@@ -3,10 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <thread>
 #include <vita2d.h>
 #include <psp2/ime_dialog.h>
 #include "survival_ai.h"
 #include "search_engine.h"
+#include "answer_stream.h"
+
+struct CuratedQuestion;
 
 // UI Screen types
 enum UIScreen {
@@ -61,6 +65,14 @@ public:
     void DisplayAnswer(const Answer& answer);
     void ClearAnswer();
     
+    // Progressive asking (search runs on a worker thread)
+    void StartAsk(const std::string& query);
+    void CancelAsk();
+    bool IsAskInFlight() const { return askInFlight; }
+    
+    // Scenarios/Manuals: materialized answer, live search as fallback
+    void OpenCuratedQuestion(const CuratedQuestion& entry);
+    
     // Lists
     void SetListItems(const std::vector<std::string>& items);
     int GetSelectedIndex() const { return selectedIndex; }
@@ -92,6 +104,15 @@ private:
     Answer* currentAnswer;
     int answerScrollPos;
     
+    // In-flight ask: the worker owns the search engine and database until
+    // the final event arrives, so the UI must not query them meanwhile
+    AnswerStream answerStream;
+    std::thread askThread;
+    bool askInFlight;
+    bool answerHasTokens;
+    
+    void PumpAnswerStream();
+    
     // Notifications
     std::string notification;
     float notificationTimer;
@@ -0,0 +1,24 @@
+#ifndef VITA_TRANSPORT_H
+#define VITA_TRANSPORT_H
+
+#include <string>
+#include <mutex>
+#include "http_transport.h"
+
+// sceHttp connections with keep-alive on, all made from one shared
+// template (created on first use, deleted with the transport, so delete
+// every connection first). HTTPS goes through the system TLS stack.
+class VitaHttpTransport : public HttpTransport {
+public:
+    explicit VitaHttpTransport(const std::string& userAgent);
+    ~VitaHttpTransport();
+    
+    HttpConnection* Connect(const HttpUrl& url, int timeoutSec, int& error);
+    
+private:
+    std::string userAgent;
+    int tmplId;
+    std::mutex tmplMutex;
+};
+
+#endif // VITA_TRANSPORT_H
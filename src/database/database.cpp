@@ -1,10 +1,196 @@
 #include "database.h"
+#include "simhash.h"
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <map>
+#include <cstdlib>
+#include <cctype>
+
+// NULL-safe text column read (packs built by pc_collector.py leave
+// optional columns NULL)
+static std::string ColumnText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+// PRAGMA user_version of a vault: one-off upgrades already applied to it
+static const int VAULT_VERSION_QUOTES = 1;  // quotes table filled from quotes_json
+
+static int GetUserVersion(sqlite3* db) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    int version = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+static bool SetUserVersion(sqlite3* db, int version) {
+    std::string sql = "PRAGMA user_version = " + std::to_string(version);
+    return sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+// Explicit column list so appended columns never shift the rank column
+#define ITEM_COLUMNS \
+    "items.id, items.title, items.url, items.source_domain, items.author, " \
+    "items.published_at, items.retrieved_at, items.topic_tags, items.text_snippet, " \
+    "items.text_clean, items.quotes_json, items.language, items.content_type, " \
+    "items.license_note, items.steps, items.warnings, items.bullets, items.simhash"
+static const int ITEM_COLUMN_COUNT = 18;
+
+// What reranking needs from a search hit; bodies are loaded for the picks only
+#define CANDIDATE_COLUMNS \
+    "items.id, items.title, items.source_domain, items.published_at, " \
+    "items.text_snippet, items.simhash"
+static const int CANDIDATE_COLUMN_COUNT = 6;
+
+// bm25() weights in items_fts order:
+// title, text_snippet, text_clean, quotes_json, topic_tags
+#define FTS_COLUMN_WEIGHTS "10.0, 3.0, 1.0, 2.0, 5.0"
+
+// 64-bit fingerprint split into 4 x 16-bit bands; band_key = band << 16 | bits
+static const int SIMHASH_BANDS = 4;
+// Shorter bodies (stubs, paywalls) fingerprint too similarly to compare
+static const size_t SIMHASH_MIN_TEXT = 200;
+
+static sqlite3_int64 SimHashBandKey(uint64_t simhash, int band) {
+    return ((sqlite3_int64)band << 16) | (sqlite3_int64)((simhash >> (band * 16)) & 0xFFFF);
+}
+
+// Structured list columns are stored newline-separated
+static std::string JoinLines(const std::vector<std::string>& lines) {
+    std::string joined;
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (i > 0) joined += '\n';
+        joined += lines[i];
+    }
+    return joined;
+}
+
+static std::vector<std::string> SplitLines(const std::string& text) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < text.length()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.length();
+        if (end > start) lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+uint64_t ComputeBodySimHash(const std::string& text) {
+    if (text.length() < SIMHASH_MIN_TEXT) return 0;
+    return ComputeSimHash(text);
+}
+
+std::string EncodeQuotesJson(const std::vector<VaultQuote>& quotes) {
+    std::string json = "[";
+    for (size_t i = 0; i < quotes.size(); i++) {
+        if (i > 0) json += ",";
+        json += "\"";
+        for (char c : quotes[i].text) {
+            switch (c) {
+                case '"': json += "\\\""; break;
+                case '\\': json += "\\\\"; break;
+                case '\n': json += "\\n"; break;
+                case '\t': json += "\\t"; break;
+                case '\r': break;
+                default: json += c; break;
+            }
+        }
+        json += "\"";
+    }
+    json += "]";
+    return json;
+}
+
+// Reads a JSON array of strings (quotes_json written by older builds and
+// pc_collector.py); surrogate-pair \u escapes are dropped
+static std::vector<std::string> DecodeQuotesJson(const std::string& json) {
+    std::vector<std::string> quotes;
+    size_t i = json.find('[');
+    if (i == std::string::npos) return quotes;
+    
+    while (i < json.length()) {
+        size_t open = json.find('"', i);
+        if (open == std::string::npos) break;
+        
+        std::string text;
+        size_t j = open + 1;
+        for (; j < json.length() && json[j] != '"'; j++) {
+            if (json[j] != '\\' || j + 1 >= json.length()) {
+                text += json[j];
+                continue;
+            }
+            char e = json[++j];
+            if (e == 'n') text += '\n';
+            else if (e == 't') text += '\t';
+            else if (e == 'u' && j + 4 < json.length()) {
+                int code = (int)strtol(json.substr(j + 1, 4).c_str(), nullptr, 16);
+                if (code > 0 && code < 0x80) {
+                    text += (char)code;
+                } else if (code >= 0x80 && code < 0x800) {
+                    text += (char)(0xC0 | (code >> 6));
+                    text += (char)(0x80 | (code & 0x3F));
+                } else if (code >= 0x800 && (code < 0xD800 || code > 0xDFFF)) {
+                    text += (char)(0xE0 | (code >> 12));
+                    text += (char)(0x80 | ((code >> 6) & 0x3F));
+                    text += (char)(0x80 | (code & 0x3F));
+                }
+                j += 4;
+            }
+            else text += e;
+        }
+        
+        if (!text.empty()) quotes.push_back(text);
+        i = j + 1;
+    }
+    return quotes;
+}
+
+// Reads the ITEM_COLUMNS starting at column 0
+static void ReadItemRow(sqlite3_stmt* stmt, VaultItem& item) {
+    item.id = ColumnText(stmt, 0);
+    item.title = ColumnText(stmt, 1);
+    item.url = ColumnText(stmt, 2);
+    item.source_domain = ColumnText(stmt, 3);
+    item.author = ColumnText(stmt, 4);
+    item.published_at = sqlite3_column_int64(stmt, 5);
+    item.retrieved_at = sqlite3_column_int64(stmt, 6);
+    item.topic_tags = ColumnText(stmt, 7);
+    item.text_snippet = ColumnText(stmt, 8);
+    item.text_clean = ColumnText(stmt, 9);
+    item.quotes_json = ColumnText(stmt, 10);
+    item.language = ColumnText(stmt, 11);
+    item.content_type = ColumnText(stmt, 12);
+    item.license_note = ColumnText(stmt, 13);
+    item.steps = SplitLines(ColumnText(stmt, 14));
+    item.warnings = SplitLines(ColumnText(stmt, 15));
+    item.bullets = SplitLines(ColumnText(stmt, 16));
+    item.simhash = (uint64_t)sqlite3_column_int64(stmt, 17);
+    item.relevance_score = 0.0f;
+}
+
+static void ReadCandidateRow(sqlite3_stmt* stmt, VaultItem& item) {
+    item.id = ColumnText(stmt, 0);
+    item.title = ColumnText(stmt, 1);
+    item.source_domain = ColumnText(stmt, 2);
+    item.published_at = sqlite3_column_int64(stmt, 3);
+    item.retrieved_at = 0;
+    item.text_snippet = ColumnText(stmt, 4);
+    item.simhash = (uint64_t)sqlite3_column_int64(stmt, 5);
+    item.relevance_score = 0.0f;
+}
 
 Database::Database() : db(nullptr), isOpen(false), 
-    stmt_insert(nullptr), stmt_search(nullptr), stmt_get_by_id(nullptr) {
+    stmt_insert(nullptr), stmt_search(nullptr), stmt_get_by_id(nullptr),
+    stmt_store_answer(nullptr), stmt_get_answer(nullptr),
+    stmt_insert_quote(nullptr), stmt_delete(nullptr), stmt_get_rowid(nullptr),
+    stmt_insert_band(nullptr), stmt_find_band(nullptr), stmt_insert_feed_item(nullptr),
+    hasSurvivalBoost(false) {
 }
 
 Database::~Database() {
@@ -12,6 +198,7 @@ Database::~Database() {
 }
 
 bool Database::Initialize(const std::string& dbPath) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     int rc = sqlite3_open(dbPath.c_str(), &db);
     if (rc != SQLITE_OK) {
         return false;
@@ -23,10 +210,24 @@ bool Database::Initialize(const std::string& dbPath) {
     sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
     sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
     
+    // Statements can only be prepared once the schema exists (fresh vaults)
+    if (!CreateTables() || !CreateFTSIndex()) {
+        return false;
+    }
+    BackfillQuotes();
+    BackfillSimHashes();
+    LoadKnownIds();
+    
+    // Ranking runs inside SQLite so top-k comes back in final order
+    LoadSourceAuthority();
+    LoadRankSignals();
+    hasSurvivalBoost = RegisterSurvivalBoost(db, &rankSignals);
+    
     return PrepareStatements();
 }
 
 void Database::Close() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if (isOpen) {
         FinalizeStatements();
         sqlite3_close(db);
@@ -35,6 +236,7 @@ void Database::Close() {
 }
 
 bool Database::CreateTables() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS items (
             id TEXT PRIMARY KEY,
@@ -50,9 +252,22 @@ bool Database::CreateTables() {
             quotes_json TEXT,
             language TEXT DEFAULT 'en',
             content_type TEXT,
-            license_note TEXT
+            license_note TEXT,
+            steps TEXT,
+            warnings TEXT,
+            bullets TEXT,
+            simhash INTEGER
+        );
+        
+        -- Multi-probe index over items.simhash for near-duplicate checks
+        CREATE TABLE IF NOT EXISTS simhash_bands (
+            band_key INTEGER NOT NULL,
+            item_rowid INTEGER NOT NULL
         );
         
+        CREATE INDEX IF NOT EXISTS idx_simhash_bands ON simhash_bands(band_key);
+        CREATE INDEX IF NOT EXISTS idx_simhash_bands_item ON simhash_bands(item_rowid);
+        
         CREATE TABLE IF NOT EXISTS topics (
             topic_id INTEGER PRIMARY KEY AUTOINCREMENT,
             name TEXT UNIQUE NOT NULL,
@@ -61,6 +276,73 @@ bool Database::CreateTables() {
             last_updated INTEGER
         );
         
+        -- Answers precomputed on the host for Scenarios/Manuals
+        CREATE TABLE IF NOT EXISTS answers (
+            answer_key TEXT PRIMARY KEY,
+            query TEXT NOT NULL,
+            answer_blob BLOB NOT NULL,
+            built_at INTEGER NOT NULL
+        );
+        
+        -- Attributed quotes found at ingest (searched through quotes_fts)
+        CREATE TABLE IF NOT EXISTS quotes (
+            quote_id INTEGER PRIMARY KEY,
+            item_rowid INTEGER NOT NULL,
+            speaker TEXT,
+            text TEXT NOT NULL,
+            context TEXT,
+            position INTEGER
+        );
+        
+        CREATE INDEX IF NOT EXISTS idx_quotes_item ON quotes(item_rowid);
+        
+        -- Ranking boost per source domain (suffix match, 1.0 = neutral)
+        CREATE TABLE IF NOT EXISTS source_authority (
+            domain TEXT PRIMARY KEY,
+            weight REAL NOT NULL
+        );
+        
+        INSERT OR IGNORE INTO source_authority (domain, weight) VALUES
+            ('gov', 1.5), ('mil', 1.4), ('edu', 1.3),
+            ('who.int', 1.6), ('cdc.gov', 1.6), ('ready.gov', 1.6),
+            ('fema.gov', 1.6), ('nhs.uk', 1.5), ('redcross.org', 1.5),
+            ('wikipedia.org', 1.1);
+        
+        -- Parsed feed entries; the background refresher keeps these current
+        CREATE TABLE IF NOT EXISTS feed_items (
+            id TEXT PRIMARY KEY,
+            feed_url TEXT NOT NULL,
+            source TEXT,
+            title TEXT NOT NULL,
+            link TEXT NOT NULL,
+            description TEXT,
+            author TEXT,
+            published_at INTEGER,
+            fetched_at INTEGER NOT NULL
+        );
+        
+        CREATE INDEX IF NOT EXISTS idx_feed_items_feed ON feed_items(feed_url);
+        CREATE INDEX IF NOT EXISTS idx_feed_items_published ON feed_items(published_at);
+        
+        CREATE TABLE IF NOT EXISTS feeds (
+            url TEXT PRIMARY KEY,
+            last_fetched INTEGER,
+            item_count INTEGER,
+            poll_interval INTEGER,
+            next_poll INTEGER,
+            newest_item INTEGER,
+            item_gap REAL
+        );
+        
+        -- Conditional GET validators, refreshed whenever the URL is checked
+        CREATE TABLE IF NOT EXISTS http_validators (
+            url TEXT PRIMARY KEY,
+            etag TEXT,
+            last_modified TEXT,
+            body_bytes INTEGER,
+            checked_at INTEGER NOT NULL
+        );
+        
         CREATE INDEX IF NOT EXISTS idx_items_domain ON items(source_domain);
         CREATE INDEX IF NOT EXISTS idx_items_retrieved ON items(retrieved_at);
         CREATE INDEX IF NOT EXISTS idx_items_published ON items(published_at);
@@ -73,10 +355,46 @@ bool Database::CreateTables() {
         return false;
     }
     
-    return true;
+    return MigrateSchema();
+}
+
+bool Database::MigrateSchema() {
+    // Columns added after the first release; older vaults get them here
+    return AddColumnIfMissing("items", "steps", "TEXT") &&
+           AddColumnIfMissing("items", "warnings", "TEXT") &&
+           AddColumnIfMissing("items", "bullets", "TEXT") &&
+           AddColumnIfMissing("items", "simhash", "INTEGER") &&
+           AddColumnIfMissing("feeds", "poll_interval", "INTEGER") &&
+           AddColumnIfMissing("feeds", "next_poll", "INTEGER") &&
+           AddColumnIfMissing("feeds", "newest_item", "INTEGER") &&
+           AddColumnIfMissing("feeds", "item_gap", "REAL");
+}
+
+bool Database::AddColumnIfMissing(const std::string& table, const std::string& column,
+                                  const std::string& decl) {
+    std::string pragma = "PRAGMA table_info(" + table + ")";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, pragma.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    bool found = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (ColumnText(stmt, 1) == column) {
+            found = true;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    
+    if (found) return true;
+    
+    std::string alter = "ALTER TABLE " + table + " ADD COLUMN " + column + " " + decl;
+    return (sqlite3_exec(db, alter.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
 }
 
 bool Database::CreateFTSIndex() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     const char* sql = R"(
         CREATE VIRTUAL TABLE IF NOT EXISTS items_fts USING fts5(
             title,
@@ -104,6 +422,50 @@ bool Database::CreateFTSIndex() {
             INSERT INTO items_fts(rowid, title, text_snippet, text_clean, quotes_json, topic_tags)
             VALUES (new.rowid, new.title, new.text_snippet, new.text_clean, new.quotes_json, new.topic_tags);
         END;
+        
+        -- Speaker is a column so "what did X say about Y" is one indexed match
+        CREATE VIRTUAL TABLE IF NOT EXISTS quotes_fts USING fts5(
+            speaker,
+            text,
+            context,
+            content='quotes',
+            content_rowid='quote_id'
+        );
+        
+        CREATE TRIGGER IF NOT EXISTS quotes_ai AFTER INSERT ON quotes BEGIN
+            INSERT INTO quotes_fts(rowid, speaker, text, context)
+            VALUES (new.quote_id, new.speaker, new.text, new.context);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS quotes_ad AFTER DELETE ON quotes BEGIN
+            INSERT INTO quotes_fts(quotes_fts, rowid, speaker, text, context)
+            VALUES('delete', old.quote_id, old.speaker, old.text, old.context);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS items_ad_quotes AFTER DELETE ON items BEGIN
+            DELETE FROM quotes WHERE item_rowid = old.rowid;
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS items_ad_simhash AFTER DELETE ON items BEGIN
+            DELETE FROM simhash_bands WHERE item_rowid = old.rowid;
+        END;
+        
+        CREATE VIRTUAL TABLE IF NOT EXISTS feed_items_fts USING fts5(
+            title,
+            description,
+            content='feed_items',
+            content_rowid='rowid'
+        );
+        
+        CREATE TRIGGER IF NOT EXISTS feed_items_ai AFTER INSERT ON feed_items BEGIN
+            INSERT INTO feed_items_fts(rowid, title, description)
+            VALUES (new.rowid, new.title, new.description);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS feed_items_ad AFTER DELETE ON feed_items BEGIN
+            INSERT INTO feed_items_fts(feed_items_fts, rowid, title, description)
+            VALUES('delete', old.rowid, old.title, old.description);
+        END;
     )";
     
     char* errMsg = nullptr;
@@ -117,8 +479,39 @@ bool Database::CreateFTSIndex() {
 }
 
 bool Database::InsertItem(const VaultItem& item) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if (!stmt_insert) return false;
     
+    // Delete, insert, bands and quotes land together or not at all, so a
+    // failed replace never leaves the item missing or half-indexed
+    if (sqlite3_exec(db, "SAVEPOINT insert_item;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_int64 rowid = 0;
+    sqlite3_int64 oldRowid = 0;
+    if (!InsertItemRows(item, rowid, oldRowid)) {
+        sqlite3_exec(db, "ROLLBACK TO insert_item;", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "RELEASE insert_item;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    if (sqlite3_exec(db, "RELEASE insert_item;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    // A replaced item comes back under a new rowid
+    knownIds.Add(item.id);
+    if (oldRowid) rankSignals.erase(oldRowid);
+    RankSignal& signal = rankSignals[rowid];
+    signal.published_at = item.published_at;
+    signal.authority = LookupAuthority(authority, item.source_domain);
+    return true;
+}
+
+bool Database::InsertItemRows(const VaultItem& item, sqlite3_int64& rowid,
+                              sqlite3_int64& oldRowid) {
+    // A plain DELETE fires the triggers (REPLACE would leave stale FTS/quote rows)
+    if (!DeleteItemRow(item.id, oldRowid)) return false;
+    
     sqlite3_reset(stmt_insert);
     sqlite3_bind_text(stmt_insert, 1, item.id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt_insert, 2, item.title.c_str(), -1, SQLITE_TRANSIENT);
@@ -134,46 +527,341 @@ bool Database::InsertItem(const VaultItem& item) {
     sqlite3_bind_text(stmt_insert, 12, item.language.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt_insert, 13, item.content_type.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt_insert, 14, item.license_note.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt_insert, 15, JoinLines(item.steps).c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt_insert, 16, JoinLines(item.warnings).c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt_insert, 17, JoinLines(item.bullets).c_str(), -1, SQLITE_TRANSIENT);
+    
+    uint64_t simhash = ComputeBodySimHash(item.text_clean);
+    if (simhash) {
+        sqlite3_bind_int64(stmt_insert, 18, (sqlite3_int64)simhash);
+    } else {
+        sqlite3_bind_null(stmt_insert, 18);
+    }
     
     int rc = sqlite3_step(stmt_insert);
+    if (rc != SQLITE_DONE) return false;
+    
+    rowid = sqlite3_last_insert_rowid(db);
+    return InsertSimHashBands(rowid, simhash) && InsertQuotes(rowid, item);
+}
+
+bool Database::InsertSimHashBands(sqlite3_int64 itemRowid, uint64_t simhash) {
+    if (!stmt_insert_band) return false;
+    if (!simhash) return true;
+    
+    for (int band = 0; band < SIMHASH_BANDS; band++) {
+        sqlite3_reset(stmt_insert_band);
+        sqlite3_bind_int64(stmt_insert_band, 1, SimHashBandKey(simhash, band));
+        sqlite3_bind_int64(stmt_insert_band, 2, itemRowid);
+        if (sqlite3_step(stmt_insert_band) != SQLITE_DONE) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::MayHaveItem(const std::string& id) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return knownIds.MightContain(id);
+}
+
+bool Database::FindNearDuplicate(uint64_t simhash, std::string& outId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!stmt_find_band || !simhash) return false;
+    
+    // Distance <= 3 over 4 bands means at least one band matches exactly
+    for (int band = 0; band < SIMHASH_BANDS; band++) {
+        sqlite3_reset(stmt_find_band);
+        sqlite3_bind_int64(stmt_find_band, 1, SimHashBandKey(simhash, band));
+        while (sqlite3_step(stmt_find_band) == SQLITE_ROW) {
+            uint64_t candidate = (uint64_t)sqlite3_column_int64(stmt_find_band, 1);
+            if (HammingDistance(simhash, candidate) <= SIMHASH_MAX_DISTANCE) {
+                outId = ColumnText(stmt_find_band, 0);
+                sqlite3_reset(stmt_find_band);
+                return true;
+            }
+        }
+    }
+    
+    sqlite3_reset(stmt_find_band);
+    return false;
+}
+
+bool Database::GetItemById(const std::string& id, VaultItem& item) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!stmt_get_by_id) return false;
+    
+    sqlite3_reset(stmt_get_by_id);
+    sqlite3_bind_text(stmt_get_by_id, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    
+    bool found = (sqlite3_step(stmt_get_by_id) == SQLITE_ROW);
+    if (found) {
+        ReadItemRow(stmt_get_by_id, item);
+    }
+    sqlite3_reset(stmt_get_by_id);
+    return found;
+}
+
+bool Database::InsertQuotes(sqlite3_int64 itemRowid, const VaultItem& item) {
+    if (!stmt_insert_quote) return false;
+    
+    for (const auto& quote : item.quotes) {
+        // Unattributed quotes keep an empty speaker (as pc_collector.py does)
+        sqlite3_reset(stmt_insert_quote);
+        sqlite3_bind_int64(stmt_insert_quote, 1, itemRowid);
+        sqlite3_bind_text(stmt_insert_quote, 2, quote.speaker.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_quote, 3, quote.text.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_quote, 4, quote.context.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt_insert_quote, 5, quote.position);
+        
+        if (sqlite3_step(stmt_insert_quote) != SQLITE_DONE) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::DeleteItem(const std::string& id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    sqlite3_int64 rowid = 0;
+    if (!DeleteItemRow(id, rowid)) return false;
+    
+    if (rowid) rankSignals.erase(rowid);
+    return true;
+}
+
+bool Database::DeleteItemRow(const std::string& id, sqlite3_int64& rowid) {
+    if (!stmt_delete || !stmt_get_rowid) return false;
+    
+    // The rowid keys the in-memory rank signals of the row going away
+    rowid = 0;
+    sqlite3_reset(stmt_get_rowid);
+    sqlite3_bind_text(stmt_get_rowid, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt_get_rowid) == SQLITE_ROW) {
+        rowid = sqlite3_column_int64(stmt_get_rowid, 0);
+    }
+    sqlite3_reset(stmt_get_rowid);
+    if (!rowid) return true;
+    
+    sqlite3_reset(stmt_delete);
+    sqlite3_bind_text(stmt_delete, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    return (sqlite3_step(stmt_delete) == SQLITE_DONE);
+}
+
+bool Database::LoadKnownIds() {
+    // 0.1% false positives; headroom so a session of new items doesn't degrade it
+    int total = GetTotalItems();
+    knownIds.Reset(total * 2 + 1024, 0.001);
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id FROM items", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        knownIds.Add(ColumnText(stmt, 0));
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::BackfillSimHashes() {
+    // Vaults built before fingerprints (or by pc_collector.py) get them once
+    sqlite3_stmt* stmt;
+    const char* selectSql = "SELECT rowid, text_clean FROM items WHERE simhash IS NULL";
+    if (sqlite3_prepare_v2(db, selectSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_stmt* update;
+    const char* updateSql = "UPDATE items SET simhash = ? WHERE rowid = ?";
+    if (sqlite3_prepare_v2(db, updateSql, -1, &update, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    // Runs before PrepareStatements, so insert the bands directly
+    sqlite3_stmt* band;
+    const char* bandSql = "INSERT INTO simhash_bands (band_key, item_rowid) VALUES (?, ?)";
+    if (sqlite3_prepare_v2(db, bandSql, -1, &band, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(update);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sqlite3_int64 rowid = sqlite3_column_int64(stmt, 0);
+        uint64_t simhash = ComputeBodySimHash(ColumnText(stmt, 1));
+        
+        // 0 marks "too short to fingerprint" so the row isn't revisited
+        sqlite3_reset(update);
+        sqlite3_bind_int64(update, 1, (sqlite3_int64)simhash);
+        sqlite3_bind_int64(update, 2, rowid);
+        sqlite3_step(update);
+        
+        for (int b = 0; simhash && b < SIMHASH_BANDS; b++) {
+            sqlite3_reset(band);
+            sqlite3_bind_int64(band, 1, SimHashBandKey(simhash, b));
+            sqlite3_bind_int64(band, 2, rowid);
+            sqlite3_step(band);
+        }
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    
+    sqlite3_finalize(band);
+    sqlite3_finalize(update);
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::BackfillQuotes() {
+    // Vaults built before the quotes table only have quotes_json. Done once
+    // per vault: one without any quotes would otherwise rescan every open
+    if (GetUserVersion(db) >= VAULT_VERSION_QUOTES) return true;
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM quotes LIMIT 1", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool hasQuotes = (sqlite3_step(stmt) == SQLITE_ROW);
+    sqlite3_finalize(stmt);
+    if (hasQuotes) return SetUserVersion(db, VAULT_VERSION_QUOTES);
+    
+    const char* selectSql = "SELECT rowid, quotes_json FROM items "
+                            "WHERE quotes_json LIKE '[_%'";
+    if (sqlite3_prepare_v2(db, selectSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    // quotes_json has no attribution, so the speaker is left empty
+    sqlite3_stmt* insert;
+    const char* insertSql = "INSERT INTO quotes (item_rowid, speaker, text, context, position) "
+                            "VALUES (?, '', ?, '', ?)";
+    if (sqlite3_prepare_v2(db, insertSql, -1, &insert, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sqlite3_int64 rowid = sqlite3_column_int64(stmt, 0);
+        std::vector<std::string> texts = DecodeQuotesJson(ColumnText(stmt, 1));
+        
+        for (size_t i = 0; i < texts.size(); i++) {
+            sqlite3_reset(insert);
+            sqlite3_bind_int64(insert, 1, rowid);
+            sqlite3_bind_text(insert, 2, texts[i].c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(insert, 3, (int)i);
+            sqlite3_step(insert);
+        }
+    }
+    sqlite3_finalize(insert);
+    sqlite3_finalize(stmt);
+    
+    // Marked done in the same transaction as the rows it covers
+    bool done = SetUserVersion(db, VAULT_VERSION_QUOTES);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    return done;
+}
+
+bool Database::StoreAnswer(const std::string& key, const std::string& query,
+                           const std::string& blob) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!stmt_store_answer) return false;
+    
+    sqlite3_reset(stmt_store_answer);
+    sqlite3_bind_text(stmt_store_answer, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt_store_answer, 2, query.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_blob(stmt_store_answer, 3, blob.data(), (int)blob.size(), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt_store_answer, 4, time(nullptr));
+    
+    int rc = sqlite3_step(stmt_store_answer);
     return (rc == SQLITE_DONE);
 }
 
-std::vector<SearchResult> Database::SearchFTS(const std::string& query, int limit) {
+bool Database::GetAnswer(const std::string& key, std::string& outBlob) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!stmt_get_answer) return false;
+    
+    // Single primary-key lookup - no FTS involved
+    sqlite3_reset(stmt_get_answer);
+    sqlite3_bind_text(stmt_get_answer, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    
+    if (sqlite3_step(stmt_get_answer) != SQLITE_ROW) {
+        return false;
+    }
+    
+    const void* data = sqlite3_column_blob(stmt_get_answer, 0);
+    int size = sqlite3_column_bytes(stmt_get_answer, 0);
+    outBlob.assign(static_cast<const char*>(data), size);
+    sqlite3_reset(stmt_get_answer);
+    return true;
+}
+
+std::vector<SearchResult> Database::SearchFTS(const std::string& query, int limit,
+                                             const RankingOptions& ranking) {
+    return SearchFTSRows(query, limit, ranking, true);
+}
+
+std::vector<SearchResult> Database::SearchFTSCandidates(const std::string& query, int limit,
+                                                       const RankingOptions& ranking) {
+    return SearchFTSRows(query, limit, ranking, false);
+}
+
+std::vector<SearchResult> Database::SearchFTSRows(const std::string& query, int limit,
+                                                 const RankingOptions& ranking, bool fullRows) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     std::vector<SearchResult> results;
     
-    std::string sql = "SELECT items.*, rank FROM items_fts "
-                     "JOIN items ON items.rowid = items_fts.rowid "
-                     "WHERE items_fts MATCH ? "
-                     "ORDER BY rank LIMIT ?";
+    std::string columns = fullRows ? ITEM_COLUMNS : CANDIDATE_COLUMNS;
+    int scoreColumn = fullRows ? ITEM_COLUMN_COUNT : CANDIDATE_COLUMN_COUNT;
+    
+    // Top-k is picked on items_fts alone (column-weighted bm25 times the
+    // in-memory boost); items rows are read for the winners only
+    std::string sql;
+    if (hasSurvivalBoost) {
+        sql = "SELECT " + columns + ", top.score FROM ("
+              "SELECT items_fts.rowid AS item_rowid, "
+              "bm25(items_fts, " FTS_COLUMN_WEIGHTS ") * "
+              "survival_boost(items_fts.rowid, ?, ?, ?, ?) AS score "
+              "FROM items_fts WHERE items_fts MATCH ? "
+              "ORDER BY score LIMIT ?) AS top "
+              "JOIN items ON items.rowid = top.item_rowid "
+              "ORDER BY top.score";
+    } else {
+        sql = "SELECT " + columns + ", rank FROM items_fts "
+              "JOIN items ON items.rowid = items_fts.rowid "
+              "WHERE items_fts MATCH ? "
+              "ORDER BY rank LIMIT ?";
+    }
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return results;
     }
     
-    sqlite3_bind_text(stmt, 1, query.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 2, limit);
+    int param = 1;
+    if (hasSurvivalBoost) {
+        sqlite3_bind_int64(stmt, param++, time(nullptr));
+        sqlite3_bind_double(stmt, param++, ranking.halfLifeDays);
+        sqlite3_bind_double(stmt, param++, ranking.recencyWeight);
+        sqlite3_bind_double(stmt, param++, ranking.authorityStrength);
+    }
+    sqlite3_bind_text(stmt, param++, query.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, param++, limit);
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         SearchResult result;
-        
-        result.item.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        result.item.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result.item.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        result.item.source_domain = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        result.item.author = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        result.item.published_at = sqlite3_column_int64(stmt, 5);
-        result.item.retrieved_at = sqlite3_column_int64(stmt, 6);
-        result.item.topic_tags = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-        result.item.text_snippet = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        result.item.text_clean = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        result.item.quotes_json = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        result.item.language = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        result.item.content_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        result.item.license_note = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
-        
-        result.score = sqlite3_column_double(stmt, 14);
+        if (fullRows) {
+            ReadItemRow(stmt, result.item);
+        } else {
+            ReadCandidateRow(stmt, result.item);
+        }
+        result.score = sqlite3_column_double(stmt, scoreColumn);
         
         results.push_back(result);
     }
@@ -182,61 +870,94 @@ std::vector<SearchResult> Database::SearchFTS(const std::string& query, int limi
     return results;
 }
 
+// Lowercased FTS terms of a name/topic, quoted so user text can't inject syntax
+static std::vector<std::string> MatchTerms(const std::string& text) {
+    static const char* stopWords[] = { "the", "a", "an", "of", "and", "or", "to", "on", "in", nullptr };
+    std::vector<std::string> terms;
+    std::string term;
+    
+    for (size_t i = 0; i <= text.length(); i++) {
+        unsigned char c = i < text.length() ? text[i] : ' ';
+        if (isalnum(c) || c >= 0x80) {
+            term += (char)tolower(c);
+            continue;
+        }
+        if (term.empty()) continue;
+        
+        bool stop = false;
+        for (int s = 0; stopWords[s]; s++) {
+            if (term == stopWords[s]) stop = true;
+        }
+        if (!stop) terms.push_back("\"" + term + "\"");
+        term.clear();
+    }
+    return terms;
+}
+
 std::vector<SearchResult> Database::SearchQuotes(const std::string& person, 
                                                   const std::string& topic, 
                                                   int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     std::vector<SearchResult> results;
     
-    // Build query for quotes about person
-    std::string query = person;
-    if (!topic.empty()) {
-        query += " " + topic;
-    }
-    
-    // Search with priority for transcripts and direct quotes
-    std::string sql = "SELECT items.*, rank FROM items_fts "
-                     "JOIN items ON items.rowid = items_fts.rowid "
-                     "WHERE items_fts MATCH ? "
-                     "AND (content_type = 'transcript' OR content_type = 'statement' "
-                     "     OR quotes_json LIKE ?) "
-                     "ORDER BY rank, "
-                     "CASE content_type "
-                     "  WHEN 'transcript' THEN 1 "
-                     "  WHEN 'statement' THEN 2 "
-                     "  ELSE 3 "
-                     "END "
-                     "LIMIT ?";
+    // Every speaker term must hit the speaker column; topic terms rank
+    std::vector<std::string> speakerTerms = MatchTerms(person);
+    if (speakerTerms.empty()) return results;
+    
+    std::string match;
+    for (const auto& term : speakerTerms) {
+        if (!match.empty()) match += " AND ";
+        match += "speaker : " + term;
+    }
+    
+    std::vector<std::string> topicTerms = MatchTerms(topic);
+    if (!topicTerms.empty()) {
+        match += " AND (";
+        for (size_t i = 0; i < topicTerms.size(); i++) {
+            if (i > 0) match += " OR ";
+            match += "{text context} : " + topicTerms[i] + "*";  // Prefix: plurals
+        }
+        match += ")";
+    }
+    
+    std::string sql = "SELECT " ITEM_COLUMNS ", bm25(quotes_fts, 4.0, 2.0, 1.0) AS score, "
+                     "quotes.text, quotes.speaker, quotes.context, quotes.position "
+                     "FROM quotes_fts "
+                     "JOIN quotes ON quotes.quote_id = quotes_fts.rowid "
+                     "JOIN items ON items.rowid = quotes.item_rowid "
+                     "WHERE quotes_fts MATCH ? "
+                     "ORDER BY score LIMIT ?";
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return results;
     }
     
-    sqlite3_bind_text(stmt, 1, query.c_str(), -1, SQLITE_TRANSIENT);
-    std::string quoteLike = "%" + person + "%";
-    sqlite3_bind_text(stmt, 2, quoteLike.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 3, limit);
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, limit);
     
+    // Group quotes under their item, keeping best-first order
+    std::map<std::string, size_t> itemIndex;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        SearchResult result;
+        VaultQuote quote;
+        quote.text = ColumnText(stmt, ITEM_COLUMN_COUNT + 1);
+        quote.speaker = ColumnText(stmt, ITEM_COLUMN_COUNT + 2);
+        quote.context = ColumnText(stmt, ITEM_COLUMN_COUNT + 3);
+        quote.position = sqlite3_column_int(stmt, ITEM_COLUMN_COUNT + 4);
+        
+        std::string id = ColumnText(stmt, 0);
+        std::map<std::string, size_t>::iterator it = itemIndex.find(id);
+        if (it != itemIndex.end()) {
+            results[it->second].quotes.push_back(quote);
+            continue;
+        }
         
-        result.item.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        result.item.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result.item.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        result.item.source_domain = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        result.item.author = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        result.item.published_at = sqlite3_column_int64(stmt, 5);
-        result.item.retrieved_at = sqlite3_column_int64(stmt, 6);
-        result.item.topic_tags = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-        result.item.text_snippet = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        result.item.text_clean = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        result.item.quotes_json = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        result.item.language = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        result.item.content_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        result.item.license_note = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
-        
-        result.score = sqlite3_column_double(stmt, 14);
+        SearchResult result;
+        ReadItemRow(stmt, result.item);
+        result.score = sqlite3_column_double(stmt, ITEM_COLUMN_COUNT);
+        result.quotes.push_back(quote);
         
+        itemIndex[id] = results.size();
         results.push_back(result);
     }
     
@@ -244,7 +965,288 @@ std::vector<SearchResult> Database::SearchQuotes(const std::string& person,
     return results;
 }
 
+int Database::StoreFeedItems(const std::vector<FeedItem>& items) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!stmt_insert_feed_item) return 0;
+    
+    // One transaction per feed refresh instead of one per item
+    sqlite3_exec(db, "SAVEPOINT feed_items;", nullptr, nullptr, nullptr);
+    
+    int added = 0;
+    for (const auto& item : items) {
+        sqlite3_reset(stmt_insert_feed_item);
+        sqlite3_bind_text(stmt_insert_feed_item, 1, item.id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 2, item.feed_url.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 3, item.source.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 4, item.title.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 5, item.link.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 6, item.description.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt_insert_feed_item, 7, item.author.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt_insert_feed_item, 8, item.published_at);
+        sqlite3_bind_int64(stmt_insert_feed_item, 9, item.fetched_at);
+        
+        if (sqlite3_step(stmt_insert_feed_item) == SQLITE_DONE && sqlite3_changes(db) > 0) {
+            added++;
+        }
+    }
+    sqlite3_reset(stmt_insert_feed_item);
+    
+    sqlite3_exec(db, "RELEASE feed_items;", nullptr, nullptr, nullptr);
+    return added;
+}
+
+std::vector<FeedItem> Database::SearchFeedItems(const std::string& query, int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<FeedItem> results;
+    
+    // Any term may match; bm25 puts items matching more of them first
+    std::vector<std::string> terms = MatchTerms(query);
+    if (terms.empty()) return results;
+    
+    std::string match;
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (i > 0) match += " OR ";
+        match += terms[i] + "*";
+    }
+    
+    const char* sql = 
+        "SELECT feed_items.id, feed_items.feed_url, feed_items.source, feed_items.title, "
+        "feed_items.link, feed_items.description, feed_items.author, "
+        "feed_items.published_at, feed_items.fetched_at, "
+        "bm25(feed_items_fts, 2.0, 1.0) AS score "
+        "FROM feed_items_fts "
+        "JOIN feed_items ON feed_items.rowid = feed_items_fts.rowid "
+        "WHERE feed_items_fts MATCH ? "
+        "ORDER BY score LIMIT ?";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return results;
+    }
+    
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, limit);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        FeedItem item;
+        item.id = ColumnText(stmt, 0);
+        item.feed_url = ColumnText(stmt, 1);
+        item.source = ColumnText(stmt, 2);
+        item.title = ColumnText(stmt, 3);
+        item.link = ColumnText(stmt, 4);
+        item.description = ColumnText(stmt, 5);
+        item.author = ColumnText(stmt, 6);
+        item.published_at = sqlite3_column_int64(stmt, 7);
+        item.fetched_at = sqlite3_column_int64(stmt, 8);
+        item.score = (float)sqlite3_column_double(stmt, 9);
+        results.push_back(item);
+    }
+    
+    sqlite3_finalize(stmt);
+    return results;
+}
+
+bool Database::PruneFeedItems(time_t olderThan) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    // Undated items age by when we first saw them
+    const char* sql = 
+        "DELETE FROM feed_items WHERE "
+        "(CASE WHEN published_at > 0 THEN published_at ELSE fetched_at END) < ?";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, olderThan);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+int Database::GetFeedItemCount() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM feed_items", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    
+    int count = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+    
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+bool Database::GetFeedState(const std::string& url, FeedState& state) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const char* sql = "SELECT last_fetched, item_count, poll_interval, next_poll, "
+                      "newest_item, item_gap FROM feeds WHERE url = ?";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, url.c_str(), -1, SQLITE_TRANSIENT);
+    
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        state.url = url;
+        state.last_fetched = sqlite3_column_int64(stmt, 0);
+        state.item_count = sqlite3_column_int(stmt, 1);
+        state.poll_interval = sqlite3_column_int(stmt, 2);
+        state.next_poll = sqlite3_column_int64(stmt, 3);
+        state.newest_item = sqlite3_column_int64(stmt, 4);
+        state.item_gap = sqlite3_column_double(stmt, 5);
+        found = true;
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool Database::SetFeedState(const FeedState& state) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const char* sql = "INSERT OR REPLACE INTO feeds (url, last_fetched, item_count, poll_interval, "
+                      "next_poll, newest_item, item_gap) VALUES (?, ?, ?, ?, ?, ?, ?)";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, state.url.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, state.last_fetched);
+    sqlite3_bind_int(stmt, 3, state.item_count);
+    sqlite3_bind_int(stmt, 4, state.poll_interval);
+    sqlite3_bind_int64(stmt, 5, state.next_poll);
+    sqlite3_bind_int64(stmt, 6, state.newest_item);
+    sqlite3_bind_double(stmt, 7, state.item_gap);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool Database::GetHttpValidators(const std::string& url, std::string& etag,
+                                 std::string& lastModified, int64_t& bodyBytes) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const char* sql = "SELECT etag, last_modified, body_bytes FROM http_validators WHERE url = ?";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, url.c_str(), -1, SQLITE_TRANSIENT);
+    
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        etag = ColumnText(stmt, 0);
+        lastModified = ColumnText(stmt, 1);
+        bodyBytes = sqlite3_column_int64(stmt, 2);
+        found = true;
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool Database::SetHttpValidators(const std::string& url, const std::string& etag,
+                                 const std::string& lastModified, int64_t bodyBytes) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const char* sql = 
+        "INSERT OR REPLACE INTO http_validators (url, etag, last_modified, body_bytes, checked_at) "
+        "VALUES (?, ?, ?, ?, ?)";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, url.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, etag.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, lastModified.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 4, bodyBytes);
+    sqlite3_bind_int64(stmt, 5, time(nullptr));
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool Database::PruneHttpValidators(time_t olderThan) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM http_validators WHERE checked_at < ?", -1,
+                           &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, olderThan);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool Database::LoadSourceAuthority() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT domain, weight FROM source_authority", -1,
+                           &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    authority.clear();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        authority[ColumnText(stmt, 0)] = (float)sqlite3_column_double(stmt, 1);
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::LoadRankSignals() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT rowid, published_at, source_domain FROM items", -1,
+                           &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    // One entry per live row; InsertItem and DeleteItem keep it that way
+    rankSignals.clear();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        RankSignal& signal = rankSignals[sqlite3_column_int64(stmt, 0)];
+        signal.published_at = sqlite3_column_int64(stmt, 1);
+        signal.authority = LookupAuthority(authority, ColumnText(stmt, 2));
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+float Database::GetSourceAuthority(const std::string& domain) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return LookupAuthority(authority, domain);
+}
+
+bool Database::SetSourceAuthority(const std::string& domain, float weight) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const char* sql = "INSERT OR REPLACE INTO source_authority (domain, weight) VALUES (?, ?)";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, domain.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 2, weight);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (rc != SQLITE_DONE) return false;
+    
+    // The ranking function reads the in-memory copies
+    authority[domain] = weight;
+    return LoadRankSignals();
+}
+
 int Database::GetTotalItems() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     const char* sql = "SELECT COUNT(*) FROM items";
     sqlite3_stmt* stmt;
     
@@ -266,14 +1268,70 @@ bool Database::PrepareStatements() {
         INSERT OR REPLACE INTO items 
         (id, title, url, source_domain, author, published_at, retrieved_at, 
          topic_tags, text_snippet, text_clean, quotes_json, language, 
-         content_type, license_note)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+         content_type, license_note, steps, warnings, bullets, simhash)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
     )";
     
     if (sqlite3_prepare_v2(db, insertSql, -1, &stmt_insert, nullptr) != SQLITE_OK) {
         return false;
     }
     
+    const char* storeAnswerSql = 
+        "INSERT OR REPLACE INTO answers (answer_key, query, answer_blob, built_at) "
+        "VALUES (?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db, storeAnswerSql, -1, &stmt_store_answer, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* getAnswerSql = "SELECT answer_blob FROM answers WHERE answer_key = ?";
+    if (sqlite3_prepare_v2(db, getAnswerSql, -1, &stmt_get_answer, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* insertQuoteSql = 
+        "INSERT INTO quotes (item_rowid, speaker, text, context, position) "
+        "VALUES (?, ?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db, insertQuoteSql, -1, &stmt_insert_quote, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* deleteSql = "DELETE FROM items WHERE id = ?";
+    if (sqlite3_prepare_v2(db, deleteSql, -1, &stmt_delete, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* getRowidSql = "SELECT rowid FROM items WHERE id = ?";
+    if (sqlite3_prepare_v2(db, getRowidSql, -1, &stmt_get_rowid, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* getByIdSql = "SELECT " ITEM_COLUMNS " FROM items WHERE id = ?";
+    if (sqlite3_prepare_v2(db, getByIdSql, -1, &stmt_get_by_id, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* insertBandSql = "INSERT INTO simhash_bands (band_key, item_rowid) VALUES (?, ?)";
+    if (sqlite3_prepare_v2(db, insertBandSql, -1, &stmt_insert_band, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    // Feed items rarely change once published; repeats are skipped
+    const char* insertFeedItemSql = 
+        "INSERT OR IGNORE INTO feed_items "
+        "(id, feed_url, source, title, link, description, author, published_at, fetched_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db, insertFeedItemSql, -1, &stmt_insert_feed_item, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    const char* findBandSql = 
+        "SELECT items.id, items.simhash FROM simhash_bands "
+        "JOIN items ON items.rowid = simhash_bands.item_rowid "
+        "WHERE simhash_bands.band_key = ?";
+    if (sqlite3_prepare_v2(db, findBandSql, -1, &stmt_find_band, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
     return true;
 }
 
@@ -281,13 +1339,46 @@ void Database::FinalizeStatements() {
     if (stmt_insert) sqlite3_finalize(stmt_insert);
     if (stmt_search) sqlite3_finalize(stmt_search);
     if (stmt_get_by_id) sqlite3_finalize(stmt_get_by_id);
+    if (stmt_store_answer) sqlite3_finalize(stmt_store_answer);
+    if (stmt_get_answer) sqlite3_finalize(stmt_get_answer);
+    if (stmt_insert_quote) sqlite3_finalize(stmt_insert_quote);
+    if (stmt_delete) sqlite3_finalize(stmt_delete);
+    if (stmt_get_rowid) sqlite3_finalize(stmt_get_rowid);
+    if (stmt_insert_band) sqlite3_finalize(stmt_insert_band);
+    if (stmt_find_band) sqlite3_finalize(stmt_find_band);
+    if (stmt_insert_feed_item) sqlite3_finalize(stmt_insert_feed_item);
+    
+    stmt_insert = stmt_search = stmt_get_by_id = nullptr;
+    stmt_store_answer = stmt_get_answer = nullptr;
+    stmt_insert_quote = stmt_delete = stmt_get_rowid = nullptr;
+    stmt_insert_band = stmt_find_band = nullptr;
+    stmt_insert_feed_item = nullptr;
+}
+
+bool Database::RunInTransaction(const std::function<bool()>& work) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    if (work() && sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+        return true;
+    }
+    
+    sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    
+    // Items inserted by work are gone again
+    LoadRankSignals();
+    return false;
 }
 
 bool Database::Vacuum() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     return (sqlite3_exec(db, "VACUUM;", nullptr, nullptr, nullptr) == SQLITE_OK);
 }
 
 bool Database::OptimizeFTS() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     return (sqlite3_exec(db, "INSERT INTO items_fts(items_fts) VALUES('optimize');", 
                         nullptr, nullptr, nullptr) == SQLITE_OK);
 }
@@ -0,0 +1,78 @@
+#include "fts_rank.h"
+#include <cmath>
+#include <cstring>
+
+static const double SECONDS_PER_DAY = 86400.0;
+
+// Longest suffix match on a label boundary; no allocation per call
+float LookupAuthority(const AuthorityMap& authority, const std::string& domain) {
+    const char* name = domain.data();
+    size_t length = domain.length();
+    
+    float weight = 1.0f;
+    size_t bestLength = 0;
+    for (AuthorityMap::const_iterator it = authority.begin(); it != authority.end(); ++it) {
+        size_t keyLength = it->first.length();
+        if (keyLength == 0 || keyLength > length || keyLength <= bestLength) continue;
+        
+        const char* suffix = name + (length - keyLength);
+        if (memcmp(suffix, it->first.data(), keyLength) != 0) continue;
+        if (keyLength < length && suffix[-1] != '.') continue;
+        
+        weight = it->second;
+        bestLength = keyLength;
+    }
+    return weight;
+}
+
+static double ArgDouble(sqlite3_value** args, int count, int index, double fallback) {
+    if (index >= count || sqlite3_value_type(args[index]) == SQLITE_NULL) {
+        return fallback;
+    }
+    return sqlite3_value_double(args[index]);
+}
+
+static void SurvivalBoost(sqlite3_context* ctx, int argCount, sqlite3_value** args) {
+    const RankSignalMap* signals = static_cast<const RankSignalMap*>(sqlite3_user_data(ctx));
+    if (!signals || argCount < 1) {
+        sqlite3_result_double(ctx, 1.0);
+        return;
+    }
+    
+    RankSignalMap::const_iterator it = signals->find(sqlite3_value_int64(args[0]));
+    if (it == signals->end()) {
+        sqlite3_result_double(ctx, 1.0);
+        return;
+    }
+    
+    double now = ArgDouble(args, argCount, 1, 0.0);
+    double halfLifeDays = ArgDouble(args, argCount, 2, 365.0);
+    double recencyWeight = ArgDouble(args, argCount, 3, 0.0);
+    double authorityStrength = ArgDouble(args, argCount, 4, 0.0);
+    double boost = 1.0;
+    
+    // Exponential age decay; undated items sit at one half-life
+    if (recencyWeight > 0.0 && halfLifeDays > 0.0) {
+        double decay = 0.5;
+        double publishedAt = (double)it->second.published_at;
+        if (publishedAt > 0.0 && now > 0.0) {
+            double ageDays = (now - publishedAt) / SECONDS_PER_DAY;
+            if (ageDays < 0.0) ageDays = 0.0;
+            decay = pow(0.5, ageDays / halfLifeDays);
+        }
+        boost *= (1.0 - recencyWeight) + recencyWeight * decay;
+    }
+    
+    if (authorityStrength > 0.0 && it->second.authority != 1.0f) {
+        boost *= pow(it->second.authority, authorityStrength);
+    }
+    
+    sqlite3_result_double(ctx, boost);
+}
+
+bool RegisterSurvivalBoost(sqlite3* db, const RankSignalMap* signals) {
+    int rc = sqlite3_create_function(db, "survival_boost", 5, SQLITE_UTF8,
+                                     const_cast<RankSignalMap*>(signals),
+                                     SurvivalBoost, nullptr, nullptr);
+    return (rc == SQLITE_OK);
+}
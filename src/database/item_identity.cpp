@@ -0,0 +1,208 @@
+#include "item_identity.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Query parameters that only track the click, never select content
+static bool IsTrackingParam(const std::string& name) {
+    static const char* exact[] = {
+        "fbclid", "gclid", "dclid", "msclkid", "yclid", "igshid", "mc_cid",
+        "mc_eid", "_ga", "_hsenc", "_hsmi", "ref_src", "spm", nullptr
+    };
+    
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower.compare(0, 4, "utm_") == 0) return true;
+    for (int i = 0; exact[i]; i++) {
+        if (lower == exact[i]) return true;
+    }
+    return false;
+}
+
+std::string CanonicalizeUrl(const std::string& url) {
+    // Trim surrounding whitespace (feeds often pad <link> text)
+    size_t begin = url.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = url.find_last_not_of(" \t\r\n") + 1;
+    std::string work = url.substr(begin, end - begin);
+    
+    // Fragment never reaches the server
+    size_t hash = work.find('#');
+    if (hash != std::string::npos) work.erase(hash);
+    
+    size_t schemeEnd = work.find("://");
+    if (schemeEnd == std::string::npos) return work;
+    
+    std::string scheme = work.substr(0, schemeEnd);
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+    
+    size_t hostStart = schemeEnd + 3;
+    size_t hostEnd = work.find_first_of("/?", hostStart);
+    if (hostEnd == std::string::npos) hostEnd = work.length();
+    std::string host = work.substr(hostStart, hostEnd - hostStart);
+    std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+    
+    // Default ports
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(']', colon) == std::string::npos) {
+        std::string port = host.substr(colon + 1);
+        if ((scheme == "http" && port == "80") || (scheme == "https" && port == "443") ||
+            port.empty()) {
+            host.erase(colon);
+        }
+    }
+    
+    std::string rest = work.substr(hostEnd);
+    std::string path = rest;
+    std::string query;
+    size_t question = rest.find('?');
+    if (question != std::string::npos) {
+        path = rest.substr(0, question);
+        query = rest.substr(question + 1);
+    }
+    if (path.empty()) path = "/";
+    
+    // Keep content parameters in a stable order
+    std::vector<std::string> params;
+    size_t start = 0;
+    while (start < query.length()) {
+        size_t amp = query.find('&', start);
+        if (amp == std::string::npos) amp = query.length();
+        std::string param = query.substr(start, amp - start);
+        std::string name = param.substr(0, param.find('='));
+        if (!param.empty() && !IsTrackingParam(name)) {
+            params.push_back(param);
+        }
+        start = amp + 1;
+    }
+    std::sort(params.begin(), params.end());
+    
+    std::string canonical = scheme + "://" + host + path;
+    for (size_t i = 0; i < params.size(); i++) {
+        canonical += (i == 0 ? "?" : "&") + params[i];
+    }
+    return canonical;
+}
+
+static inline uint64_t Rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t FMix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t ReadLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// Reference MurmurHash3_x64_128 (public domain, Austin Appleby)
+void MurmurHash3_x64_128(const void* data, size_t length, uint32_t seed, uint64_t out[2]) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t blocks = length / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+    
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k1 = ReadLE64(bytes + i * 16);
+        uint64_t k2 = ReadLE64(bytes + i * 16 + 8);
+        
+        k1 *= c1; k1 = Rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = Rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        
+        k2 *= c2; k2 = Rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = Rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+    
+    const uint8_t* tail = bytes + blocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    size_t rem = length & 15;
+    for (size_t i = rem; i > 8; i--) k2 = (k2 << 8) | tail[i - 1];
+    for (size_t i = std::min(rem, size_t(8)); i > 0; i--) k1 = (k1 << 8) | tail[i - 1];
+    
+    if (rem > 8) {
+        k2 *= c2; k2 = Rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    if (rem > 0) {
+        k1 *= c1; k1 = Rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+    
+    h1 ^= length;
+    h2 ^= length;
+    h1 += h2;
+    h2 += h1;
+    h1 = FMix64(h1);
+    h2 = FMix64(h2);
+    h1 += h2;
+    h2 += h1;
+    
+    out[0] = h1;
+    out[1] = h2;
+}
+
+std::string ComputeItemId(const std::string& url) {
+    std::string canonical = CanonicalizeUrl(url);
+    uint64_t hash[2];
+    MurmurHash3_x64_128(canonical.data(), canonical.length(), 0, hash);
+    
+    char hex[33];
+    snprintf(hex, sizeof(hex), "%016llx%016llx",
+             (unsigned long long)hash[0], (unsigned long long)hash[1]);
+    return hex;
+}
+
+BloomFilter::BloomFilter() : bitCount(0), hashCount(0), count(0) {
+}
+
+void BloomFilter::Reset(size_t expectedItems, double falsePositiveRate) {
+    if (expectedItems < 1) expectedItems = 1;
+    
+    // m = -n ln p / (ln 2)^2, k = m/n ln 2
+    double ln2 = log(2.0);
+    double m = -(double)expectedItems * log(falsePositiveRate) / (ln2 * ln2);
+    bitCount = ((uint64_t)m + 63) & ~63ULL;
+    if (bitCount < 64) bitCount = 64;
+    hashCount = (int)ceil((double)bitCount / expectedItems * ln2);
+    if (hashCount < 1) hashCount = 1;
+    if (hashCount > 16) hashCount = 16;
+    
+    bits.assign(bitCount / 64, 0);
+    count = 0;
+}
+
+void BloomFilter::Add(const std::string& key) {
+    if (bits.empty()) return;
+    
+    // Double hashing from one 128-bit hash: probe i = h1 + i*h2
+    uint64_t hash[2];
+    MurmurHash3_x64_128(key.data(), key.length(), 0x5eed, hash);
+    for (int i = 0; i < hashCount; i++) {
+        uint64_t bit = (hash[0] + i * hash[1]) % bitCount;
+        bits[bit / 64] |= (1ULL << (bit % 64));
+    }
+    count++;
+}
+
+bool BloomFilter::MightContain(const std::string& key) const {
+    if (bits.empty()) return false;
+    
+    uint64_t hash[2];
+    MurmurHash3_x64_128(key.data(), key.length(), 0x5eed, hash);
+    for (int i = 0; i < hashCount; i++) {
+        uint64_t bit = (hash[0] + i * hash[1]) % bitCount;
+        if (!(bits[bit / 64] & (1ULL << (bit % 64)))) return false;
+    }
+    return true;
+}
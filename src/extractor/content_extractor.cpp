@@ -1,7 +1,103 @@
 #include "content_extractor.h"
+#include "text_normalize.h"
 #include <algorithm>
 #include <sstream>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+// Caps for ingest-time structure
+static const size_t MAX_STEPS = 20;
+static const size_t MAX_WARNINGS = 10;
+static const size_t MAX_BULLETS = 20;
+
+// Body text keeps block newlines; titles and attributes collapse to one line
+static const int BODY_TEXT_FLAGS = TEXT_DECODE_ENTITIES | TEXT_COLLAPSE_SPACE | TEXT_KEEP_NEWLINES;
+static const int LINE_TEXT_FLAGS = TEXT_DECODE_ENTITIES | TEXT_COLLAPSE_SPACE;
+
+// Streaming stops once the page has produced this many text bytes per word
+// we keep (about twice the average word), since what follows the body is
+// mostly comments and footer
+static const size_t ENOUGH_TEXT_PER_WORD = 12;
+
+// Larger ld+json blocks are product catalogs, not article metadata
+static const size_t MAX_JSON_LD_BYTES = 256 * 1024;
+
+// Readability scoring
+static const size_t MIN_PARAGRAPH_CHARS = 25;
+static const int SCORE_ANCESTOR_LEVELS = 5;
+static const float CLASS_WEIGHT = 25.0f;
+
+// Tags that start a new line in extracted text (keeps list/step structure)
+static bool IsBlockTag(const HtmlSpan& name) {
+    static const char* tags[] = {
+        "p", "br", "li", "div", "tr", "ul", "ol", "section", "article", "main",
+        "header", "footer", "nav", "aside", "blockquote", "pre", "table", "hr",
+        "dd", "dt", "figure", "figcaption", "form", nullptr
+    };
+    if (name.length == 2 && tolower((unsigned char)name.data[0]) == 'h' &&
+        name.data[1] >= '1' && name.data[1] <= '6') {
+        return true;
+    }
+    for (int i = 0; tags[i]; i++) {
+        if (name.Equals(tags[i])) return true;
+    }
+    return false;
+}
+
+// Elements that never have an end tag
+static bool IsVoidTag(const HtmlSpan& name) {
+    static const char* tags[] = {
+        "area", "base", "br", "col", "embed", "hr", "img", "input", "link",
+        "meta", "param", "source", "track", "wbr", nullptr
+    };
+    for (int i = 0; tags[i]; i++) {
+        if (name.Equals(tags[i])) return true;
+    }
+    return false;
+}
+
+static bool HasPaywallMarker(const HtmlSpan& span) {
+    return span.Contains("paywall") ||
+           span.Contains("subscriber only") ||
+           span.Contains("subscribe to read");
+}
+
+// Class/id fragments that mark content vs. page chrome
+static bool HasPositiveHint(const HtmlSpan& value) {
+    static const char* hints[] = {
+        "article", "body", "content", "entry", "main", "page", "post", "text",
+        "blog", "story", nullptr
+    };
+    for (int i = 0; hints[i]; i++) {
+        if (value.Contains(hints[i])) return true;
+    }
+    return false;
+}
+
+static bool HasNegativeHint(const HtmlSpan& value) {
+    static const char* hints[] = {
+        "comment", "footer", "footnote", "masthead", "meta", "nav", "sidebar",
+        "sponsor", "share", "social", "related", "menu", "promo", "banner",
+        "widget", "cookie", "popup", nullptr
+    };
+    for (int i = 0; hints[i]; i++) {
+        if (value.Contains(hints[i])) return true;
+    }
+    return false;
+}
+
+static std::string LowerName(const HtmlSpan& name) {
+    std::string lower(name.data, name.length);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
+ContentExtractor::PageModel::PageModel()
+    : hasPaywall(false), linkChars(0), linkDepth(0), h1State(0),
+      inHead(false), inTitle(false), inJsonLd(false) {
+}
 
 ContentExtractor::ContentExtractor() : maxTextLength(2000), maxQuoteLength(200) {
 }
@@ -10,6 +106,13 @@ ContentExtractor::~ContentExtractor() {
 }
 
 ExtractedContent ContentExtractor::Extract(const std::string& html, const std::string& url) {
+    // One pass over the markup; every stage works on the page model
+    PageModel page;
+    ParsePage(html, page);
+    return BuildContent(page, url);
+}
+
+ExtractedContent ContentExtractor::BuildContent(PageModel& page, const std::string& url) {
     ExtractedContent content;
     
     // Extract domain from URL
@@ -22,14 +125,16 @@ ExtractedContent ContentExtractor::Extract(const std::string& html, const std::s
     }
     
     // Extract metadata
-    content.title = ExtractTitle(html);
-    content.author = ExtractAuthor(html);
-    content.publishDate = ExtractPublishDate(html);
+    content.title = PageTitle(page);
+    content.author = page.meta.GetAuthor();
+    content.publishDate = page.meta.GetPublishDate();
+    
+    // Main text; steps/warnings/bullets come from the same region (not nav menus)
+    TextRange region;
+    std::string mainText = SelectMainText(page, region);
+    CollectStructure(page, region, content);
     
-    // Extract main content
-    std::string cleanHtml = RemoveScriptsAndStyles(html);
-    content.mainText = ExtractMainContent(cleanHtml);
-    content.mainText = CleanText(content.mainText);
+    content.mainText = CleanText(mainText);
     
     // Limit text length
     std::istringstream iss(content.mainText);
@@ -52,167 +157,590 @@ ExtractedContent ContentExtractor::Extract(const std::string& html, const std::s
     }
     
     // Extract quotes
-    auto quotes = ExtractQuotes(html, maxQuoteLength);
+    auto quotes = FindQuotes(page.text, maxQuoteLength);
     for (const auto& quote : quotes) {
         if (quote.text.length() > 20) {  // Skip very short quotes
-            content.quotes.push_back(quote.text);
+            content.quotes.push_back(quote);
         }
     }
     
     // Detect language (simplified)
     content.language = DetectLanguage(content.mainText);
     
-    // Check for paywall
-    content.hasPaywall = DetectPaywall(html);
+    content.hasPaywall = page.hasPaywall;
     
     return content;
 }
 
-std::string ContentExtractor::ExtractTitle(const std::string& html) {
-    // Try Open Graph title first
-    std::string ogTitle = GetMetaProperty(html, "og:title");
-    if (!ogTitle.empty()) return CleanText(ogTitle);
-    
-    // Try regular title tag
-    std::string title = FindBetween(html, "<title>", "</title>");
-    if (!title.empty()) return CleanText(title);
-    
-    // Try h1
-    std::string h1 = FindBetween(html, "<h1", "</h1>");
-    if (!h1.empty()) {
-        size_t contentStart = h1.find(">");
-        if (contentStart != std::string::npos) {
-            return CleanText(h1.substr(contentStart + 1));
-        }
+void ContentExtractor::ParsePage(const std::string& html, PageModel& page) {
+    page.text.reserve(html.length() / 4);
+    
+    HtmlTokenizer tokenizer(html);
+    HtmlToken token;
+    while (tokenizer.Next(token)) {
+        ConsumeToken(token, page);
     }
     
-    return "Untitled";
+    FinishPage(page);
 }
 
-std::string ContentExtractor::ExtractAuthor(const std::string& html) {
-    // Try meta author tag
-    std::string author = GetMetaTag(html, "author");
-    if (!author.empty()) return author;
+void ContentExtractor::FinishPage(PageModel& page) {
+    // Script cut off by the end of the document
+    if (page.inJsonLd) {
+        page.meta.AddJsonLd(page.jsonLd.data(), page.jsonLd.length());
+        page.inJsonLd = false;
+    }
     
-    // Try article:author
-    author = GetMetaProperty(html, "article:author");
-    if (!author.empty()) return author;
+    // Unclosed elements end with the document
+    while (!page.stack.empty()) {
+        CloseElement(page);
+    }
+}
+
+bool ContentExtractor::HasEnoughContent(const PageModel& page) const {
+    // Paywalled pages are dropped anyway
+    return page.hasPaywall ||
+           page.text.length() >= (size_t)maxTextLength * ENOUGH_TEXT_PER_WORD;
+}
+
+ExtractionStream::ExtractionStream(ContentExtractor* extractor, const std::string& url)
+    : extractor(extractor), url(url), tokenizer(nullptr, 0, false), bytesFed(0) {
+}
+
+bool ExtractionStream::Feed(const char* data, size_t length) {
+    bytesFed += length;
     
-    return "";
+    if (carry.empty()) {
+        Consume(data, length, false);
+    } else {
+        std::string buffer;
+        buffer.swap(carry);
+        buffer.append(data, length);
+        Consume(buffer.data(), buffer.length(), false);
+    }
+    
+    return !extractor->HasEnoughContent(page);
 }
 
-time_t ContentExtractor::ExtractPublishDate(const std::string& html) {
-    // Try article:published_time
-    std::string dateStr = GetMetaProperty(html, "article:published_time");
-    if (dateStr.empty()) {
-        dateStr = GetMetaProperty(html, "datePublished");
+ExtractedContent ExtractionStream::Finish() {
+    if (!carry.empty()) {
+        std::string buffer;
+        buffer.swap(carry);
+        Consume(buffer.data(), buffer.length(), true);
     }
     
-    // Would need proper date parsing here
-    // For now, return 0 (unknown)
-    return 0;
+    extractor->FinishPage(page);
+    return extractor->BuildContent(page, url);
 }
 
-std::string ContentExtractor::ExtractMainContent(const std::string& html) {
-    // Try <article> tag first
-    std::string article = FindBetween(html, "<article", "</article>");
-    if (!article.empty() && article.length() > 200) {
-        return StripHTML(article);
+void ExtractionStream::Consume(const char* data, size_t length, bool final) {
+    tokenizer.Reset(data, length, final);
+    
+    HtmlToken token;
+    while (tokenizer.Next(token)) {
+        extractor->ConsumeToken(token, page);
     }
     
-    // Try <main> tag
-    std::string main = FindBetween(html, "<main", "</main>");
-    if (!main.empty() && main.length() > 200) {
-        return StripHTML(main);
+    size_t offset = tokenizer.GetOffset();
+    if (!final && offset < length) {
+        carry.assign(data + offset, length - offset);
+    }
+}
+
+void ContentExtractor::ConsumeToken(const HtmlToken& token, PageModel& page) {
+    if (token.type == HTML_TEXT) {
+        if (page.inTitle) {
+            AppendNormalizedText(page.title, token.text.data, token.text.length, LINE_TEXT_FLAGS);
+            return;
+        }
+        if (page.inHead) return;
+        
+        if (!page.hasPaywall) page.hasPaywall = HasPaywallMarker(token.text);
+        AppendText(page, token.text);
+        return;
     }
     
-    // Find content blocks and select best one
-    auto blocks = FindContentBlocks(html);
-    if (!blocks.empty()) {
-        auto best = SelectBestBlock(blocks);
-        return StripHTML(best.content);
+    if (token.type == HTML_RAW_TEXT) {
+        if (page.inJsonLd && page.jsonLd.length() + token.text.length <= MAX_JSON_LD_BYTES) {
+            page.jsonLd.append(token.text.data, token.text.length);
+        }
+        return;
     }
     
-    // Fallback: extract all paragraphs
-    std::string result;
-    auto paragraphs = FindAllBetween(html, "<p", "</p>");
-    for (const auto& p : paragraphs) {
-        size_t contentStart = p.find(">");
-        if (contentStart != std::string::npos) {
-            result += StripHTML(p.substr(contentStart + 1)) + "\n\n";
+    const HtmlSpan& name = token.name;
+    
+    if (token.type == HTML_END_TAG) {
+        if (name.Equals("script") && page.inJsonLd) {
+            page.meta.AddJsonLd(page.jsonLd.data(), page.jsonLd.length());
+            page.jsonLd.clear();
+            page.inJsonLd = false;
+        }
+        if (name.Equals("title")) {
+            page.inTitle = false;
+            return;
+        }
+        if (name.Equals("head")) {
+            page.inHead = false;
+            return;
+        }
+        if (page.inHead) return;
+        
+        if (IsBlockTag(name)) AppendBreak(page);
+        
+        // Pop up to the matching element; stray end tags are ignored
+        for (size_t i = page.stack.size(); i > 0; i--) {
+            if (name.Equals(page.stack[i - 1].name.c_str())) {
+                while (page.stack.size() >= i) CloseElement(page);
+                break;
+            }
         }
+        return;
     }
     
-    return result;
+    // Start tags; metadata is collected wherever it appears
+    if (name.Equals("meta") || name.Equals("link") || name.Equals("time") || name.Equals("script")) {
+        ConsumeHeadTag(token, page);
+        if (!name.Equals("time") && !name.Equals("script")) return;
+    }
+    if (name.Equals("title")) {
+        page.inTitle = !token.selfClosing;
+        return;
+    }
+    if (name.Equals("head")) {
+        page.inHead = true;
+        return;
+    }
+    if (name.Equals("body")) page.inHead = false;
+    if (page.inHead) return;
+    
+    if (!page.hasPaywall) {
+        HtmlSpan value;
+        if ((HtmlTokenizer::GetAttribute(token, "class", value) && HasPaywallMarker(value)) ||
+            (HtmlTokenizer::GetAttribute(token, "id", value) && HasPaywallMarker(value))) {
+            page.hasPaywall = true;
+        }
+    }
+    
+    if (IsBlockTag(name)) {
+        AppendBreak(page);
+    } else if (name.Equals("td") || name.Equals("th")) {
+        AppendNormalizedText(page.text, " ", 1, BODY_TEXT_FLAGS);
+    }
+    
+    if (token.selfClosing || IsVoidTag(name)) return;
+    
+    // <p> and <li> are often left open before the next one
+    if ((name.Equals("p") || name.Equals("li")) && !page.stack.empty() &&
+        name.Equals(page.stack.back().name.c_str())) {
+        CloseElement(page);
+    }
+    
+    // Paragraph-like divs are the ones without block children
+    if (!page.stack.empty() && IsBlockTag(name)) {
+        page.stack.back().hasBlockChild = true;
+    }
+    
+    OpenElement element;
+    element.name = LowerName(name);
+    element.textStart = page.text.length();
+    element.linkStart = page.linkChars;
+    element.ordered = false;
+    element.hasBlockChild = false;
+    element.scored = false;
+    element.weight = ElementWeight(token);
+    element.contentScore = 0.0f;
+    
+    if (element.name == "li") {
+        for (size_t i = page.stack.size(); i > 0; i--) {
+            const std::string& parent = page.stack[i - 1].name;
+            if (parent == "ol" || parent == "ul") {
+                element.ordered = (parent == "ol");
+                break;
+            }
+        }
+    } else if (element.name == "a") {
+        page.linkDepth++;
+    } else if (element.name == "h1" && page.h1State == 0) {
+        page.h1State = 1;
+    }
+    
+    page.stack.push_back(element);
 }
 
-std::vector<ContentExtractor::ContentBlock> ContentExtractor::FindContentBlocks(const std::string& html) {
-    std::vector<ContentBlock> blocks;
+// <meta>, <link>, <time datetime> and ld+json <script> feed the metadata map
+void ContentExtractor::ConsumeHeadTag(const HtmlToken& token, PageModel& page) {
+    const HtmlSpan& name = token.name;
+    HtmlSpan key;
+    HtmlSpan value;
+    
+    if (name.Equals("meta")) {
+        if (!HtmlTokenizer::GetAttribute(token, "content", value)) return;
+        if (HtmlTokenizer::GetAttribute(token, "property", key) ||
+            HtmlTokenizer::GetAttribute(token, "name", key) ||
+            HtmlTokenizer::GetAttribute(token, "itemprop", key)) {
+            page.meta.Set(key.data, key.length, value.data, value.length);
+        }
+    } else if (name.Equals("link")) {
+        if (HtmlTokenizer::GetAttribute(token, "rel", key) &&
+            HtmlTokenizer::GetAttribute(token, "href", value)) {
+            std::string linkKey = "link:" + key.ToString();
+            page.meta.Set(linkKey.data(), linkKey.length(), value.data, value.length);
+        }
+    } else if (name.Equals("time")) {
+        if (HtmlTokenizer::GetAttribute(token, "datetime", value)) {
+            // Microdata <time itemprop="datePublished"> keeps its meaning
+            if (HtmlTokenizer::GetAttribute(token, "itemprop", key)) {
+                page.meta.Set(key.data, key.length, value.data, value.length);
+            }
+            page.meta.Set("time:datetime", strlen("time:datetime"), value.data, value.length);
+        }
+    } else if (name.Equals("script") && !token.selfClosing) {
+        page.inJsonLd = HtmlTokenizer::GetAttribute(token, "type", value) &&
+                        value.Contains("ld+json");
+        page.jsonLd.clear();
+    }
+}
+
+// Decoded and whitespace-collapsed as it is appended, so ranges and link
+// density are measured on the text that gets stored
+void ContentExtractor::AppendText(PageModel& page, const HtmlSpan& text) {
+    if (page.h1State == 1) {
+        AppendNormalizedText(page.h1, text.data, text.length, LINE_TEXT_FLAGS);
+    }
     
-    // Find all divs and other container elements
-    std::vector<std::string> tags = {"<div", "<section", "<article"};
+    size_t before = page.text.length();
+    AppendNormalizedText(page.text, text.data, text.length, BODY_TEXT_FLAGS);
+    if (page.linkDepth > 0) page.linkChars += page.text.length() - before;
+}
+
+void ContentExtractor::AppendBreak(PageModel& page) {
+    AppendNormalizedText(page.text, "\n", 1, BODY_TEXT_FLAGS);
+}
+
+// Pops the innermost open element and records what the stages need from it
+void ContentExtractor::CloseElement(PageModel& page) {
+    OpenElement element = page.stack.back();
+    page.stack.pop_back();
+    
+    TextRange range;
+    range.start = element.textStart;
+    range.end = page.text.length();
+    size_t length = range.end - range.start;
+    float linkDensity = length > 0 ?
+        (float)(page.linkChars - element.linkStart) / (float)length : 0.0f;
+    
+    const std::string& name = element.name;
+    if (name == "a") {
+        if (page.linkDepth > 0) page.linkDepth--;
+    } else if (name == "h1") {
+        if (page.h1State == 1) page.h1State = 2;
+    } else if (name == "li") {
+        ListItem item;
+        item.range = range;
+        item.ordered = element.ordered;
+        item.linkDensity = linkDensity;
+        page.listItems.push_back(item);
+    }
     
-    for (const auto& tag : tags) {
-        size_t pos = 0;
-        while (true) {
-            size_t start = html.find(tag, pos);
-            if (start == std::string::npos) break;
-            
-            size_t end = html.find("</", start);
-            if (end == std::string::npos) break;
-            
-            std::string blockContent = html.substr(start, end - start);
-            
-            ContentBlock block;
-            block.tag = tag;
-            block.content = blockContent;
-            block.textLength = CountWords(StripHTML(blockContent));
-            block.linkDensity = CalculateLinkDensity(blockContent);
-            
-            // Score block (more text, less links = better)
-            block.score = block.textLength * (1.0f - block.linkDensity);
-            
-            if (block.textLength > 50) {  // Minimum length threshold
-                blocks.push_back(block);
+    // Paragraphs feed their ancestors; a div holding only inline content counts as one
+    if (name == "p" || name == "pre" || name == "td" ||
+        ((name == "div" || name == "section") && !element.hasBlockChild)) {
+        ScoreParagraph(page, range);
+    }
+    
+    // Every scored element is a candidate; heavily linked ones lose out
+    if (element.scored) {
+        ContentBlock block;
+        block.range = range;
+        block.score = (element.contentScore + element.weight) * (1.0f - linkDensity);
+        if (block.score > 0.0f) {
+            page.candidates.push_back(block);
+        }
+    }
+}
+
+// Readability: 1 point, plus one per comma, plus one per 100 chars (max 3),
+// given in full to the parent, half to the grandparent and less further up
+void ContentExtractor::ScoreParagraph(PageModel& page, const TextRange& range) {
+    size_t length = range.end - range.start;
+    if (length < MIN_PARAGRAPH_CHARS) return;
+    
+    const char* text = page.text.data() + range.start;
+    int commas = (int)std::count(text, text + length, ',');
+    float score = 1.0f + commas + std::min(3.0f, length / 100.0f);
+    
+    for (int level = 0; level < SCORE_ANCESTOR_LEVELS && level < (int)page.stack.size(); level++) {
+        OpenElement& ancestor = page.stack[page.stack.size() - 1 - level];
+        float divider = level == 0 ? 1.0f : (level == 1 ? 2.0f : level * 3.0f);
+        ancestor.contentScore += score / divider;
+        ancestor.scored = true;
+    }
+}
+
+// Starting bias from the tag and its class/id names
+float ContentExtractor::ElementWeight(const HtmlToken& token) {
+    const HtmlSpan& name = token.name;
+    float weight = 0.0f;
+    
+    if (name.Equals("article") || name.Equals("main")) {
+        weight = 10.0f;
+    } else if (name.Equals("div")) {
+        weight = 5.0f;
+    } else if (name.Equals("pre") || name.Equals("td") || name.Equals("blockquote")) {
+        weight = 3.0f;
+    } else if (name.Equals("address") || name.Equals("ol") || name.Equals("ul") ||
+               name.Equals("dl") || name.Equals("dd") || name.Equals("dt") ||
+               name.Equals("li") || name.Equals("form")) {
+        weight = -3.0f;
+    } else if (name.Equals("th") || (name.length == 2 && tolower((unsigned char)name.data[0]) == 'h' &&
+                                     isdigit((unsigned char)name.data[1]))) {
+        weight = -5.0f;
+    } else if (name.Equals("nav") || name.Equals("aside") || name.Equals("footer")) {
+        weight = -CLASS_WEIGHT;
+    }
+    
+    const char* attributes[] = { "class", "id" };
+    for (int i = 0; i < 2; i++) {
+        HtmlSpan value;
+        if (!HtmlTokenizer::GetAttribute(token, attributes[i], value)) continue;
+        if (HasNegativeHint(value)) weight -= CLASS_WEIGHT;
+        if (HasPositiveHint(value)) weight += CLASS_WEIGHT;
+    }
+    
+    return weight;
+}
+
+std::string ContentExtractor::PageTitle(const PageModel& page) {
+    // Open Graph or JSON-LD headline first, then <title>, then the first <h1>
+    std::string title = page.meta.GetTitle();
+    if (title.empty()) title = CleanText(page.title);
+    if (title.empty()) title = CleanText(page.h1);
+    return title.empty() ? "Untitled" : title;
+}
+
+std::string ContentExtractor::ExtractTitle(const std::string& html) {
+    PageModel page;
+    ParsePage(html, page);
+    return PageTitle(page);
+}
+
+std::string ContentExtractor::ExtractAuthor(const std::string& html) {
+    PageModel page;
+    ParsePage(html, page);
+    return page.meta.GetAuthor();
+}
+
+time_t ContentExtractor::ExtractPublishDate(const std::string& html) {
+    PageModel page;
+    ParsePage(html, page);
+    return page.meta.GetPublishDate();
+}
+
+std::string ContentExtractor::ExtractMainContent(const std::string& html) {
+    PageModel page;
+    ParsePage(html, page);
+    
+    TextRange region;
+    return SelectMainText(page, region);
+}
+
+// Text of the best-scoring subtree, or the whole page when nothing scored
+std::string ContentExtractor::SelectMainText(const PageModel& page, TextRange& region) {
+    if (!FindMainRegion(page, region)) {
+        region.start = 0;
+        region.end = page.text.length();
+    }
+    return page.text.substr(region.start, region.end - region.start);
+}
+
+bool ContentExtractor::FindMainRegion(const PageModel& page, TextRange& region) {
+    const ContentBlock* best = nullptr;
+    for (const auto& candidate : page.candidates) {
+        if (!best || candidate.score > best->score) {
+            best = &candidate;
+        }
+    }
+    if (!best) return false;
+    
+    // Body split across sibling containers: the nearest enclosing candidate
+    // scores at least as well, so take it instead
+    bool climbed = true;
+    while (climbed) {
+        climbed = false;
+        const ContentBlock* parent = nullptr;
+        for (const auto& candidate : page.candidates) {
+            size_t length = candidate.range.end - candidate.range.start;
+            if (length <= best->range.end - best->range.start) continue;
+            if (candidate.range.start > best->range.start || candidate.range.end < best->range.end) continue;
+            if (!parent || length < parent->range.end - parent->range.start) {
+                parent = &candidate;
             }
-            
-            pos = end;
+        }
+        if (parent && parent->score >= best->score) {
+            best = parent;
+            climbed = true;
         }
     }
     
-    return blocks;
+    region = best->range;
+    return true;
+}
+
+void ContentExtractor::ExtractStructure(const std::string& html, ExtractedContent& content) {
+    PageModel page;
+    ParsePage(html, page);
+    
+    TextRange all;
+    all.start = 0;
+    all.end = page.text.length();
+    CollectStructure(page, all, content);
 }
 
-ContentExtractor::ContentBlock ContentExtractor::SelectBestBlock(const std::vector<ContentBlock>& blocks) {
-    ContentBlock best;
-    best.score = 0.0f;
+void ContentExtractor::CollectStructure(const PageModel& page, const TextRange& region,
+                                        ExtractedContent& content) {
+    for (const auto& item : page.listItems) {
+        if (item.range.start < region.start || item.range.end > region.end) continue;
+        
+        // Ordered lists are explicit steps; unordered become bullets
+        // (link-only items are navigation)
+        if (item.ordered ? content.steps.size() >= MAX_STEPS :
+                           content.bullets.size() >= MAX_BULLETS) {
+            continue;
+        }
+        if (!item.ordered && item.linkDensity > 0.5f) continue;
+        
+        std::string text = CleanText(page.text.substr(item.range.start,
+                                                      item.range.end - item.range.start));
+        if (CountWords(text) < 2) continue;
+        
+        if (item.ordered) {
+            content.steps.push_back(text);
+        } else {
+            content.bullets.push_back(text);
+        }
+    }
     
-    for (const auto& block : blocks) {
-        if (block.score > best.score) {
-            best = block;
+    std::string text = page.text.substr(region.start, region.end - region.start);
+    
+    // Plain-text numbering when the page has no <ol>
+    if (content.steps.empty()) {
+        content.steps = FindNumberedSteps(text);
+    }
+    
+    content.warnings = FindWarnings(text);
+}
+
+std::vector<std::string> ContentExtractor::FindNumberedSteps(const std::string& text) {
+    std::vector<std::string> steps;
+    std::istringstream iss(text);
+    std::string line;
+    int expected = 1;
+    
+    while (std::getline(iss, line) && steps.size() < MAX_STEPS) {
+        line = CleanText(line);
+        if (line.empty()) continue;
+        
+        // "Step 3: ..." / "step 3 - ..."
+        size_t pos = 0;
+        if (line.length() > 5 && strncasecmp(line.c_str(), "step ", 5) == 0) {
+            pos = 5;
         }
+        
+        // "3. ..." / "3) ..."
+        size_t digitsEnd = pos;
+        while (digitsEnd < line.length() && isdigit((unsigned char)line[digitsEnd])) digitsEnd++;
+        if (digitsEnd == pos || digitsEnd - pos > 2) continue;
+        
+        int number = atoi(line.c_str() + pos);
+        if (number != expected) continue;
+        
+        size_t rest = digitsEnd;
+        if (rest < line.length() && (line[rest] == '.' || line[rest] == ')' || line[rest] == ':')) {
+            rest++;
+        } else if (pos == 0) {
+            continue;  // Bare numbers ("2024 was...") are not steps
+        }
+        while (rest < line.length() && (line[rest] == ' ' || line[rest] == '-')) rest++;
+        if (rest >= line.length()) continue;
+        
+        steps.push_back(line.substr(rest));
+        expected++;
     }
     
-    return best;
+    return steps;
+}
+
+std::vector<std::string> ContentExtractor::FindWarnings(const std::string& text) {
+    static const char* labels[] = {"warning", "caution", "danger", "important"};
+    static const char* imperatives[] = {"do not ", "don't ", "never "};
+    
+    std::vector<std::string> warnings;
+    std::string sentence;
+    
+    for (size_t i = 0; i <= text.length() && warnings.size() < MAX_WARNINGS; i++) {
+        char c = (i < text.length()) ? text[i] : '\n';
+        bool boundary = (c == '\n' || c == '!' || c == '?' ||
+                        (c == '.' && (i + 1 >= text.length() || isspace((unsigned char)text[i + 1]))));
+        
+        if (!boundary) {
+            sentence += c;
+            continue;
+        }
+        if (c != '\n') sentence += c;
+        
+        std::string clean = CleanText(sentence);
+        sentence.clear();
+        if (clean.length() < 15 || clean.length() > 300) continue;
+        
+        std::string lower = clean;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        
+        // "Warning: ..." - keep the text after the label
+        bool matched = false;
+        for (const char* label : labels) {
+            size_t len = strlen(label);
+            if (lower.compare(0, len, label) == 0 && lower.length() > len &&
+                (lower[len] == ':' || lower[len] == '!' || lower[len] == ' ')) {
+                size_t start = clean.find_first_not_of(":! ", len);
+                if (start != std::string::npos) {
+                    warnings.push_back(clean.substr(start));
+                }
+                matched = true;
+                break;
+            }
+        }
+        if (matched) continue;
+        
+        for (const char* imperative : imperatives) {
+            if (lower.compare(0, strlen(imperative), imperative) == 0) {
+                warnings.push_back(clean);
+                break;
+            }
+        }
+    }
+    
+    return warnings;
 }
 
 std::vector<Quote> ContentExtractor::ExtractQuotes(const std::string& html, int maxLength) {
+    return FindQuotes(StripHTML(html), maxLength);
+}
+
+std::vector<Quote> ContentExtractor::FindQuotes(const std::string& text, int maxLength) {
     std::vector<Quote> quotes;
     
-    std::string text = StripHTML(html);
-    
     // Find text in regular quotes
     auto regularQuotes = FindQuotedText(text, "\"", "\"");
     quotes.insert(quotes.end(), regularQuotes.begin(), regularQuotes.end());
     
     // Find text in curly quotes
-    auto curlyQuotes = FindQuotedText(text, """, """);
+    auto curlyQuotes = FindQuotedText(text, "\xE2\x80\x9C", "\xE2\x80\x9D");
     quotes.insert(quotes.end(), curlyQuotes.begin(), curlyQuotes.end());
     
     // Filter by length
     quotes.erase(
         std::remove_if(quotes.begin(), quotes.end(),
-            [maxLength](const Quote& q) { return q.text.length() > maxLength; }),
+            [maxLength](const Quote& q) { return (int)q.text.length() > maxLength; }),
         quotes.end()
     );
     
@@ -236,6 +764,7 @@ std::vector<Quote> ContentExtractor::FindQuotedText(const std::string& text,
         quote.text = text.substr(start + openQuote.length(), end - start - openQuote.length());
         quote.position = start;
         quote.context = GetQuoteContext(text, start, 10);
+        quote.speaker = FindSpeaker(text, start, end + closeQuote.length());
         
         quotes.push_back(quote);
         pos = end + closeQuote.length();
@@ -267,87 +796,142 @@ std::string ContentExtractor::GetQuoteContext(const std::string& text, int posit
     return text.substr(start, end - start);
 }
 
-std::string ContentExtractor::StripHTML(const std::string& html) {
-    std::string result;
-    bool inTag = false;
-    bool inScript = false;
-    bool inStyle = false;
-    
-    for (size_t i = 0; i < html.length(); i++) {
-        if (html[i] == '<') {
-            inTag = true;
-            
-            // Check for script/style tags
-            if (html.substr(i, 7) == "<script") inScript = true;
-            if (html.substr(i, 6) == "<style") inStyle = true;
-            if (html.substr(i, 9) == "</script>") inScript = false;
-            if (html.substr(i, 8) == "</style>") inStyle = false;
-        } else if (html[i] == '>') {
-            inTag = false;
-        } else if (!inTag && !inScript && !inStyle) {
-            result += html[i];
-        }
+// Attribution verbs used by FindSpeaker ("..., the director said")
+static bool IsAttributionVerb(const std::string& word) {
+    static const char* verbs[] = {
+        "said", "says", "told", "stated", "added", "explained",
+        "warned", "urged", "wrote", "announced", nullptr
+    };
+    for (int i = 0; verbs[i]; i++) {
+        if (strcasecmp(word.c_str(), verbs[i]) == 0) return true;
     }
-    
-    return result;
+    return false;
 }
 
-std::string ContentExtractor::RemoveScriptsAndStyles(const std::string& html) {
-    std::string result = html;
+// Words of a short attribution clause, punctuation trimmed
+static std::vector<std::string> ClauseWords(const std::string& clause) {
+    std::vector<std::string> words;
+    std::istringstream iss(clause);
+    std::string word;
+    while (iss >> word) {
+        size_t start = 0;
+        size_t end = word.length();
+        while (start < end && ispunct((unsigned char)word[start])) start++;
+        while (end > start && ispunct((unsigned char)word[end - 1])) end--;
+        if (end > start) words.push_back(word.substr(start, end - start));
+    }
+    return words;
+}
+
+// Joins up to 5 name words, dropping a leading article; pronouns don't count
+static std::string JoinSpeaker(const std::vector<std::string>& words, size_t begin, size_t end) {
+    if (begin < end && (strcasecmp(words[begin].c_str(), "the") == 0 ||
+                        strcasecmp(words[begin].c_str(), "a") == 0)) {
+        begin++;
+    }
+    if (end - begin > 5 || begin >= end) return "";
     
-    // Remove scripts
-    size_t pos = 0;
-    while ((pos = result.find("<script", pos)) != std::string::npos) {
-        size_t end = result.find("</script>", pos);
-        if (end == std::string::npos) break;
-        result.erase(pos, end - pos + 9);
+    std::string speaker;
+    for (size_t i = begin; i < end; i++) {
+        if (!speaker.empty()) speaker += " ";
+        speaker += words[i];
     }
     
-    // Remove styles
-    pos = 0;
-    while ((pos = result.find("<style", pos)) != std::string::npos) {
-        size_t end = result.find("</style>", pos);
-        if (end == std::string::npos) break;
-        result.erase(pos, end - pos + 8);
+    static const char* pronouns[] = { "he", "she", "they", "it", "we", "i", nullptr };
+    for (int i = 0; pronouns[i]; i++) {
+        if (strcasecmp(speaker.c_str(), pronouns[i]) == 0) return "";
+    }
+    return speaker;
+}
+
+std::string ContentExtractor::FindSpeaker(const std::string& text, size_t quoteStart, size_t quoteEnd) {
+    const size_t window = 120;
+    
+    // After the quote: "...," the FEMA administrator said. / "...," said Jane Doe.
+    size_t stop = quoteEnd;
+    while (stop < text.length() && stop - quoteEnd < window &&
+           strchr(".!?\n\"", text[stop]) == nullptr) {
+        stop++;
+    }
+    std::vector<std::string> after = ClauseWords(text.substr(quoteEnd, stop - quoteEnd));
+    if (!after.empty() && IsAttributionVerb(after[0])) {
+        std::string speaker = JoinSpeaker(after, 1, std::min(after.size(), size_t(6)));
+        if (!speaker.empty()) return speaker;
+    }
+    for (size_t i = 1; i < after.size() && i <= 6; i++) {
+        if (IsAttributionVerb(after[i])) {
+            std::string speaker = JoinSpeaker(after, 0, i);
+            if (!speaker.empty()) return speaker;
+            break;
+        }
     }
     
-    return result;
+    // Before the quote: The director said: "..." / According to Jane Doe, "..."
+    size_t begin = quoteStart > window ? quoteStart - window : 0;
+    size_t boundary = text.find_last_of(".!?\n\"", quoteStart > 0 ? quoteStart - 1 : 0);
+    if (boundary != std::string::npos && boundary >= begin && boundary < quoteStart) {
+        begin = boundary + 1;
+    }
+    std::vector<std::string> before = ClauseWords(text.substr(begin, quoteStart - begin));
+    if (!before.empty() && IsAttributionVerb(before.back())) {
+        size_t end = before.size() - 1;
+        return JoinSpeaker(before, end > 5 ? end - 5 : 0, end);
+    }
+    for (size_t i = 0; i + 2 < before.size(); i++) {
+        if (strcasecmp(before[i].c_str(), "according") == 0 &&
+            strcasecmp(before[i + 1].c_str(), "to") == 0) {
+            return JoinSpeaker(before, i + 2, before.size());
+        }
+    }
+    
+    return "";
 }
 
-std::string ContentExtractor::CleanText(const std::string& text) {
+std::string ContentExtractor::StripHTML(const std::string& html) {
     std::string result;
-    bool lastWasSpace = false;
-    
-    for (char c : text) {
-        if (isspace(c)) {
-            if (!lastWasSpace) {
-                result += ' ';
-                lastWasSpace = true;
-            }
-        } else {
-            result += c;
-            lastWasSpace = false;
+    result.reserve(html.length() / 2);
+    
+    HtmlTokenizer tokenizer(html);
+    HtmlToken token;
+    while (tokenizer.Next(token)) {
+        if (token.type == HTML_TEXT) {
+            AppendNormalizedText(result, token.text.data, token.text.length, BODY_TEXT_FLAGS);
+        } else if (token.type != HTML_RAW_TEXT && IsBlockTag(token.name)) {
+            AppendNormalizedText(result, "\n", 1, BODY_TEXT_FLAGS);
         }
     }
     
-    // Trim
-    size_t start = result.find_first_not_of(" \t\n\r");
-    size_t end = result.find_last_not_of(" \t\n\r");
-    if (start != std::string::npos && end != std::string::npos) {
-        return result.substr(start, end - start + 1);
+    return result;
+}
+
+std::string ContentExtractor::RemoveScriptsAndStyles(const std::string& html) {
+    std::string result;
+    result.reserve(html.length());
+    
+    HtmlTokenizer tokenizer(html);
+    HtmlToken token;
+    while (tokenizer.Next(token)) {
+        if (token.type == HTML_RAW_TEXT) continue;
+        if (token.type != HTML_TEXT &&
+            (token.name.Equals("script") || token.name.Equals("style") ||
+             token.name.Equals("noscript") || token.name.Equals("template"))) {
+            continue;
+        }
+        result.append(token.raw.data, token.raw.length);
     }
     
     return result;
 }
 
+std::string ContentExtractor::CleanText(const std::string& text) {
+    // Collapse only: text reaching here is already entity-decoded
+    return NormalizeText(text, TEXT_COLLAPSE_SPACE);
+}
+
 bool ContentExtractor::DetectPaywall(const std::string& html) {
-    // Simple paywall detection
-    std::string lower = html;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-    
-    return (lower.find("paywall") != std::string::npos ||
-            lower.find("subscriber only") != std::string::npos ||
-            lower.find("subscribe to read") != std::string::npos);
+    PageModel page;
+    ParsePage(html, page);
+    return page.hasPaywall;
 }
 
 std::string ContentExtractor::DetectLanguage(const std::string& text) {
@@ -362,82 +946,3 @@ int ContentExtractor::CountWords(const std::string& text) {
     while (iss >> word) count++;
     return count;
 }
-
-float ContentExtractor::CalculateLinkDensity(const std::string& html) {
-    int totalChars = html.length();
-    if (totalChars == 0) return 0.0f;
-    
-    int linkChars = 0;
-    size_t pos = 0;
-    while ((pos = html.find("<a ", pos)) != std::string::npos) {
-        size_t end = html.find("</a>", pos);
-        if (end == std::string::npos) break;
-        linkChars += (end - pos);
-        pos = end;
-    }
-    
-    return (float)linkChars / (float)totalChars;
-}
-
-std::string ContentExtractor::FindBetween(const std::string& str, 
-                                         const std::string& start, 
-                                         const std::string& end) {
-    size_t startPos = str.find(start);
-    if (startPos == std::string::npos) return "";
-    
-    startPos += start.length();
-    size_t endPos = str.find(end, startPos);
-    if (endPos == std::string::npos) return "";
-    
-    return str.substr(startPos, endPos - startPos);
-}
-
-std::vector<std::string> ContentExtractor::FindAllBetween(const std::string& str,
-                                                          const std::string& start,
-                                                          const std::string& end) {
-    std::vector<std::string> results;
-    size_t pos = 0;
-    
-    while (true) {
-        size_t startPos = str.find(start, pos);
-        if (startPos == std::string::npos) break;
-        
-        size_t endPos = str.find(end, startPos);
-        if (endPos == std::string::npos) break;
-        
-        results.push_back(str.substr(startPos, endPos - startPos + end.length()));
-        pos = endPos + end.length();
-    }
-    
-    return results;
-}
-
-std::string ContentExtractor::GetMetaTag(const std::string& html, const std::string& name) {
-    std::string search = "name=\"" + name + "\"";
-    size_t pos = html.find(search);
-    if (pos == std::string::npos) return "";
-    
-    size_t contentPos = html.find("content=\"", pos);
-    if (contentPos == std::string::npos) return "";
-    
-    contentPos += 9;
-    size_t endPos = html.find("\"", contentPos);
-    if (endPos == std::string::npos) return "";
-    
-    return html.substr(contentPos, endPos - contentPos);
-}
-
-std::string ContentExtractor::GetMetaProperty(const std::string& html, const std::string& property) {
-    std::string search = "property=\"" + property + "\"";
-    size_t pos = html.find(search);
-    if (pos == std::string::npos) return "";
-    
-    size_t contentPos = html.find("content=\"", pos);
-    if (contentPos == std::string::npos) return "";
-    
-    contentPos += 9;
-    size_t endPos = html.find("\"", contentPos);
-    if (endPos == std::string::npos) return "";
-    
-    return html.substr(contentPos, endPos - contentPos);
-}
@@ -0,0 +1,276 @@
+#include "html_tokenizer.h"
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+// Elements whose contents are never markup we want to see
+static const char* RAW_TEXT_TAGS[] = { "script", "style", "noscript", "template", nullptr };
+
+static bool IsNameChar(char c) {
+    return isalnum((unsigned char)c) || c == '-' || c == ':' || c == '_';
+}
+
+// Offset of marker in data[from, length), or length when absent
+static size_t FindMarker(const char* data, size_t from, size_t length, const char* marker) {
+    size_t markerLength = strlen(marker);
+    while (from + markerLength <= length) {
+        const char* hit = static_cast<const char*>(memchr(data + from, marker[0], length - from));
+        if (!hit) break;
+        
+        size_t at = hit - data;
+        if (at + markerLength <= length && memcmp(hit, marker, markerLength) == 0) return at;
+        from = at + 1;
+    }
+    return length;
+}
+
+bool HtmlSpan::Equals(const char* str) const {
+    size_t len = strlen(str);
+    return len == length && strncasecmp(data, str, len) == 0;
+}
+
+bool HtmlSpan::Contains(const char* needle) const {
+    size_t len = strlen(needle);
+    if (len == 0) return true;
+    if (len > length) return false;
+    
+    char first = tolower((unsigned char)needle[0]);
+    for (size_t i = 0; i + len <= length; i++) {
+        if (tolower((unsigned char)data[i]) == first &&
+            strncasecmp(data + i, needle, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HtmlTokenizer::HtmlTokenizer(const char* data, size_t length, bool final)
+    : data(data), length(length), pos(0), final(final) {
+    rawTag[0] = '\0';
+}
+
+HtmlTokenizer::HtmlTokenizer(const std::string& html)
+    : data(html.data()), length(html.length()), pos(0), final(true) {
+    rawTag[0] = '\0';
+}
+
+void HtmlTokenizer::Reset(const char* data, size_t length, bool final) {
+    this->data = data;
+    this->length = length;
+    this->final = final;
+    pos = 0;
+}
+
+bool HtmlTokenizer::Next(HtmlToken& token) {
+    while (pos < length) {
+        if (rawTag[0]) {
+            if (ReadRawText(token)) return true;
+            if (rawTag[0]) return false;  // Rest of the body needs more input
+            continue;
+        }
+        
+        if (data[pos] != '<') {
+            return ReadText(token, pos);
+        }
+        
+        size_t start = pos;
+        if (ReadTag(token)) return true;
+        if (pos == start) return false;  // Partial markup, wait for more
+    }
+    return false;
+}
+
+// Body of the raw-text element up to its "</name"; false when empty
+bool HtmlTokenizer::ReadRawText(HtmlToken& token) {
+    size_t nameLength = strlen(rawTag);
+    size_t start = pos;
+    size_t end = length;
+    bool closed = false;
+    
+    size_t scan = pos;
+    while (scan < length) {
+        const char* lt = static_cast<const char*>(memchr(data + scan, '<', length - scan));
+        if (!lt) break;
+        
+        size_t at = lt - data;
+        if (at + 2 + nameLength <= length && data[at + 1] == '/' &&
+            strncasecmp(data + at + 2, rawTag, nameLength) == 0 &&
+            (at + 2 + nameLength == length || !IsNameChar(data[at + 2 + nameLength]))) {
+            end = at;
+            closed = true;
+            break;
+        }
+        scan = at + 1;
+    }
+    
+    if (!closed && !final) {
+        // Hold back enough of the tail for a "</name" split across buffers
+        size_t keep = nameLength + 2;
+        end = length > start + keep ? length - keep : start;
+    }
+    if (closed || final) rawTag[0] = '\0';
+    
+    pos = end;
+    if (end == start) return false;
+    
+    token.type = HTML_RAW_TEXT;
+    token.raw = HtmlSpan(data + start, end - start);
+    token.text = token.raw;
+    token.name = HtmlSpan();
+    token.attributes = HtmlSpan();
+    token.selfClosing = false;
+    return true;
+}
+
+bool HtmlTokenizer::ReadText(HtmlToken& token, size_t from) {
+    const char* lt = from < length ?
+        static_cast<const char*>(memchr(data + from, '<', length - from)) : nullptr;
+    size_t end = lt ? (size_t)(lt - data) : length;
+    
+    // Unterminated text in a partial buffer: stop after the last whitespace
+    // so entities and UTF-8 sequences are never split
+    if (!lt && !final) {
+        while (end > from && !isspace((unsigned char)data[end - 1])) end--;
+        if (end <= pos) return false;
+    }
+    
+    token.type = HTML_TEXT;
+    token.raw = HtmlSpan(data + pos, end - pos);
+    token.text = token.raw;
+    token.name = HtmlSpan();
+    token.attributes = HtmlSpan();
+    token.selfClosing = false;
+    pos = end;
+    return true;
+}
+
+// Reads the markup at data[pos] == '<'; false when it was skipped
+bool HtmlTokenizer::ReadTag(HtmlToken& token) {
+    size_t p = pos + 1;
+    
+    if (p < length && (data[p] == '!' || data[p] == '?')) {
+        if (length - p >= 3 && strncmp(data + p, "!--", 3) == 0) {
+            size_t close = FindMarker(data, p + 3, length, "-->");
+            if (close >= length && !final) return false;
+            pos = close < length ? close + 3 : length;
+            return false;
+        }
+        if (length - p >= 8 && strncmp(data + p, "![CDATA[", 8) == 0) {
+            size_t start = p + 8;
+            size_t end = FindMarker(data, start, length, "]]>");
+            if (end >= length && !final) return false;
+            size_t after = end < length ? end + 3 : length;
+            
+            token.type = HTML_TEXT;
+            token.raw = HtmlSpan(data + pos, after - pos);
+            token.text = HtmlSpan(data + start, end - start);
+            token.name = HtmlSpan();
+            token.attributes = HtmlSpan();
+            token.selfClosing = false;
+            pos = after;
+            return true;
+        }
+        
+        // <!DOCTYPE ...>, <?xml ...?>
+        const char* gt = static_cast<const char*>(memchr(data + p, '>', length - p));
+        if (!gt && !final) return false;
+        pos = gt ? (size_t)(gt - data) + 1 : length;
+        return false;
+    }
+    
+    bool endTag = (p < length && data[p] == '/');
+    if (endTag) p++;
+    
+    // A '<' that doesn't open a tag ("a < b") is just text
+    if (p >= length && !final) return false;
+    if (p >= length || !isalpha((unsigned char)data[p])) {
+        return ReadText(token, pos + 1);
+    }
+    
+    size_t nameStart = p;
+    while (p < length && IsNameChar(data[p])) p++;
+    size_t nameEnd = p;
+    
+    // Find the closing '>' outside quoted attribute values
+    char quote = 0;
+    char last = 0;
+    while (p < length) {
+        char c = data[p];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if ((c == '"' || c == '\'') && last == '=') {
+            quote = c;
+        } else if (c == '>') {
+            break;
+        }
+        if (!isspace((unsigned char)c)) last = c;
+        p++;
+    }
+    if (p >= length) {
+        if (final) pos = length;  // Truncated tag
+        return false;
+    }
+    
+    size_t attrEnd = p;
+    bool selfClosing = attrEnd > nameEnd && data[attrEnd - 1] == '/';
+    if (selfClosing) attrEnd--;
+    
+    token.type = endTag ? HTML_END_TAG : HTML_START_TAG;
+    token.raw = HtmlSpan(data + pos, p + 1 - pos);
+    token.name = HtmlSpan(data + nameStart, nameEnd - nameStart);
+    token.attributes = HtmlSpan(data + nameEnd, attrEnd - nameEnd);
+    token.text = HtmlSpan();
+    token.selfClosing = selfClosing;
+    pos = p + 1;
+    
+    if (!endTag && !selfClosing) {
+        for (int i = 0; RAW_TEXT_TAGS[i]; i++) {
+            if (token.name.Equals(RAW_TEXT_TAGS[i])) {
+                strcpy(rawTag, RAW_TEXT_TAGS[i]);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool HtmlTokenizer::GetAttribute(const HtmlToken& token, const char* name, HtmlSpan& value) {
+    const char* p = token.attributes.data;
+    const char* end = p + token.attributes.length;
+    if (!p) return false;
+    
+    while (p < end) {
+        while (p < end && (isspace((unsigned char)*p) || *p == '/')) p++;
+        
+        const char* nameStart = p;
+        while (p < end && !isspace((unsigned char)*p) && *p != '=') p++;
+        HtmlSpan attrName(nameStart, p - nameStart);
+        
+        while (p < end && isspace((unsigned char)*p)) p++;
+        
+        HtmlSpan attrValue(p, 0);
+        if (p < end && *p == '=') {
+            p++;
+            while (p < end && isspace((unsigned char)*p)) p++;
+            
+            if (p < end && (*p == '"' || *p == '\'')) {
+                char quote = *p++;
+                const char* valueStart = p;
+                while (p < end && *p != quote) p++;
+                attrValue = HtmlSpan(valueStart, p - valueStart);
+                if (p < end) p++;
+            } else {
+                const char* valueStart = p;
+                while (p < end && !isspace((unsigned char)*p)) p++;
+                attrValue = HtmlSpan(valueStart, p - valueStart);
+            }
+        }
+        
+        if (!attrName.Empty() && attrName.Equals(name)) {
+            value = attrValue;
+            return true;
+        }
+        if (p == nameStart) p++;
+    }
+    return false;
+}
@@ -0,0 +1,599 @@
+#include "page_metadata.h"
+#include "text_normalize.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+static const size_t MAX_ENTRIES = 64;
+static const size_t MAX_VALUE_LENGTH = 1024;
+static const int MAX_JSON_DEPTH = 32;
+
+// Publish date keys, most trustworthy first; modified dates are the fallback
+static const char* PUBLISHED_KEYS[] = {
+    "ld:datepublished", "article:published_time", "datepublished", "pubdate",
+    "publishdate", "date", "dc.date", "dc.date.issued", "dcterms.created",
+    "sailthru.date", "parsely-pub-date", "time:datetime",
+    "ld:datemodified", "article:modified_time", "og:updated_time", "datemodified",
+    nullptr
+};
+
+static const char* AUTHOR_KEYS[] = {
+    "ld:author", "author", "article:author", "parsely-author", "byl",
+    "dc.creator", "sailthru.author", nullptr
+};
+
+static const char* MONTH_NAMES[] = {
+    "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"
+};
+
+// Date parsing
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar
+static long DaysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+namespace {
+
+// Read position in a date string
+struct DateCursor {
+    const char* p;
+    const char* end;
+    
+    char Peek() const { return p < end ? *p : '\0'; }
+    
+    bool Skip(char c) {
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+    
+    void SkipSeparators() {
+        while (p < end && (isspace((unsigned char)*p) || *p == ',')) p++;
+    }
+    
+    // Between minDigits and maxDigits digits; -1 when fewer
+    int Number(int minDigits, int maxDigits) {
+        int value = 0;
+        int digits = 0;
+        while (p < end && digits < maxDigits && isdigit((unsigned char)*p)) {
+            value = value * 10 + (*p - '0');
+            p++;
+            digits++;
+        }
+        return digits >= minDigits ? value : -1;
+    }
+    
+    // Letters at the cursor (the word is consumed)
+    size_t Word(const char*& start) {
+        start = p;
+        while (p < end && isalpha((unsigned char)*p)) p++;
+        return p - start;
+    }
+};
+    
+}  // namespace
+
+// 1-12 for a month name or abbreviation, 0 otherwise
+static int MonthFromName(const char* word, size_t length) {
+    if (length < 3) return 0;
+    for (int i = 0; i < 12; i++) {
+        if (strncasecmp(word, MONTH_NAMES[i], 3) == 0) return i + 1;
+    }
+    return 0;
+}
+
+// "Z", "GMT", US zone names, "+0200" or "-05:00"; false when unrecognized
+static bool ParseZone(DateCursor& cursor, int& offsetSeconds) {
+    offsetSeconds = 0;
+    while (cursor.p < cursor.end && isspace((unsigned char)*cursor.p)) cursor.p++;
+    
+    char sign = cursor.Peek();
+    if (sign == '+' || sign == '-') {
+        cursor.p++;
+        int hours = cursor.Number(2, 2);
+        if (hours < 0) return false;
+        cursor.Skip(':');
+        int minutes = cursor.Number(2, 2);
+        if (minutes < 0) minutes = 0;
+        offsetSeconds = (hours * 60 + minutes) * 60;
+        if (sign == '-') offsetSeconds = -offsetSeconds;
+        return true;
+    }
+    
+    const char* word;
+    size_t length = cursor.Word(word);
+    if (length == 0) return true;  // No zone: UTC
+    
+    static const struct { const char* name; int hours; } zones[] = {
+        { "z", 0 }, { "gmt", 0 }, { "ut", 0 }, { "utc", 0 },
+        { "est", -5 }, { "edt", -4 }, { "cst", -6 }, { "cdt", -5 },
+        { "mst", -7 }, { "mdt", -6 }, { "pst", -8 }, { "pdt", -7 }
+    };
+    for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); i++) {
+        if (strlen(zones[i].name) == length && strncasecmp(word, zones[i].name, length) == 0) {
+            offsetSeconds = zones[i].hours * 3600;
+            if (zones[i].hours == 0 && length > 1) {
+                // GMT+2 / UTC-05:00
+                int extra = 0;
+                char next = cursor.Peek();
+                if ((next == '+' || next == '-') && ParseZone(cursor, extra)) {
+                    offsetSeconds = extra;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// "10:30", "10:30:00.123", "10:30 PM"; hour is -1 when no time is present
+static bool ParseClock(DateCursor& cursor, int& hour, int& minute, int& second) {
+    hour = -1;
+    minute = 0;
+    second = 0;
+    if (!isdigit((unsigned char)cursor.Peek())) return true;
+    
+    hour = cursor.Number(1, 2);
+    if (!cursor.Skip(':')) return false;
+    minute = cursor.Number(2, 2);
+    if (minute < 0) return false;
+    if (cursor.Skip(':')) {
+        second = cursor.Number(2, 2);
+        if (second < 0) return false;
+    }
+    if (cursor.Skip('.') || cursor.Skip(',')) {
+        while (isdigit((unsigned char)cursor.Peek())) cursor.p++;
+    }
+    
+    // 12-hour clock
+    DateCursor peek = cursor;
+    while (peek.p < peek.end && isspace((unsigned char)*peek.p)) peek.p++;
+    const char* word;
+    size_t length = peek.Word(word);
+    if (length == 2 && tolower((unsigned char)word[1]) == 'm') {
+        char half = tolower((unsigned char)word[0]);
+        if (half == 'a' || half == 'p') {
+            if (hour == 12) hour = 0;
+            if (half == 'p') hour += 12;
+            cursor = peek;
+        }
+    }
+    return true;
+}
+
+static time_t MakeTime(int year, int month, int day, int hour, int minute, int second, int offsetSeconds) {
+    if (year < 1970 || year > 2100 || month < 1 || month > 12 || day < 1 || day > 31) return 0;
+    if (hour < 0) hour = 0;
+    if (hour > 23 || minute > 59 || second > 60) return 0;
+    
+    long long seconds = (long long)DaysFromCivil(year, month, day) * 86400 +
+                        hour * 3600 + minute * 60 + second - offsetSeconds;
+    return seconds > 0 ? (time_t)seconds : 0;
+}
+
+// 2024-06-15[T10:30[:00[.000]]][Z|+02:00]
+static time_t ParseIsoDate(DateCursor& cursor) {
+    int year = cursor.Number(4, 4);
+    if (year < 0 || !cursor.Skip('-')) return 0;
+    int month = cursor.Number(1, 2);
+    if (month < 0 || !cursor.Skip('-')) return 0;
+    int day = cursor.Number(1, 2);
+    if (day < 0) return 0;
+    
+    int hour = -1, minute = 0, second = 0, offset = 0;
+    char separator = cursor.Peek();
+    if ((separator == 'T' || separator == 't' || separator == ' ') &&
+        cursor.p + 1 < cursor.end && isdigit((unsigned char)cursor.p[1])) {
+        cursor.p++;
+        if (!ParseClock(cursor, hour, minute, second)) return 0;
+        if (!ParseZone(cursor, offset)) offset = 0;
+    }
+    return MakeTime(year, month, day, hour, minute, second, offset);
+}
+
+// [Sat,] 15 Jun 2024 10:30:00 GMT, or June 15, 2024 [10:30 AM]
+static time_t ParseTextDate(DateCursor& cursor) {
+    const char* word;
+    size_t length = cursor.Word(word);
+    int month = MonthFromName(word, length);
+    if (length > 0 && month == 0) {
+        // Day name
+        cursor.SkipSeparators();
+        length = cursor.Word(word);
+        month = MonthFromName(word, length);
+        if (length > 0 && month == 0) return 0;
+    }
+    cursor.Skip('.');
+    cursor.SkipSeparators();
+    
+    int day = cursor.Number(1, 2);
+    if (day < 0) return 0;
+    while (cursor.Peek() == '-' || isspace((unsigned char)cursor.Peek())) cursor.p++;
+    
+    if (month == 0) {
+        length = cursor.Word(word);
+        month = MonthFromName(word, length);
+        if (month == 0) return 0;
+        cursor.Skip('.');
+        while (cursor.Peek() == '-' || isspace((unsigned char)cursor.Peek())) cursor.p++;
+    } else {
+        // "June 15th, 2024"
+        cursor.Word(word);
+    }
+    cursor.SkipSeparators();
+    
+    const char* yearStart = cursor.p;
+    int year = cursor.Number(2, 4);
+    if (year < 0) return 0;
+    if (cursor.p - yearStart == 2) year += year < 50 ? 2000 : 1900;
+    
+    int hour = -1, minute = 0, second = 0, offset = 0;
+    cursor.SkipSeparators();
+    cursor.Skip('T');
+    if (!ParseClock(cursor, hour, minute, second)) return 0;
+    if (hour >= 0 && !ParseZone(cursor, offset)) offset = 0;
+    
+    return MakeTime(year, month, day, hour, minute, second, offset);
+}
+
+time_t ParseWebDate(const char* text, size_t length) {
+    if (!text) return 0;
+    
+    DateCursor cursor = { text, text + length };
+    while (cursor.p < cursor.end && isspace((unsigned char)*cursor.p)) cursor.p++;
+    
+    const char* p = cursor.p;
+    if (cursor.end - p >= 5 && isdigit((unsigned char)p[0]) && isdigit((unsigned char)p[1]) &&
+        isdigit((unsigned char)p[2]) && isdigit((unsigned char)p[3]) && p[4] == '-') {
+        return ParseIsoDate(cursor);
+    }
+    return ParseTextDate(cursor);
+}
+
+time_t ParseWebDate(const std::string& text) {
+    return ParseWebDate(text.data(), text.length());
+}
+
+// JSON-LD
+
+// Minimal JSON walker for ld+json blocks. Only strings are materialized,
+// and of those only the fields an article record needs.
+class JsonLdReader {
+public:
+    JsonLdReader(PageMetadata& meta, const char* json, size_t length)
+        : meta(meta), p(json), end(json + length), depth(0) {
+    }
+    
+    bool Read() {
+        // Some sites wrap the block in comments or CDATA
+        while (p < end && *p != '{' && *p != '[') p++;
+        if (p >= end) return false;
+        
+        Node root;
+        return ReadValue(root, "");
+    }
+    
+private:
+    // Fields of one JSON object
+    struct Node {
+        std::string type;
+        std::string headline;
+        std::string name;
+        std::string description;
+        std::string datePublished;
+        std::string dateModified;
+        std::string author;
+        std::string publisher;
+    };
+    
+    PageMetadata& meta;
+    const char* p;
+    const char* end;
+    int depth;
+    
+    void SkipSpace() {
+        while (p < end && isspace((unsigned char)*p)) p++;
+    }
+    
+    static bool IsArticleType(const std::string& type) {
+        return type.find("Article") != std::string::npos ||
+               type.find("BlogPosting") != std::string::npos ||
+               type.find("Report") != std::string::npos;
+    }
+    
+    static void AppendName(std::string& list, const std::string& name) {
+        if (name.empty() || name.compare(0, 4, "http") == 0) return;
+        if (!list.empty()) list += ", ";
+        list += name;
+    }
+    
+    void Assign(Node& node, const std::string& key, const std::string& value) {
+        if (key == "@type") {
+            if (!node.type.empty()) node.type += ' ';
+            node.type += value;
+        } else if (key == "author" || key == "creator") {
+            AppendName(node.author, value);
+        } else {
+            std::string* field = nullptr;
+            if (key == "headline") field = &node.headline;
+            else if (key == "name") field = &node.name;
+            else if (key == "description") field = &node.description;
+            else if (key == "datePublished") field = &node.datePublished;
+            else if (key == "dateModified") field = &node.dateModified;
+            else if (key == "publisher") field = &node.publisher;
+            if (field && field->empty()) *field = value;
+        }
+    }
+    
+    // Nested object: people and organizations contribute their name
+    void AssignChild(Node& node, const std::string& key, const Node& child) {
+        if (key == "author" || key == "creator") {
+            AppendName(node.author, child.name);
+        } else if (key == "publisher" && node.publisher.empty()) {
+            node.publisher = child.name;
+        }
+    }
+    
+    void Record(const Node& node) {
+        meta.Set("ld:type", node.type);
+        meta.Set("ld:headline", !node.headline.empty() ? node.headline : node.name);
+        meta.Set("ld:description", node.description);
+        meta.Set("ld:datepublished", node.datePublished);
+        meta.Set("ld:datemodified", node.dateModified);
+        meta.Set("ld:author", node.author);
+        meta.Set("ld:publisher", node.publisher);
+        meta.hasArticle = true;
+    }
+    
+    bool ReadValue(Node& owner, const std::string& key) {
+        SkipSpace();
+        if (p >= end) return false;
+        
+        if (*p == '"') {
+            std::string value;
+            if (!ReadString(value)) return false;
+            Assign(owner, key, value);
+            return true;
+        }
+        if (*p == '{') {
+            Node child;
+            if (!ReadObject(child)) return false;
+            AssignChild(owner, key, child);
+            return true;
+        }
+        if (*p == '[') {
+            if (++depth > MAX_JSON_DEPTH) return false;
+            p++;
+            SkipSpace();
+            if (p < end && *p == ']') {
+                p++;
+                depth--;
+                return true;
+            }
+            while (p < end) {
+                // Elements of an array belong to the array's key
+                if (!ReadValue(owner, key)) return false;
+                SkipSpace();
+                if (p < end && *p == ',') {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == ']') {
+                    p++;
+                    depth--;
+                    return true;
+                }
+                return false;
+            }
+            return false;
+        }
+        
+        // Number, true, false, null
+        const char* start = p;
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && !isspace((unsigned char)*p)) p++;
+        return p > start;
+    }
+    
+    bool ReadObject(Node& node) {
+        if (++depth > MAX_JSON_DEPTH) return false;
+        p++;  // '{'
+        
+        SkipSpace();
+        if (p < end && *p == '}') {
+            p++;
+        } else {
+            std::string key;
+            while (true) {
+                SkipSpace();
+                key.clear();
+                if (p >= end || *p != '"' || !ReadString(key)) return false;
+                SkipSpace();
+                if (p >= end || *p != ':') return false;
+                p++;
+                if (!ReadValue(node, key)) return false;
+                
+                SkipSpace();
+                if (p < end && *p == ',') {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == '}') {
+                    p++;
+                    break;
+                }
+                return false;
+            }
+        }
+        
+        // Innermost article wins when @graph/mainEntity nest them
+        if (!meta.hasArticle && IsArticleType(node.type)) Record(node);
+        depth--;
+        return true;
+    }
+    
+    static void AppendUtf8(std::string& out, unsigned codepoint) {
+        if (codepoint < 0x80) {
+            out += (char)codepoint;
+        } else if (codepoint < 0x800) {
+            out += (char)(0xC0 | (codepoint >> 6));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += (char)(0xE0 | (codepoint >> 12));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else {
+            out += (char)(0xF0 | (codepoint >> 18));
+            out += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+    
+    bool ReadHex4(unsigned& value) {
+        if (end - p < 4) return false;
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = p[i];
+            int digit = isdigit((unsigned char)c) ? c - '0' :
+                        (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                        (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (digit < 0) return false;
+            value = value * 16 + digit;
+        }
+        p += 4;
+        return true;
+    }
+    
+    // String at p (opening quote); anything past MAX_VALUE_LENGTH is dropped
+    bool ReadString(std::string& out) {
+        p++;
+        while (p < end) {
+            const char* run = p;
+            while (p < end && *p != '"' && *p != '\\') p++;
+            if (out.length() < MAX_VALUE_LENGTH) {
+                out.append(run, std::min((size_t)(p - run), MAX_VALUE_LENGTH - out.length()));
+            }
+            if (p >= end) return false;
+            if (*p++ == '"') return true;
+            
+            if (p >= end) return false;
+            char escape = *p++;
+            unsigned codepoint = 0;
+            switch (escape) {
+                case 'n': codepoint = '\n'; break;
+                case 't': codepoint = '\t'; break;
+                case 'r': codepoint = '\r'; break;
+                case 'b': codepoint = '\b'; break;
+                case 'f': codepoint = '\f'; break;
+                case 'u':
+                    if (!ReadHex4(codepoint)) return false;
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - p >= 6 &&
+                        p[0] == '\\' && p[1] == 'u') {
+                        unsigned low;
+                        p += 2;
+                        if (!ReadHex4(low)) return false;
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                    }
+                    if (codepoint >= 0xD800 && codepoint < 0xE000) codepoint = 0xFFFD;
+                    break;
+                default: codepoint = (unsigned char)escape; break;
+            }
+            if (out.length() < MAX_VALUE_LENGTH) AppendUtf8(out, codepoint);
+        }
+        return false;
+    }
+};
+
+// PageMetadata
+
+PageMetadata::PageMetadata() : hasArticle(false) {
+}
+
+void PageMetadata::Set(const char* key, size_t keyLength, const char* value, size_t valueLength) {
+    if (keyLength == 0 || entries.size() >= MAX_ENTRIES) return;
+    
+    std::string lowerKey(key, keyLength);
+    std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
+    
+    // First occurrence wins
+    for (const auto& entry : entries) {
+        if (entry.key == lowerKey) return;
+    }
+    
+    Entry entry;
+    AppendNormalizedText(entry.value, value, std::min(valueLength, MAX_VALUE_LENGTH),
+                         TEXT_DECODE_ENTITIES | TEXT_COLLAPSE_SPACE);
+    while (!entry.value.empty() && entry.value[entry.value.length() - 1] == ' ') {
+        entry.value.erase(entry.value.length() - 1);
+    }
+    if (entry.value.empty()) return;
+    
+    entry.key.swap(lowerKey);
+    entries.push_back(entry);
+}
+
+void PageMetadata::Set(const std::string& key, const std::string& value) {
+    Set(key.data(), key.length(), value.data(), value.length());
+}
+
+const std::string& PageMetadata::Get(const char* key) const {
+    static const std::string empty;
+    for (const auto& entry : entries) {
+        if (strcasecmp(entry.key.c_str(), key) == 0) return entry.value;
+    }
+    return empty;
+}
+
+bool PageMetadata::AddJsonLd(const char* json, size_t length) {
+    if (hasArticle) return false;
+    
+    JsonLdReader reader(*this, json, length);
+    reader.Read();
+    return hasArticle;
+}
+
+std::string PageMetadata::GetTitle() const {
+    static const char* keys[] = { "og:title", "ld:headline", "twitter:title", nullptr };
+    for (int i = 0; keys[i]; i++) {
+        const std::string& value = Get(keys[i]);
+        if (!value.empty()) return value;
+    }
+    return "";
+}
+
+std::string PageMetadata::GetAuthor() const {
+    for (int i = 0; AUTHOR_KEYS[i]; i++) {
+        const std::string& value = Get(AUTHOR_KEYS[i]);
+        
+        // article:author is usually a profile URL
+        if (value.empty() || value.find("://") != std::string::npos) continue;
+        
+        if (value.length() > 3 && strncasecmp(value.c_str(), "by ", 3) == 0) {
+            return value.substr(3);
+        }
+        return value;
+    }
+    return "";
+}
+
+time_t PageMetadata::GetPublishDate() const {
+    for (int i = 0; PUBLISHED_KEYS[i]; i++) {
+        const std::string& value = Get(PUBLISHED_KEYS[i]);
+        if (value.empty()) continue;
+        
+        time_t date = ParseWebDate(value);
+        if (date > 0) return date;
+    }
+    return 0;
+}
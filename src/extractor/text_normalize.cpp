@@ -0,0 +1,326 @@
+#include "text_normalize.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXT_NORMALIZE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TEXT_NORMALIZE_NEON 1
+#endif
+
+static const char REPLACEMENT_CHAR[] = "\xEF\xBF\xBD";
+
+struct NamedEntity {
+    const char* name;
+    uint32_t codepoint;
+};
+
+// Entities that show up in real news/feed text; everything else stays literal
+static const NamedEntity NAMED_ENTITIES[] = {
+    { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+    { "nbsp", 0xA0 }, { "ensp", 0x2002 }, { "emsp", 0x2003 }, { "thinsp", 0x2009 },
+    { "shy", 0xAD }, { "zwnj", 0x200C }, { "zwj", 0x200D },
+    { "ndash", 0x2013 }, { "mdash", 0x2014 }, { "hellip", 0x2026 },
+    { "lsquo", 0x2018 }, { "rsquo", 0x2019 }, { "sbquo", 0x201A },
+    { "ldquo", 0x201C }, { "rdquo", 0x201D }, { "bdquo", 0x201E },
+    { "laquo", 0xAB }, { "raquo", 0xBB }, { "lsaquo", 0x2039 }, { "rsaquo", 0x203A },
+    { "bull", 0x2022 }, { "middot", 0xB7 }, { "prime", 0x2032 }, { "Prime", 0x2033 },
+    { "copy", 0xA9 }, { "reg", 0xAE }, { "trade", 0x2122 }, { "deg", 0xB0 },
+    { "plusmn", 0xB1 }, { "times", 0xD7 }, { "divide", 0xF7 }, { "minus", 0x2212 },
+    { "frac12", 0xBD }, { "frac14", 0xBC }, { "frac34", 0xBE },
+    { "sup2", 0xB2 }, { "sup3", 0xB3 }, { "micro", 0xB5 },
+    { "para", 0xB6 }, { "sect", 0xA7 }, { "dagger", 0x2020 },
+    { "cent", 0xA2 }, { "pound", 0xA3 }, { "yen", 0xA5 }, { "euro", 0x20AC },
+    { "iexcl", 0xA1 }, { "iquest", 0xBF },
+    { "larr", 0x2190 }, { "uarr", 0x2191 }, { "rarr", 0x2192 }, { "darr", 0x2193 },
+    { "Agrave", 0xC0 }, { "Aacute", 0xC1 }, { "Auml", 0xC4 }, { "Ccedil", 0xC7 },
+    { "Eacute", 0xC9 }, { "Ntilde", 0xD1 }, { "Ouml", 0xD6 }, { "Uuml", 0xDC },
+    { "szlig", 0xDF }, { "agrave", 0xE0 }, { "aacute", 0xE1 }, { "acirc", 0xE2 },
+    { "auml", 0xE4 }, { "aring", 0xE5 }, { "ccedil", 0xE7 }, { "egrave", 0xE8 },
+    { "eacute", 0xE9 }, { "ecirc", 0xEA }, { "euml", 0xEB }, { "iacute", 0xED },
+    { "iuml", 0xEF }, { "ntilde", 0xF1 }, { "oacute", 0xF3 }, { "ocirc", 0xF4 },
+    { "ouml", 0xF6 }, { "oslash", 0xF8 }, { "uacute", 0xFA }, { "uuml", 0xFC },
+    { nullptr, 0 }
+};
+
+// Numeric references 128-159 mean Windows-1252, as browsers treat them
+static const uint16_t WINDOWS_1252[32] = {
+    0x20AC, 0xFFFD, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0xFFFD, 0x017D, 0xFFFD,
+    0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0xFFFD, 0x017E, 0x0178
+};
+
+static inline bool IsSpaceByte(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool IsSpaceCodepoint(uint32_t cp) {
+    return cp == 0xA0 || (cp >= 0x2000 && cp <= 0x200A) || cp == 0x202F ||
+           cp == 0x3000 || (cp < 0x80 && IsSpaceByte((unsigned char)cp));
+}
+
+static void AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// One collapsed whitespace run: a newline wins over a space already emitted
+static void AppendSpace(std::string& out, bool newline, int flags) {
+    if (out.empty()) return;
+    char& last = out[out.length() - 1];
+    if (newline && (flags & TEXT_KEEP_NEWLINES)) {
+        if (last == ' ') {
+            last = '\n';
+        } else if (last != '\n') {
+            out += '\n';
+        }
+    } else if (last != ' ' && last != '\n') {
+        out += ' ';
+    }
+}
+
+// Length of the valid UTF-8 sequence at p (0 if invalid), code point in cp
+static size_t DecodeUtf8(const unsigned char* p, size_t length, uint32_t& cp) {
+    unsigned char c = p[0];
+    size_t need;
+    uint32_t min;
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+        min = 0x80;
+        cp = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        min = 0x800;
+        cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        min = 0x10000;
+        cp = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (need > length) return 0;
+    
+    for (size_t i = 1; i < need; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    
+    // Overlong forms, UTF-16 surrogates and anything past U+10FFFF
+    if (cp < min || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) return 0;
+    return need;
+}
+
+// Length of the entity at p[0] == '&' (0 if not one), code point in cp
+static size_t DecodeEntity(const char* p, size_t length, uint32_t& cp) {
+    const size_t maxLength = 12;
+    size_t limit = length < maxLength ? length : maxLength;
+    
+    size_t semi = 1;
+    while (semi < limit && p[semi] != ';') semi++;
+    if (semi >= limit || semi < 2) return 0;
+    
+    if (p[1] == '#') {
+        bool hex = (semi > 2 && (p[2] == 'x' || p[2] == 'X'));
+        size_t digits = hex ? 3 : 2;
+        if (digits >= semi) return 0;
+        
+        uint32_t value = 0;
+        for (size_t i = digits; i < semi; i++) {
+            char c = p[i];
+            int digit;
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (hex && c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else if (hex && c >= 'A' && c <= 'F') {
+                digit = c - 'A' + 10;
+            } else {
+                return 0;
+            }
+            value = value * (hex ? 16 : 10) + digit;
+            if (value > 0x10FFFF) value = 0x110000;
+        }
+        
+        if (value >= 0x80 && value <= 0x9F) {
+            value = WINDOWS_1252[value - 0x80];
+        }
+        if (value == 0 || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+            value = 0xFFFD;
+        }
+        cp = value;
+        return semi + 1;
+    }
+    
+    size_t nameLength = semi - 1;
+    for (int i = 0; NAMED_ENTITIES[i].name; i++) {
+        if (strlen(NAMED_ENTITIES[i].name) == nameLength &&
+            memcmp(NAMED_ENTITIES[i].name, p + 1, nameLength) == 0) {
+            cp = NAMED_ENTITIES[i].codepoint;
+            return semi + 1;
+        }
+    }
+    return 0;
+}
+
+// Bytes at the start of p that can be copied as-is: no '&' (when decoding),
+// no non-ASCII byte, and when collapsing no whitespace except a single ' '
+// between two non-space bytes
+static size_t PlainRun(const char* p, size_t length, bool decode, bool collapse) {
+    size_t i = 0;
+    if (collapse && length > 0 && IsSpaceByte((unsigned char)p[0])) return 0;
+
+#if defined(TEXT_NORMALIZE_SSE2)
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i ctrlRange = _mm_set1_epi8('\r' - '\t');
+    
+    // Needs one byte of lookahead for the "space followed by space" test
+    while (i + 17 <= length) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int mask = _mm_movemask_epi8(v);  // Non-ASCII bytes
+        
+        if (decode) {
+            mask |= _mm_movemask_epi8(_mm_cmpeq_epi8(v, amp));
+        }
+        if (collapse) {
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+            
+            // \t..\r: (c - '\t') <= 4 unsigned
+            __m128i d = _mm_sub_epi8(v, tab);
+            __m128i ctrl = _mm_cmpeq_epi8(_mm_max_epu8(d, ctrlRange), ctrlRange);
+            __m128i dn = _mm_sub_epi8(next, tab);
+            __m128i nextSpace = _mm_or_si128(_mm_cmpeq_epi8(next, space),
+                                             _mm_cmpeq_epi8(_mm_max_epu8(dn, ctrlRange), ctrlRange));
+            __m128i doubled = _mm_and_si128(_mm_cmpeq_epi8(v, space), nextSpace);
+            mask |= _mm_movemask_epi8(_mm_or_si128(ctrl, doubled));
+        }
+        
+        if (mask) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+#elif defined(TEXT_NORMALIZE_NEON)
+    const uint8x16_t amp = vdupq_n_u8('&');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t ctrlRange = vdupq_n_u8('\r' - '\t');
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    
+    while (i + 17 <= length) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i));
+        uint8x16_t special = vcgeq_u8(v, high);
+        
+        if (decode) {
+            special = vorrq_u8(special, vceqq_u8(v, amp));
+        }
+        if (collapse) {
+            uint8x16_t next = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i + 1));
+            uint8x16_t ctrl = vcleq_u8(vsubq_u8(v, tab), ctrlRange);
+            uint8x16_t nextSpace = vorrq_u8(vceqq_u8(next, space),
+                                            vcleq_u8(vsubq_u8(next, tab), ctrlRange));
+            uint8x16_t doubled = vandq_u8(vceqq_u8(v, space), nextSpace);
+            special = vorrq_u8(special, vorrq_u8(ctrl, doubled));
+        }
+        
+        // No movemask on NEON: narrow to 4 bits per byte
+        uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(special), 4);
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        if (bits) return i + (__builtin_ctzll(bits) >> 2);
+        i += 16;
+    }
+#endif
+    
+    for (; i < length; i++) {
+        unsigned char c = (unsigned char)p[i];
+        if (c >= 0x80 || (decode && c == '&')) break;
+        if (collapse && IsSpaceByte(c)) {
+            if (c != ' ' || i + 1 >= length || IsSpaceByte((unsigned char)p[i + 1])) break;
+        }
+    }
+    return i;
+}
+
+void AppendNormalizedText(std::string& out, const char* data, size_t length, int flags) {
+    bool decode = (flags & TEXT_DECODE_ENTITIES) != 0;
+    bool collapse = (flags & TEXT_COLLAPSE_SPACE) != 0;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    
+    out.reserve(out.length() + length);
+    
+    size_t i = 0;
+    while (i < length) {
+        size_t run = PlainRun(data + i, length - i, decode, collapse);
+        if (run > 0) {
+            out.append(data + i, run);
+            i += run;
+            continue;
+        }
+        
+        unsigned char c = bytes[i];
+        uint32_t cp = 0;
+        size_t used = 0;
+        
+        if (c < 0x80) {
+            if (collapse && IsSpaceByte(c)) {
+                AppendSpace(out, c == '\n', flags);
+                i++;
+                continue;
+            }
+            if (decode && c == '&') used = DecodeEntity(data + i, length - i, cp);
+            if (used == 0) {
+                out += (char)c;
+                i++;
+                continue;
+            }
+        } else {
+            used = DecodeUtf8(bytes + i, length - i, cp);
+            if (used == 0) {
+                out += REPLACEMENT_CHAR;
+                i++;
+                continue;
+            }
+        }
+        
+        if (collapse && IsSpaceCodepoint(cp)) {
+            AppendSpace(out, cp == '\n', flags);
+        } else if (cp == 0xAD || cp == 0x200C || cp == 0x200D) {
+            // Invisible formatting characters only split words in FTS
+        } else if (c >= 0x80) {
+            out.append(data + i, used);
+        } else {
+            AppendUtf8(out, cp);
+        }
+        i += used;
+    }
+}
+
+std::string NormalizeText(const std::string& text, int flags) {
+    std::string result;
+    AppendNormalizedText(result, text.data(), text.length(), flags);
+    
+    if (flags & TEXT_COLLAPSE_SPACE) {
+        while (!result.empty() && (result[result.length() - 1] == ' ' ||
+                                   result[result.length() - 1] == '\n')) {
+            result.erase(result.length() - 1);
+        }
+    }
+    return result;
+}
@@ -5,6 +5,7 @@
 #include "search_engine.h"
 #include "voice_system.h"
 #include "net_fetcher.h"
+#include "http_cache.h"
 #include "rss_parser.h"
 #include "content_extractor.h"
 #include "online_search.h"
@@ -26,6 +27,7 @@ void CreateDirectories() {
     sceIoMkdir(VAULT_PATH "media", 0777);
     sceIoMkdir(DB_PATH, 0777);
     sceIoMkdir(CACHE_PATH, 0777);
+    sceIoMkdir(HTTP_CACHE_PATH, 0777);
     sceIoMkdir(VOICE_PATH, 0777);
     sceIoMkdir(VOICE_PATH "pack", 0777);
     sceIoMkdir(DATA_PATH "models", 0777);
@@ -57,10 +59,16 @@ void InitApp() {
     
     // Initialize online components
     g_app.netFetcher = new NetFetcher();
+    g_app.httpCache = new HttpCache();
     g_app.rssParser = new RSSParser();
     g_app.extractor = new ContentExtractor();
     g_app.onlineSearch = new OnlineSearch();
     
+    // Pages fetched before (even in an earlier session) are served from disk
+    if (g_app.httpCache->Open(HTTP_CACHE_PATH, HTTP_CACHE_BUDGET_BYTES)) {
+        g_app.netFetcher->SetCache(g_app.httpCache);
+    }
+    
     // Initialize network
     if (g_app.netFetcher->Initialize()) {
         g_app.online = g_app.netFetcher->IsOnline();
@@ -98,6 +106,9 @@ void InitApp() {
     if (g_app.db->Initialize(dbPath)) {
         g_app.db->CreateTables();
         g_app.db->CreateFTSIndex();
+        
+        // Feeds are kept current in the background; Ask searches the local copy
+        g_app.onlineSearch->StartFeedRefresh();
     }
     
     // Try to load Wikipedia ZIM (if exists)
@@ -160,6 +171,11 @@ void ShutdownApp() {
         delete g_app.netFetcher;
     }
     
+    if (g_app.httpCache) {
+        g_app.httpCache->Close();
+        delete g_app.httpCache;
+    }
+    
     if (g_app.zimReader) {
         g_app.zimReader->Close();
         delete g_app.zimReader;
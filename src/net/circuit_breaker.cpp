@@ -0,0 +1,66 @@
+#include "circuit_breaker.h"
+#include <algorithm>
+
+// Closed circuits are forgotten once this many hosts are tracked
+static const size_t MAX_CIRCUITS = 64;
+
+CircuitBreaker::CircuitBreaker(int failureThreshold, int openSeconds, int maxOpenSeconds)
+    : failureThreshold(std::max(1, failureThreshold)), baseOpenSeconds(std::max(1, openSeconds)),
+      maxOpenSeconds(std::max(openSeconds, maxOpenSeconds)) {
+}
+
+bool CircuitBreaker::Allow(const std::string& host, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = circuits.find(host);
+    if (it == circuits.end() || !it->second.open) return true;
+    
+    Circuit& circuit = it->second;
+    if (now < circuit.retryAt) return false;
+    
+    // Half-open: this request is the trial; others wait out another period
+    circuit.retryAt = now + std::chrono::seconds(circuit.openSeconds);
+    return true;
+}
+
+void CircuitBreaker::RecordSuccess(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    circuits.erase(host);
+}
+
+void CircuitBreaker::RecordFailure(const std::string& host, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = circuits.find(host);
+    if (it == circuits.end()) {
+        if (circuits.size() >= MAX_CIRCUITS) {
+            for (auto c = circuits.begin(); c != circuits.end();) {
+                if (!c->second.open) {
+                    c = circuits.erase(c);
+                } else {
+                    ++c;
+                }
+            }
+        }
+        
+        Circuit fresh;
+        fresh.failures = 0;
+        fresh.open = false;
+        fresh.openSeconds = baseOpenSeconds;
+        fresh.retryAt = now;
+        it = circuits.insert(std::make_pair(host, fresh)).first;
+    }
+    
+    Circuit& circuit = it->second;
+    circuit.failures++;
+    if (circuit.open) {
+        // The trial failed too
+        circuit.openSeconds = std::min(maxOpenSeconds, circuit.openSeconds * 2);
+    } else if (circuit.failures >= failureThreshold) {
+        circuit.open = true;
+        circuit.openSeconds = baseOpenSeconds;
+    } else {
+        return;
+    }
+    circuit.retryAt = now + std::chrono::seconds(circuit.openSeconds);
+}
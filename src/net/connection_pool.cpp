@@ -0,0 +1,148 @@
+#include "connection_pool.h"
+#include <chrono>
+
+ConnectionPool::ConnectionPool(HttpTransport* transport, int maxConnections,
+                               int maxIdlePerOrigin, int idleTimeoutSec)
+    : transport(transport), maxConnections(maxConnections > 0 ? maxConnections : 1),
+      maxIdlePerOrigin(maxIdlePerOrigin), idleTimeoutSec(idleTimeoutSec), busy(0) {
+}
+
+ConnectionPool::~ConnectionPool() {
+    CloseIdle(true);
+}
+
+HttpConnection* ConnectionPool::Acquire(const HttpUrl& url, int timeoutSec,
+                                        bool& reused, int& error) {
+    std::string origin = url.Origin();
+    std::vector<HttpConnection*> closing;  // Closed outside the lock
+    HttpConnection* conn = nullptr;
+    bool gotSlot = false;
+    reused = false;
+    error = 0;
+    
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSec);
+        
+        while (!gotSlot) {
+            ExpireIdle(time(nullptr), closing);
+            
+            // Most recently used first: the least likely to have been dropped
+            for (size_t i = idle.size(); i-- > 0;) {
+                if (idle[i].origin == origin) {
+                    conn = idle[i].conn;
+                    idle.erase(idle.begin() + i);
+                    break;
+                }
+            }
+            if (conn) {
+                reused = true;
+                stats.reused++;
+                gotSlot = true;
+            } else if (busy + (int)idle.size() < maxConnections) {
+                gotSlot = true;
+            } else if (!idle.empty()) {
+                // Full: make room by dropping the longest idle connection
+                closing.push_back(idle.front().conn);
+                idle.erase(idle.begin());
+                gotSlot = true;
+            } else if (released.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        if (gotSlot) busy++;
+    }
+    
+    for (auto c : closing) delete c;
+    
+    if (!gotSlot) {
+        error = POOL_ERROR_BUSY;
+        return nullptr;
+    }
+    if (conn) return conn;
+    
+    conn = transport->Connect(url, timeoutSec, error);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!conn) {
+        busy--;
+        released.notify_one();
+        return nullptr;
+    }
+    stats.opened++;
+    return conn;
+}
+
+void ConnectionPool::Release(HttpConnection* conn, const HttpUrl& url, bool reusable) {
+    if (!conn) return;
+    
+    std::vector<HttpConnection*> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy--;
+        
+        if (reusable && maxIdlePerOrigin > 0) {
+            std::string origin = url.Origin();
+            
+            // Keep the newest few per origin
+            int sameOrigin = 0;
+            for (const auto& entry : idle) {
+                if (entry.origin == origin) sameOrigin++;
+            }
+            for (size_t i = 0; i < idle.size() && sameOrigin >= maxIdlePerOrigin;) {
+                if (idle[i].origin == origin) {
+                    closing.push_back(idle[i].conn);
+                    idle.erase(idle.begin() + i);
+                    sameOrigin--;
+                } else {
+                    i++;
+                }
+            }
+            
+            IdleEntry entry;
+            entry.origin = origin;
+            entry.conn = conn;
+            entry.idleSince = time(nullptr);
+            idle.push_back(entry);
+        } else {
+            closing.push_back(conn);
+        }
+        released.notify_one();
+    }
+    
+    for (auto c : closing) delete c;
+}
+
+void ConnectionPool::CloseIdle(bool force) {
+    std::vector<HttpConnection*> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (force) {
+            for (const auto& entry : idle) closing.push_back(entry.conn);
+            idle.clear();
+        } else {
+            ExpireIdle(time(nullptr), closing);
+        }
+        released.notify_all();
+    }
+    
+    for (auto c : closing) delete c;
+}
+
+PoolStats ConnectionPool::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+// Caller holds the lock
+void ConnectionPool::ExpireIdle(time_t now, std::vector<HttpConnection*>& closing) {
+    for (size_t i = 0; i < idle.size();) {
+        if (now - idle[i].idleSince >= idleTimeoutSec) {
+            closing.push_back(idle[i].conn);
+            idle.erase(idle.begin() + i);
+            stats.expired++;
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#include "content_decoder.h"
+#include <zlib.h>
+#include <cctype>
+#include <cstring>
+
+// zlib window bits: gzip wrapper, zlib wrapper, raw deflate
+static const int GZIP_WINDOW_BITS = 15 + 16;
+static const int ZLIB_WINDOW_BITS = 15;
+static const int RAW_WINDOW_BITS = -15;
+
+ContentDecoder::ContentDecoder()
+    : encoding(ENCODING_IDENTITY), stream(nullptr), started(false), finished(false),
+      stopped(false), bytesIn(0), bytesOut(0), window(DECODE_WINDOW_BYTES) {
+}
+
+ContentDecoder::~ContentDecoder() {
+    End();
+}
+
+ContentDecoder::Encoding ContentDecoder::ParseEncoding(const std::string& header) {
+    std::string value;
+    for (char c : header) {
+        if (!isspace((unsigned char)c)) value += tolower((unsigned char)c);
+    }
+    
+    if (value.empty() || value == "identity") return ENCODING_IDENTITY;
+    if (value == "gzip" || value == "x-gzip") return ENCODING_GZIP;
+    if (value == "deflate") return ENCODING_DEFLATE;
+    return ENCODING_UNSUPPORTED;  // br, stacked encodings
+}
+
+bool ContentDecoder::Begin(Encoding enc) {
+    End();
+    encoding = enc;
+    finished = false;
+    stopped = false;
+    bytesIn = 0;
+    bytesOut = 0;
+    return enc != ENCODING_UNSUPPORTED;
+}
+
+void ContentDecoder::End() {
+    if (stream) {
+        inflateEnd(static_cast<z_stream*>(stream));
+        delete static_cast<z_stream*>(stream);
+        stream = nullptr;
+    }
+    started = false;
+}
+
+bool ContentDecoder::Start(const char* firstBytes, size_t length) {
+    int windowBits = GZIP_WINDOW_BITS;
+    if (encoding == ENCODING_DEFLATE) {
+        // A zlib header is CM = 8 with a check value making it a multiple of 31
+        unsigned char cmf = (unsigned char)firstBytes[0];
+        bool zlib = (cmf & 0x0f) == 8 && (cmf >> 4) <= 7;
+        if (zlib && length >= 2) {
+            zlib = ((cmf << 8) | (unsigned char)firstBytes[1]) % 31 == 0;
+        }
+        windowBits = zlib ? ZLIB_WINDOW_BITS : RAW_WINDOW_BITS;
+    }
+    
+    z_stream* zs = new z_stream;
+    memset(zs, 0, sizeof(*zs));
+    if (inflateInit2(zs, windowBits) != Z_OK) {
+        delete zs;
+        return false;
+    }
+    stream = zs;
+    started = true;
+    return true;
+}
+
+bool ContentDecoder::Decode(const char* data, size_t length, const ChunkCallback& onChunk) {
+    if (length == 0) return true;
+    bytesIn += length;
+    
+    if (encoding == ENCODING_IDENTITY) {
+        bytesOut += length;
+        if (!onChunk(data, length)) {
+            stopped = true;
+            return false;
+        }
+        return true;
+    }
+    if (encoding == ENCODING_UNSUPPORTED) return false;
+    if (finished) return true;  // Trailing bytes after the stream end
+    if (!started && !Start(data, length)) return false;
+    
+    z_stream* zs = static_cast<z_stream*>(stream);
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = (uInt)length;
+    
+    // A full window may leave more output inside zlib even with the input
+    // used up, so keep going until inflate has room to spare
+    while (!finished) {
+        zs->next_out = (Bytef*)&window[0];
+        zs->avail_out = DECODE_WINDOW_BYTES;
+        
+        int ret = inflate(zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return false;
+        }
+        
+        size_t produced = DECODE_WINDOW_BYTES - zs->avail_out;
+        if (produced > 0) {
+            bytesOut += produced;
+            if (!onChunk(&window[0], produced)) {
+                stopped = true;
+                return false;
+            }
+        }
+        
+        if (ret == Z_STREAM_END) {
+            finished = true;
+        } else if (zs->avail_out > 0 || ret == Z_BUF_ERROR) {
+            break;  // Needs more input
+        }
+    }
+    return true;
+}
+
+bool ContentDecoder::IsComplete() const {
+    return encoding == ENCODING_IDENTITY || finished;
+}
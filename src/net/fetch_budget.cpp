@@ -0,0 +1,68 @@
+#include "fetch_budget.h"
+#include <algorithm>
+
+FetchBudget::FetchBudget(int timeMs, uint64_t maxBytes, int maxRequests)
+    : hasDeadline(timeMs > 0),
+      deadline(Clock::now() + std::chrono::milliseconds(std::max(0, timeMs))),
+      maxBytes(maxBytes), maxRequests(std::max(0, maxRequests)), bytesUsed(0),
+      requestsUsed(0), cancelled(false) {
+}
+
+bool FetchBudget::BeginRequest() {
+    if (IsExhausted()) return false;
+    
+    // Concurrent fetches race for the last request; the losers give it back
+    int taken = ++requestsUsed;
+    if (maxRequests > 0 && taken > maxRequests) {
+        requestsUsed--;
+        return false;
+    }
+    return true;
+}
+
+bool FetchBudget::AddBytes(size_t bytes) {
+    bytesUsed += bytes;
+    return !IsExhausted();
+}
+
+void FetchBudget::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    for (HttpConnection* conn : inFlight) {
+        conn->Abort();
+    }
+}
+
+bool FetchBudget::IsExhausted() const {
+    if (cancelled) return true;
+    if (maxBytes > 0 && bytesUsed >= maxBytes) return true;
+    return hasDeadline && Clock::now() >= deadline;
+}
+
+void FetchBudget::Attach(HttpConnection* conn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cancelled) conn->Abort();  // Cancelled while it was being opened
+    inFlight.push_back(conn);
+}
+
+void FetchBudget::Detach(HttpConnection* conn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    inFlight.erase(std::remove(inFlight.begin(), inFlight.end(), conn), inFlight.end());
+}
+
+int FetchBudget::ClampTimeout(int timeoutSec) const {
+    int remainingMs = GetRemainingMs();
+    if (remainingMs < 0) return timeoutSec;
+    return std::max(1, std::min(timeoutSec, (remainingMs + 999) / 1000));
+}
+
+int FetchBudget::GetRemainingMs() const {
+    if (!hasDeadline) return -1;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+    return (int)std::max<long long>(0, left.count());
+}
+
+int FetchBudget::GetRemainingRequests() const {
+    if (maxRequests == 0) return -1;
+    return std::max(0, maxRequests - requestsUsed);
+}
@@ -0,0 +1,167 @@
+#include "fetch_scheduler.h"
+#include <algorithm>
+
+// Host blocked by its in-flight cap: look again after this long (its own
+// scheduler wakes sooner, when the running fetch completes)
+static const int BUSY_RETRY_MS = 50;
+
+// Idle, full buckets are dropped once this many hosts are tracked
+static const size_t MAX_BUCKETS = 64;
+
+HostThrottle::HostThrottle(double requestsPerSecond, int burst, int maxActive)
+    : requestsPerSecond(requestsPerSecond), burst(std::max(1, burst)),
+      maxActive(std::max(1, maxActive)) {
+}
+
+void HostThrottle::Refill(Bucket& bucket, Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - bucket.refilled).count();
+    if (elapsed > 0) {
+        bucket.tokens = std::min((double)burst, bucket.tokens + elapsed * requestsPerSecond);
+        bucket.refilled = now;
+    }
+}
+
+bool HostThrottle::TryAcquire(const std::string& host, Clock::time_point now,
+                              Clock::time_point& retryAt) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = buckets.find(host);
+    if (it == buckets.end()) {
+        if (buckets.size() >= MAX_BUCKETS) {
+            for (auto b = buckets.begin(); b != buckets.end();) {
+                Refill(b->second, now);
+                if (b->second.active == 0 && b->second.tokens >= burst) {
+                    b = buckets.erase(b);
+                } else {
+                    ++b;
+                }
+            }
+        }
+        
+        Bucket fresh;
+        fresh.tokens = burst;
+        fresh.refilled = now;
+        fresh.active = 0;
+        it = buckets.insert(std::make_pair(host, fresh)).first;
+    }
+    
+    Bucket& bucket = it->second;
+    if (bucket.active >= maxActive) {
+        retryAt = now + std::chrono::milliseconds(BUSY_RETRY_MS);
+        return false;
+    }
+    
+    if (requestsPerSecond > 0) {
+        Refill(bucket, now);
+        if (bucket.tokens < 1.0) {
+            double wait = (1.0 - bucket.tokens) / requestsPerSecond;
+            retryAt = now + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(wait));
+            return false;
+        }
+        bucket.tokens -= 1.0;
+    }
+    
+    bucket.active++;
+    return true;
+}
+
+void HostThrottle::Release(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = buckets.find(host);
+    if (it != buckets.end() && it->second.active > 0) {
+        it->second.active--;
+    }
+}
+
+FetchScheduler::FetchScheduler(HostThrottle* throttle, int workers)
+    : throttle(throttle), running(0), stopping(false) {
+    for (int i = 0; i < std::max(1, workers); i++) {
+        threads.push_back(std::thread([this]() { WorkerLoop(); }));
+    }
+}
+
+FetchScheduler::~FetchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+        stopping = true;
+    }
+    changed.notify_all();
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void FetchScheduler::Submit(const std::string& host, const std::function<void()>& work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Job job;
+        job.host = host;
+        job.work = work;
+        queue.push_back(job);
+    }
+    changed.notify_one();
+}
+
+void FetchScheduler::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return queue.empty() && running == 0; });
+}
+
+bool FetchScheduler::WaitFor(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                            [this]() { return queue.empty() && running == 0; });
+}
+
+void FetchScheduler::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+    }
+    changed.notify_all();
+}
+
+void FetchScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (true) {
+        // First queued job whose host can take another request
+        auto now = HostThrottle::Clock::now();
+        auto wakeAt = now + std::chrono::hours(1);
+        bool found = false;
+        Job job;
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            HostThrottle::Clock::time_point retryAt = wakeAt;
+            if (!throttle || throttle->TryAcquire(it->host, now, retryAt)) {
+                job = *it;
+                queue.erase(it);
+                found = true;
+                break;
+            }
+            wakeAt = std::min(wakeAt, retryAt);
+        }
+        
+        if (!found) {
+            if (stopping) return;
+            if (queue.empty()) {
+                changed.wait(lock);
+            } else {
+                changed.wait_until(lock, wakeAt);
+            }
+            continue;
+        }
+        
+        running++;
+        lock.unlock();
+        
+        job.work();
+        if (throttle) throttle->Release(job.host);
+        
+        lock.lock();
+        running--;
+        changed.notify_all();  // Waiters in Wait(), and workers held by this host
+    }
+}
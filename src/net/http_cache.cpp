@@ -0,0 +1,524 @@
+#include "http_cache.h"
+#include "content_decoder.h"
+#include "item_identity.h"
+#include "page_metadata.h"
+#include <zlib.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+// A single stored body larger than this (compressed) is not kept
+static const size_t MAX_ENTRY_BYTES = 2 * 1024 * 1024;
+
+// Heuristic lifetime from Last-Modified: this share of the age, up to a day
+static const double LAST_MODIFIED_FRACTION = 0.1;
+static const time_t MAX_HEURISTIC_SECONDS = 24 * 60 * 60;
+
+// Use times closer together than this are not journaled again
+static const time_t TOUCH_INTERVAL_SECONDS = 60;
+
+// The journal is rewritten once it holds this many records beyond two per entry
+static const int COMPACT_SLACK_RECORDS = 64;
+
+static const int GZIP_WINDOW_BITS = 15 + 16;
+static const size_t DEFLATE_OUT_BYTES = 4096;
+
+static const char* JOURNAL_FILE = "index.log";
+static const char* JOURNAL_TEMP_FILE = "index.tmp";
+
+static void SplitFields(const std::string& line, std::vector<std::string>& fields) {
+    fields.clear();
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        if (tab == std::string::npos) {
+            fields.push_back(line.substr(start));
+            return;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+}
+
+// Journal fields are tab-separated, one record per line
+static bool IsPlainField(const std::string& value) {
+    return value.find_first_of("\t\r\n") == std::string::npos;
+}
+
+static std::string Trim(const std::string& text) {
+    size_t start = 0;
+    size_t end = text.size();
+    while (start < end && isspace((unsigned char)text[start])) start++;
+    while (end > start && isspace((unsigned char)text[end - 1])) end--;
+    return text.substr(start, end - start);
+}
+
+static std::string ToLower(const std::string& text) {
+    std::string lower;
+    for (char c : text) lower += tolower((unsigned char)c);
+    return lower;
+}
+
+// --- HttpCacheWriter ---
+
+HttpCacheWriter::HttpCacheWriter(FILE* file, const std::string& tempPath, bool bodyIsGzip)
+    : file(file), tempPath(tempPath), deflater(nullptr), hash(14695981039346656037ULL),
+      storedBytes(0), failed(false) {
+    if (!bodyIsGzip) {
+        // Fixed header (no name or time), so identical bodies compress to identical files
+        z_stream* zs = new z_stream;
+        memset(zs, 0, sizeof(*zs));
+        if (deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8,
+                         Z_DEFAULT_STRATEGY) == Z_OK) {
+            deflater = zs;
+        } else {
+            delete zs;
+            failed = true;
+        }
+    }
+}
+
+HttpCacheWriter::~HttpCacheWriter() {
+    if (deflater) {
+        deflateEnd(static_cast<z_stream*>(deflater));
+        delete static_cast<z_stream*>(deflater);
+    }
+    if (file) fclose(file);
+}
+
+bool HttpCacheWriter::Put(const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    
+    storedBytes += length;
+    if (storedBytes > MAX_ENTRY_BYTES || fwrite(data, 1, length, file) != length) {
+        failed = true;
+    }
+    return !failed;
+}
+
+bool HttpCacheWriter::Write(const char* data, size_t length) {
+    if (failed) return false;
+    if (!deflater) return Put(data, length);
+    
+    z_stream* zs = static_cast<z_stream*>(deflater);
+    char out[DEFLATE_OUT_BYTES];
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = (uInt)length;
+    while (zs->avail_in > 0) {
+        zs->next_out = (Bytef*)out;
+        zs->avail_out = DEFLATE_OUT_BYTES;
+        if (deflate(zs, Z_NO_FLUSH) == Z_STREAM_ERROR) {
+            failed = true;
+            return false;
+        }
+        size_t produced = DEFLATE_OUT_BYTES - zs->avail_out;
+        if (produced > 0 && !Put(out, produced)) return false;
+    }
+    return true;
+}
+
+bool HttpCacheWriter::Finish() {
+    if (deflater && !failed) {
+        z_stream* zs = static_cast<z_stream*>(deflater);
+        char out[DEFLATE_OUT_BYTES];
+        zs->next_in = nullptr;
+        zs->avail_in = 0;
+        int ret = Z_OK;
+        while (ret == Z_OK && !failed) {
+            zs->next_out = (Bytef*)out;
+            zs->avail_out = DEFLATE_OUT_BYTES;
+            ret = deflate(zs, Z_FINISH);
+            size_t produced = DEFLATE_OUT_BYTES - zs->avail_out;
+            if (produced > 0) Put(out, produced);
+        }
+        if (ret != Z_STREAM_END) failed = true;
+    }
+    
+    if (file) {
+        if (fclose(file) != 0) failed = true;
+        file = nullptr;
+    }
+    return !failed && storedBytes > 0;
+}
+
+// --- HttpCache ---
+
+HttpCache::HttpCache() : budgetBytes(0), storedBytes(0), journal(nullptr),
+                         journalRecords(0), tempCounter(0) {
+}
+
+HttpCache::~HttpCache() {
+    Close();
+}
+
+bool HttpCache::Open(const std::string& dir, size_t budget) {
+    Close();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    directory = dir;
+    if (!directory.empty() && directory[directory.size() - 1] != '/') directory += '/';
+    budgetBytes = budget;
+    
+    std::ifstream in((directory + JOURNAL_FILE).c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        Replay(line);
+        journalRecords++;
+    }
+    in.close();
+    
+    journal = fopen((directory + JOURNAL_FILE).c_str(), "ab");
+    if (!journal) {
+        entries.clear();
+        fileRefs.clear();
+        storedBytes = 0;
+        return false;
+    }
+    
+    // The budget may have shrunk since the last run
+    EvictToBudget();
+    CompactIfNeeded();
+    return true;
+}
+
+void HttpCache::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (journal) {
+        fclose(journal);
+        journal = nullptr;
+    }
+    entries.clear();
+    fileRefs.clear();
+    storedBytes = 0;
+    journalRecords = 0;
+}
+
+// P url file bodyBytes storedBytes fetchedAt expiresAt lastUsed complete etag lastModified
+// U url lastUsed
+// D url
+void HttpCache::Replay(const std::string& line) {
+    std::vector<std::string> fields;
+    SplitFields(line, fields);
+    if (fields.empty()) return;
+    
+    if (fields[0] == "P" && fields.size() == 11) {
+        CacheEntry entry;
+        entry.url = fields[1];
+        entry.file = fields[2];
+        entry.bodyBytes = strtoul(fields[3].c_str(), nullptr, 10);
+        entry.storedBytes = strtoul(fields[4].c_str(), nullptr, 10);
+        entry.fetchedAt = (time_t)strtoll(fields[5].c_str(), nullptr, 10);
+        entry.expiresAt = (time_t)strtoll(fields[6].c_str(), nullptr, 10);
+        entry.lastUsed = (time_t)strtoll(fields[7].c_str(), nullptr, 10);
+        entry.complete = fields[8] == "1";
+        entry.etag = fields[9];
+        entry.lastModified = fields[10];
+        if (entry.file.empty() || entry.storedBytes == 0) return;
+        
+        DropEntry(entry.url, false);
+        AddEntry(entry);
+    } else if (fields[0] == "U" && fields.size() == 3) {
+        auto it = entries.find(fields[1]);
+        if (it != entries.end()) {
+            it->second.lastUsed = (time_t)strtoll(fields[2].c_str(), nullptr, 10);
+        }
+    } else if (fields[0] == "D" && fields.size() == 2) {
+        // The file was deleted back then; a later entry may have stored it again
+        DropEntry(fields[1], false);
+    }
+}
+
+void HttpCache::AppendRecord(const std::string& line) {
+    if (!journal) return;
+    fputs(line.c_str(), journal);
+    fputc('\n', journal);
+    fflush(journal);
+    journalRecords++;
+}
+
+void HttpCache::WriteEntry(const CacheEntry& entry) {
+    char numbers[128];
+    snprintf(numbers, sizeof(numbers), "%lu\t%lu\t%lld\t%lld\t%lld\t%d",
+             (unsigned long)entry.bodyBytes, (unsigned long)entry.storedBytes,
+             (long long)entry.fetchedAt, (long long)entry.expiresAt,
+             (long long)entry.lastUsed, entry.complete ? 1 : 0);
+    AppendRecord("P\t" + entry.url + "\t" + entry.file + "\t" + numbers + "\t" +
+                 entry.etag + "\t" + entry.lastModified);
+}
+
+void HttpCache::CompactIfNeeded() {
+    if (!journal || journalRecords <= (int)entries.size() * 2 + COMPACT_SLACK_RECORDS) return;
+    
+    std::string journalPath = directory + JOURNAL_FILE;
+    std::string tempPath = directory + JOURNAL_TEMP_FILE;
+    
+    // Rewrite the live entries, then swap the file in
+    fclose(journal);
+    journal = fopen(tempPath.c_str(), "wb");
+    if (journal) {
+        journalRecords = 0;
+        for (const auto& pair : entries) {
+            WriteEntry(pair.second);
+        }
+        fclose(journal);
+        
+        if (rename(tempPath.c_str(), journalPath.c_str()) != 0) {
+            remove(journalPath.c_str());
+            rename(tempPath.c_str(), journalPath.c_str());
+        }
+    }
+    journal = fopen(journalPath.c_str(), "ab");
+}
+
+void HttpCache::AddEntry(const CacheEntry& entry) {
+    if (fileRefs[entry.file]++ == 0) {
+        storedBytes += entry.storedBytes;
+    }
+    entries[entry.url] = entry;
+}
+
+void HttpCache::DropEntry(const std::string& url, bool removeFile) {
+    auto it = entries.find(url);
+    if (it == entries.end()) return;
+    
+    auto ref = fileRefs.find(it->second.file);
+    if (ref != fileRefs.end() && --ref->second <= 0) {
+        storedBytes -= std::min(storedBytes, it->second.storedBytes);
+        if (removeFile) remove(BodyPath(ref->first).c_str());
+        fileRefs.erase(ref);
+    }
+    entries.erase(it);
+}
+
+void HttpCache::EvictToBudget() {
+    if (storedBytes <= budgetBytes) return;
+    
+    std::vector<std::pair<time_t, std::string>> byUse;
+    for (const auto& pair : entries) {
+        byUse.push_back(std::make_pair(pair.second.lastUsed, pair.first));
+    }
+    std::sort(byUse.begin(), byUse.end());
+    
+    for (size_t i = 0; i < byUse.size() && storedBytes > budgetBytes; i++) {
+        DropEntry(byUse[i].second, true);
+        AppendRecord("D\t" + byUse[i].second);
+        stats.evictions++;
+    }
+}
+
+std::string HttpCache::BodyPath(const std::string& file) const {
+    return directory + file + ".gz";
+}
+
+bool HttpCache::Lookup(const std::string& url, CacheEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!journal) return false;
+    
+    auto it = entries.find(CanonicalizeUrl(url));
+    if (it == entries.end()) {
+        stats.misses++;
+        return false;
+    }
+    stats.hits++;
+    
+    time_t now = time(nullptr);
+    if (now - it->second.lastUsed >= TOUCH_INTERVAL_SECONDS) {
+        it->second.lastUsed = now;
+        AppendRecord("U\t" + it->first + "\t" + std::to_string((long long)now));
+        CompactIfNeeded();
+    }
+    entry = it->second;
+    return true;
+}
+
+bool HttpCache::ReadBody(const CacheEntry& entry, const ChunkCallback& onChunk) {
+    FILE* file = fopen(BodyPath(entry.file).c_str(), "rb");
+    
+    ContentDecoder decoder;
+    decoder.Begin(ContentDecoder::ENCODING_GZIP);
+    
+    bool ok = file != nullptr;
+    std::vector<char> buffer(ContentDecoder::DECODE_WINDOW_BYTES);
+    while (ok) {
+        size_t read = fread(&buffer[0], 1, buffer.size(), file);
+        if (read == 0) break;
+        ok = decoder.Decode(&buffer[0], read, onChunk);
+    }
+    if (file) fclose(file);
+    
+    if (decoder.Stopped()) return false;
+    
+    // A body cut short when it was fetched ends mid-stream
+    if (ok && (decoder.IsComplete() || !entry.complete)) return true;
+    
+    // Unreadable: drop the entry unless it was replaced meanwhile
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(entry.url);
+    if (it != entries.end() && it->second.file == entry.file) {
+        DropEntry(entry.url, true);
+        AppendRecord("D\t" + entry.url);
+    }
+    return false;
+}
+
+void HttpCache::Revalidate(const std::string& url, time_t expiresAt, const std::string& etag,
+                           const std::string& lastModified) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(CanonicalizeUrl(url));
+    if (it == entries.end()) return;
+    
+    CacheEntry& entry = it->second;
+    entry.expiresAt = expiresAt;
+    if (!etag.empty() && IsPlainField(etag)) entry.etag = etag;
+    if (!lastModified.empty() && IsPlainField(lastModified)) entry.lastModified = lastModified;
+    WriteEntry(entry);
+    CompactIfNeeded();
+}
+
+void HttpCache::Remove(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key = CanonicalizeUrl(url);
+    if (entries.find(key) == entries.end()) return;
+    
+    DropEntry(key, true);
+    AppendRecord("D\t" + key);
+    CompactIfNeeded();
+}
+
+HttpCacheWriter* HttpCache::BeginStore(bool bodyIsGzip) {
+    std::string tempPath;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!journal) return nullptr;
+        tempPath = directory + "tmp-" + std::to_string(tempCounter++);
+    }
+    
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return nullptr;
+    return new HttpCacheWriter(file, tempPath, bodyIsGzip);
+}
+
+bool HttpCache::CommitStore(HttpCacheWriter* writer, CacheEntry& entry) {
+    if (!writer) return false;
+    
+    entry.url = CanonicalizeUrl(entry.url);
+    bool ok = writer->Finish() && IsPlainField(entry.url) && IsPlainField(entry.etag) &&
+              IsPlainField(entry.lastModified);
+    
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)writer->hash);
+    entry.file = name;
+    entry.storedBytes = writer->storedBytes;
+    std::string tempPath = writer->tempPath;
+    delete writer;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ok || !journal || entry.storedBytes > budgetBytes) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    
+    DropEntry(entry.url, true);
+    
+    // Same bytes already on disk under another URL
+    if (fileRefs.count(entry.file)) {
+        remove(tempPath.c_str());
+    } else {
+        std::string path = BodyPath(entry.file);
+        if (rename(tempPath.c_str(), path.c_str()) != 0) {
+            remove(path.c_str());
+            if (rename(tempPath.c_str(), path.c_str()) != 0) {
+                remove(tempPath.c_str());
+                AppendRecord("D\t" + entry.url);
+                return false;
+            }
+        }
+    }
+    
+    AddEntry(entry);
+    WriteEntry(entry);
+    EvictToBudget();
+    CompactIfNeeded();
+    return entries.count(entry.url) > 0;
+}
+
+void HttpCache::AbortStore(HttpCacheWriter* writer) {
+    if (!writer) return;
+    std::string tempPath = writer->tempPath;
+    delete writer;
+    remove(tempPath.c_str());
+}
+
+bool HttpCache::ComputeExpiry(const std::string& cacheControl, const std::string& expires,
+                              const std::string& lastModified, const std::string& vary,
+                              time_t now, time_t& expiresAt) {
+    // Requests differ only in Accept-Encoding, and bodies are stored decoded
+    std::string varyValue = ToLower(vary);
+    size_t start = 0;
+    while (start <= varyValue.size()) {
+        size_t comma = varyValue.find(',', start);
+        if (comma == std::string::npos) comma = varyValue.size();
+        std::string field = Trim(varyValue.substr(start, comma - start));
+        if (!field.empty() && field != "accept-encoding" && field != "user-agent") return false;
+        start = comma + 1;
+    }
+    
+    bool noCache = false;
+    long maxAge = -1;
+    std::string directives = ToLower(cacheControl);
+    start = 0;
+    while (start <= directives.size()) {
+        size_t comma = directives.find(',', start);
+        if (comma == std::string::npos) comma = directives.size();
+        std::string directive = Trim(directives.substr(start, comma - start));
+        start = comma + 1;
+        
+        if (directive == "no-store") return false;
+        if (directive == "no-cache") {
+            noCache = true;
+        } else if (directive.compare(0, 8, "max-age=") == 0) {
+            maxAge = strtol(directive.c_str() + 8, nullptr, 10);
+        }
+    }
+    
+    if (noCache) {
+        expiresAt = now;  // Stored, but revalidated before every use
+    } else if (maxAge >= 0) {
+        expiresAt = now + maxAge;
+    } else if (!expires.empty()) {
+        time_t when = ParseWebDate(expires);
+        expiresAt = when > 0 ? when : now;  // Invalid dates mean already expired
+    } else if (!lastModified.empty()) {
+        time_t modified = ParseWebDate(lastModified);
+        time_t lifetime = 0;
+        if (modified > 0 && modified < now) {
+            lifetime = std::min(MAX_HEURISTIC_SECONDS,
+                                (time_t)((now - modified) * LAST_MODIFIED_FRACTION));
+        }
+        expiresAt = now + lifetime;
+    } else {
+        expiresAt = now;
+    }
+    return true;
+}
+
+size_t HttpCache::GetStoredBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return storedBytes;
+}
+
+size_t HttpCache::GetEntryCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+CacheStats HttpCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
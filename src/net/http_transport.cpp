@@ -0,0 +1,412 @@
+#include "http_transport.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <strings.h>
+
+// Status line plus headers; anything longer is not a server we want
+static const size_t MAX_LINE_BYTES = 64 * 1024;
+
+static std::string ToLower(std::string s) {
+    for (auto& c : s) c = tolower((unsigned char)c);
+    return s;
+}
+
+std::string HttpUrl::Origin() const {
+    return scheme + "://" + host + ":" + std::to_string(port);
+}
+
+bool ParseHttpUrl(const std::string& url, HttpUrl& out) {
+    size_t sep = url.find("://");
+    if (sep == std::string::npos) return false;
+    
+    out.scheme = ToLower(url.substr(0, sep));
+    int defaultPort;
+    if (out.scheme == "http") {
+        defaultPort = 80;
+    } else if (out.scheme == "https") {
+        defaultPort = 443;
+    } else {
+        return false;
+    }
+    
+    size_t hostStart = sep + 3;
+    size_t pathStart = url.find_first_of("/?#", hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ?
+                                                  std::string::npos : pathStart - hostStart);
+    
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) authority = authority.substr(at + 1);
+    
+    // "[v6::addr]:port" or "host:port"
+    size_t portSep = std::string::npos;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) return false;
+        if (close + 1 < authority.size() && authority[close + 1] == ':') portSep = close + 1;
+    } else {
+        portSep = authority.rfind(':');
+    }
+    
+    out.port = defaultPort;
+    if (portSep != std::string::npos) {
+        std::string port = authority.substr(portSep + 1);
+        authority = authority.substr(0, portSep);
+        if (!port.empty()) {
+            for (char c : port) {
+                if (!isdigit((unsigned char)c)) return false;
+            }
+            out.port = atoi(port.c_str());
+            if (out.port <= 0 || out.port > 65535) return false;
+        }
+    }
+    
+    out.host = ToLower(authority);
+    if (out.host.empty()) return false;
+    
+    out.path = pathStart == std::string::npos ? "" : url.substr(pathStart);
+    size_t hash = out.path.find('#');
+    if (hash != std::string::npos) out.path.erase(hash);
+    if (out.path.empty() || out.path[0] != '/') out.path.insert(0, "/");
+    return true;
+}
+
+namespace {
+
+class PosixHttpConnection : public HttpConnection {
+public:
+    PosixHttpConnection(int fd, const HttpUrl& url);
+    ~PosixHttpConnection();
+    
+    bool SendRequest(const HttpRequest& request, int& statusCode);
+    std::string GetResponseHeader(const char* name);
+    void GetResponseHeaders(std::vector<HttpHeader>& headers) { headers = responseHeaders; }
+    int64_t GetContentLength() { return contentLength; }
+    int ReadBody(char* buffer, size_t size);
+    void EndRequest();
+    bool IsReusable() const { return keepAlive && bodyDone && !failed && !aborted; }
+    int GetLastError() const { return lastError; }
+    void Abort();
+    
+private:
+    enum BodyMode { BODY_NONE, BODY_LENGTH, BODY_CHUNKED, BODY_UNTIL_CLOSE };
+    
+    int fd;
+    std::string hostHeader;
+    int lastError;
+    
+    // Received bytes; data before bufferPos is consumed
+    std::string buffer;
+    size_t bufferPos;
+    
+    std::vector<HttpHeader> responseHeaders;
+    BodyMode bodyMode;
+    int64_t contentLength;
+    int64_t remaining;    // Left in the body (length) or current chunk
+    bool chunkCRLF;       // Chunk data done, its CRLF not read yet
+    bool bodyDone;
+    bool keepAlive;
+    bool failed;
+    std::atomic<bool> aborted;
+    
+    void SetTimeout(int seconds);
+    bool Fill();
+    bool ReadLine(std::string& line);
+    bool ReadHead(int& statusCode, bool& http11);
+    bool NextChunk();
+};
+
+PosixHttpConnection::PosixHttpConnection(int fd, const HttpUrl& url)
+    : fd(fd), lastError(0), bufferPos(0), bodyMode(BODY_NONE), contentLength(-1),
+      remaining(0), chunkCRLF(false), bodyDone(true), keepAlive(true), failed(false),
+      aborted(false) {
+    bool defaultPort = (url.scheme == "http" && url.port == 80) ||
+                       (url.scheme == "https" && url.port == 443);
+    hostHeader = defaultPort ? url.host : url.host + ":" + std::to_string(url.port);
+}
+
+PosixHttpConnection::~PosixHttpConnection() {
+    close(fd);
+}
+
+// Shutting the socket down wakes a blocked send/recv; the fd stays open
+// until the owner deletes the connection
+void PosixHttpConnection::Abort() {
+    aborted = true;
+    shutdown(fd, SHUT_RDWR);
+}
+
+void PosixHttpConnection::SetTimeout(int seconds) {
+    struct timeval tv;
+    tv.tv_sec = seconds;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+bool PosixHttpConnection::Fill() {
+    if (bufferPos == buffer.size()) {
+        buffer.clear();
+        bufferPos = 0;
+    } else if (bufferPos > MAX_LINE_BYTES) {
+        buffer.erase(0, bufferPos);
+        bufferPos = 0;
+    }
+    
+    char chunk[16384];
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0 || aborted) {
+        lastError = aborted ? ECANCELED : (n < 0 ? errno : ECONNRESET);
+        return false;
+    }
+    buffer.append(chunk, n);
+    return true;
+}
+
+// One CRLF-terminated line, terminator stripped
+bool PosixHttpConnection::ReadLine(std::string& line) {
+    while (true) {
+        size_t nl = buffer.find('\n', bufferPos);
+        if (nl != std::string::npos) {
+            size_t end = nl > bufferPos && buffer[nl - 1] == '\r' ? nl - 1 : nl;
+            line.assign(buffer, bufferPos, end - bufferPos);
+            bufferPos = nl + 1;
+            return true;
+        }
+        if (buffer.size() - bufferPos > MAX_LINE_BYTES) {
+            lastError = EMSGSIZE;
+            return false;
+        }
+        if (!Fill()) return false;
+    }
+}
+
+bool PosixHttpConnection::ReadHead(int& statusCode, bool& http11) {
+    std::string line;
+    if (!ReadLine(line)) return false;
+    if (line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+        lastError = EPROTO;
+        return false;
+    }
+    http11 = line.compare(5, 3, "1.0") != 0;
+    statusCode = atoi(line.c_str() + 9);
+    
+    responseHeaders.clear();
+    while (ReadLine(line)) {
+        if (line.empty()) return true;
+        
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        
+        HttpHeader header;
+        header.name = line.substr(0, colon);
+        size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        size_t valueEnd = line.find_last_not_of(" \t");
+        if (valueStart != std::string::npos) {
+            header.value = line.substr(valueStart, valueEnd + 1 - valueStart);
+        }
+        responseHeaders.push_back(header);
+    }
+    return false;
+}
+
+bool PosixHttpConnection::SendRequest(const HttpRequest& request, int& statusCode) {
+    responseHeaders.clear();
+    contentLength = -1;
+    remaining = 0;
+    chunkCRLF = false;
+    bodyDone = false;
+    failed = true;  // Until the head is in
+    if (aborted) {
+        lastError = ECANCELED;
+        return false;
+    }
+    
+    HttpUrl url;
+    if (!ParseHttpUrl(request.url, url)) {
+        lastError = EINVAL;
+        return false;
+    }
+    SetTimeout(request.timeoutSec);
+    
+    std::string head = request.method + " " + url.path + " HTTP/1.1\r\n";
+    head += "Host: " + hostHeader + "\r\n";
+    for (const auto& header : request.headers) {
+        head += header.name + ": " + header.value + "\r\n";
+    }
+    head += "\r\n";
+    
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;  // A peer that hung up is an error, not SIGPIPE
+#endif
+    for (size_t sent = 0; sent < head.size();) {
+        ssize_t n = send(fd, head.data() + sent, head.size() - sent, flags);
+        if (n <= 0) {
+            lastError = n < 0 ? errno : ECONNRESET;
+            return false;
+        }
+        sent += n;
+    }
+    
+    // Interim 1xx responses come before the real one
+    bool http11 = true;
+    do {
+        if (!ReadHead(statusCode, http11)) return false;
+    } while (statusCode >= 100 && statusCode < 200);
+    
+    std::string connection = ToLower(GetResponseHeader("Connection"));
+    keepAlive = http11 ? connection.find("close") == std::string::npos :
+                         connection.find("keep-alive") != std::string::npos;
+    
+    std::string length = GetResponseHeader("Content-Length");
+    if (!length.empty()) contentLength = strtoll(length.c_str(), nullptr, 10);
+    
+    if (request.method == "HEAD" || statusCode == 204 || statusCode == 304) {
+        bodyMode = BODY_NONE;
+        bodyDone = true;
+    } else if (ToLower(GetResponseHeader("Transfer-Encoding")).find("chunked") != std::string::npos) {
+        bodyMode = BODY_CHUNKED;
+        contentLength = -1;
+    } else if (contentLength >= 0) {
+        bodyMode = BODY_LENGTH;
+        remaining = contentLength;
+        bodyDone = (remaining == 0);
+    } else {
+        // Body ends when the server closes
+        bodyMode = BODY_UNTIL_CLOSE;
+        keepAlive = false;
+    }
+    
+    failed = false;
+    return true;
+}
+
+std::string PosixHttpConnection::GetResponseHeader(const char* name) {
+    for (const auto& header : responseHeaders) {
+        if (strcasecmp(header.name.c_str(), name) == 0) return header.value;
+    }
+    return "";
+}
+
+// Reads the next chunk-size line; false at the last chunk or on error
+bool PosixHttpConnection::NextChunk() {
+    std::string line;
+    if (chunkCRLF) {
+        if (!ReadLine(line)) {
+            failed = true;
+            return false;
+        }
+        chunkCRLF = false;
+    }
+    
+    if (!ReadLine(line)) {
+        failed = true;
+        return false;
+    }
+    remaining = strtoll(line.c_str(), nullptr, 16);  // Chunk extensions stop the parse
+    if (remaining > 0) return true;
+    
+    // Last chunk: skip trailers up to the empty line
+    while (ReadLine(line)) {
+        if (line.empty()) {
+            bodyDone = true;
+            return false;
+        }
+    }
+    failed = true;
+    return false;
+}
+
+int PosixHttpConnection::ReadBody(char* out, size_t size) {
+    if (failed) return -1;
+    if (bodyDone || size == 0) return 0;
+    
+    if (bodyMode == BODY_CHUNKED && remaining == 0 && !NextChunk()) {
+        return failed ? -1 : 0;
+    }
+    
+    if (bufferPos == buffer.size() && !Fill()) {
+        // An aborted read is not the server closing
+        if (bodyMode == BODY_UNTIL_CLOSE && !aborted) {
+            bodyDone = true;
+            return 0;
+        }
+        failed = true;
+        return -1;
+    }
+    
+    size_t n = std::min(size, buffer.size() - bufferPos);
+    if (bodyMode != BODY_UNTIL_CLOSE) n = (size_t)std::min<int64_t>(n, remaining);
+    memcpy(out, buffer.data() + bufferPos, n);
+    bufferPos += n;
+    
+    if (bodyMode != BODY_UNTIL_CLOSE) {
+        remaining -= n;
+        if (remaining == 0) {
+            if (bodyMode == BODY_LENGTH) bodyDone = true;
+            else chunkCRLF = true;
+        }
+    }
+    return (int)n;
+}
+
+void PosixHttpConnection::EndRequest() {
+    // The rest of an abandoned body would be read as the next response
+    if (!bodyDone) keepAlive = false;
+}
+    
+} // namespace
+
+HttpConnection* PosixHttpTransport::Connect(const HttpUrl& url, int timeoutSec, int& error) {
+    if (url.scheme != "http") {
+        error = EPROTONOSUPPORT;
+        return nullptr;
+    }
+    
+    std::string host = url.host;
+    if (host.size() > 2 && host[0] == '[') host = host.substr(1, host.size() - 2);
+    
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    struct addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(url.port).c_str(), &hints, &addresses) != 0) {
+        error = EHOSTUNREACH;
+        return nullptr;
+    }
+    
+    struct timeval tv;
+    tv.tv_sec = timeoutSec;
+    tv.tv_usec = 0;
+    
+    int fd = -1;
+    error = ECONNREFUSED;
+    for (struct addrinfo* ai = addresses; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        
+        // Bounds connect() as well on Linux
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        
+        error = errno;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    
+    if (fd < 0) return nullptr;
+    error = 0;
+    return new PosixHttpConnection(fd, url);
+}
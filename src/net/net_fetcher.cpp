@@ -1,10 +1,57 @@
 #include "net_fetcher.h"
+#include "content_decoder.h"
+#ifdef __vita__
+#include "vita_transport.h"
 #include <psp2/sysmodule.h>
+#endif
 #include <cstring>
 #include <algorithm>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <cctype>
+#include <cstdlib>
+#include <strings.h>
+
+// Connection pool bounds: open connections in total, idle ones kept per
+// host, and how long an idle one is kept
+static const int POOL_MAX_CONNECTIONS = 4;
+static const int POOL_MAX_IDLE_PER_HOST = 2;
+static const int POOL_IDLE_TIMEOUT_SECONDS = 30;
+
+// Batch fetches: requests per second per host, burst, and in flight per host
+static const double HOST_REQUESTS_PER_SECOND = 1.0;
+static const int HOST_BURST = 2;
+static const int HOST_MAX_ACTIVE = 2;
+
+// Connecting (DNS, TCP, TLS) gets less time than a slow server may stall
+static const int CONNECT_TIMEOUT_SECONDS = 10;
+
+// Retry backoff: doubles from the base up to the cap, jittered into its upper
+// half. A longer Retry-After than the cap is not waited for
+static const int RETRY_BASE_DELAY_MS = 500;
+static const int RETRY_MAX_DELAY_MS = 8000;
+static const int MAX_RETRY_AFTER_SECONDS = 8;
+
+// Host circuit: consecutive failures to open it, first and longest open period
+static const int CIRCUIT_FAILURE_THRESHOLD = 3;
+static const int CIRCUIT_OPEN_SECONDS = 60;
+static const int CIRCUIT_MAX_OPEN_SECONDS = 15 * 60;
+
+// Bodies are cut off at this size, compressed or decompressed
+static const size_t MAX_BODY_BYTES = 5 * 1024 * 1024;
+
+// Batches under a budget check its deadline this often
+static const int BUDGET_POLL_MS = 100;
 
 NetFetcher::NetFetcher() : initialized(false), netMemId(-1), httpMemId(-1),
-                           lastError(0), timeoutSeconds(30), maxRetries(3) {
+                           lastError(0), timeoutSeconds(30),
+                           connectTimeoutSeconds(CONNECT_TIMEOUT_SECONDS), maxRetries(3),
+                           cache(nullptr), retryJitter((unsigned int)time(nullptr)),
+                           transport(nullptr), ownsTransport(false), pool(nullptr),
+                           hostThrottle(HOST_REQUESTS_PER_SECOND, HOST_BURST, HOST_MAX_ACTIVE),
+                           breaker(CIRCUIT_FAILURE_THRESHOLD, CIRCUIT_OPEN_SECONDS,
+                                   CIRCUIT_MAX_OPEN_SECONDS) {
     userAgent = "VitaSurvivalAI/1.0 (PS Vita; Educational/Research)";
 }
 
@@ -12,25 +59,42 @@ NetFetcher::~NetFetcher() {
     Shutdown();
 }
 
-bool NetFetcher::Initialize() {
+bool NetFetcher::Initialize(HttpTransport* customTransport) {
     if (initialized) return true;
     
     if (!InitNetModules()) {
         return false;
     }
     
+    ownsTransport = (customTransport == nullptr);
+#ifdef __vita__
+    transport = customTransport ? customTransport : new VitaHttpTransport(userAgent);
+#else
+    transport = customTransport ? customTransport : new PosixHttpTransport();
+#endif
+    pool = new ConnectionPool(transport, POOL_MAX_CONNECTIONS, POOL_MAX_IDLE_PER_HOST,
+                              POOL_IDLE_TIMEOUT_SECONDS);
+    
     initialized = true;
     return true;
 }
 
 void NetFetcher::Shutdown() {
     if (initialized) {
+        // Connections go before the template they were made from
+        delete pool;
+        pool = nullptr;
+        if (ownsTransport) delete transport;
+        transport = nullptr;
+        
         ShutdownNetModules();
         initialized = false;
     }
 }
 
+// Host builds (tools, benchmarks) have the OS network stack already up
 bool NetFetcher::InitNetModules() {
+#ifdef __vita__
     // Load network modules
     sceSysmoduleLoadModule(SCE_SYSMODULE_NET);
     sceSysmoduleLoadModule(SCE_SYSMODULE_HTTPS);
@@ -62,11 +126,13 @@ bool NetFetcher::InitNetModules() {
         lastError = ret;
         return false;
     }
+#endif
     
     return true;
 }
 
 void NetFetcher::ShutdownNetModules() {
+#ifdef __vita__
     sceHttpTerm();
     sceNetCtlTerm();
     sceNetTerm();
@@ -74,6 +140,7 @@ void NetFetcher::ShutdownNetModules() {
     sceSysmoduleUnloadModule(SCE_SYSMODULE_HTTP);
     sceSysmoduleUnloadModule(SCE_SYSMODULE_HTTPS);
     sceSysmoduleUnloadModule(SCE_SYSMODULE_NET);
+#endif
 }
 
 bool NetFetcher::IsOnline() {
@@ -82,162 +149,637 @@ bool NetFetcher::IsOnline() {
 }
 
 bool NetFetcher::CheckWiFiConnection() {
+#ifdef __vita__
     SceNetCtlInfo info;
     int ret = sceNetCtlInetGetInfo(SCE_NETCTL_INFO_GET_IP_ADDRESS, &info);
     return (ret >= 0);
+#else
+    return true;
+#endif
 }
 
 std::string NetFetcher::GetConnectionType() {
     if (!IsOnline()) return "offline";
-    
+
+#ifdef __vita__
     SceNetCtlInfo info;
     int ret = sceNetCtlInetGetInfo(SCE_NETCTL_INFO_GET_SSID, &info);
     if (ret >= 0) {
         return "WiFi: " + std::string(info.ssid);
     }
+#endif
     return "connected";
 }
 
-FetchResult NetFetcher::FetchURL(const std::string& url, int timeoutSec) {
+FetchResult NetFetcher::FetchURL(const std::string& url, int timeoutSec, bool conditional,
+                                 FetchBudget* budget) {
+    std::string html;
+    FetchResult result = Fetch(url, timeoutSec, std::vector<HttpHeader>(), conditional,
+        [&html](const char* data, size_t length) {
+            html.append(data, length);
+            return true;
+        }, budget);
+    result.html.swap(html);
+    return result;
+}
+
+FetchResult NetFetcher::FetchURLStreaming(const std::string& url, const ChunkCallback& onChunk,
+                                          int timeoutSec, bool conditional,
+                                          FetchBudget* budget) {
+    return Fetch(url, timeoutSec, std::vector<HttpHeader>(), conditional, onChunk, budget);
+}
+
+FetchResult NetFetcher::Fetch(const std::string& url, int timeoutSec,
+                              const std::vector<HttpHeader>& headers, bool conditional,
+                              const ChunkCallback& onChunk, FetchBudget* budget) {
     FetchResult result;
     result.url = url;
     result.success = false;
     result.statusCode = 0;
+    result.bytesRead = 0;
+    result.bytesDecoded = 0;
+    result.stoppedEarly = false;
+    result.truncated = false;
+    result.notModified = false;
+    result.fromCache = false;
+    result.overBudget = false;
+    
+    // Custom headers may change the response, so those requests skip the cache
+    CacheEntry cached;
+    bool haveCached = cache && headers.empty() && cache->Lookup(url, cached);
+    bool offline = !initialized || !CheckWiFiConnection();
+    
+    HttpValidators stored;
+    bool haveStored = conditional && validatorLookup && validatorLookup(url, stored) &&
+                      !stored.Empty();
+    
+    // Fresh (or all we have): no request at all. A partial body is only
+    // good enough offline
+    if (haveCached && (offline || (cached.complete && cached.IsFresh(time(nullptr))))) {
+        if (haveStored && stored.etag == cached.etag && stored.lastModified == cached.lastModified) {
+            // The caller already holds this very response
+            result.success = true;
+            result.notModified = true;
+            result.fromCache = true;
+            result.validators = stored;
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.cacheHits++;
+            return result;
+        }
+        if (ServeFromCache(cached, onChunk, result) || result.bytesDecoded > 0) {
+            if (result.success && conditional && validatorUpdate && !result.validators.Empty()) {
+                validatorUpdate(url, result.validators);
+            }
+            return result;
+        }
+        haveCached = false;  // Unreadable; it has been dropped
+    }
     
     if (!initialized) {
         result.error = "Network not initialized";
         return result;
     }
-    
-    int tmplId = -1, connId = -1, reqId = -1;
-    
-    // Create HTTP template
-    tmplId = sceHttpCreateTemplate(userAgent.c_str(), SCE_HTTP_VERSION_1_1, SCE_TRUE);
-    if (tmplId < 0) {
-        result.error = "Failed to create HTTP template";
-        lastError = tmplId;
+    if (offline) {
+        result.error = "Offline";
         return result;
     }
     
-    // Create connection
-    connId = sceHttpCreateConnectionWithURL(tmplId, url.c_str(), SCE_FALSE);
-    if (connId < 0) {
-        result.error = "Failed to create connection";
-        lastError = connId;
-        CleanupHTTP(tmplId, -1, -1);
+    HttpUrl target;
+    if (!ParseHttpUrl(url, target)) {
+        result.error = "Invalid URL";
         return result;
     }
     
-    // Create request
-    reqId = sceHttpCreateRequestWithURL(connId, SCE_HTTP_METHOD_GET, url.c_str(), 0);
-    if (reqId < 0) {
-        result.error = "Failed to create request";
-        lastError = reqId;
-        CleanupHTTP(tmplId, connId, -1);
-        return result;
+    HttpRequest request;
+    request.url = url;
+    request.timeoutSec = timeoutSec;
+    
+    HttpHeader agent;
+    agent.name = "User-Agent";
+    agent.value = userAgent;
+    request.headers.push_back(agent);
+    
+    // Pages and feeds compress 5-10x; ReadResponse inflates them as they arrive
+    bool callerEncoding = false;
+    for (const auto& header : headers) {
+        if (strcasecmp(header.name.c_str(), "Accept-Encoding") == 0) callerEncoding = true;
     }
+    if (!callerEncoding) {
+        HttpHeader encoding;
+        encoding.name = "Accept-Encoding";
+        encoding.value = "gzip, deflate";
+        request.headers.push_back(encoding);
+    }
+    request.headers.insert(request.headers.end(), headers.begin(), headers.end());
     
-    // Set timeout
-    sceHttpSetRequestContentLength(reqId, 0);
-    sceHttpSetConnectTimeOut(connId, timeoutSec * 1000000);  // microseconds
-    sceHttpSetSendTimeOut(reqId, timeoutSec * 1000000);
-    sceHttpSetRecvTimeOut(reqId, timeoutSec * 1000000);
+    // Validators from the last full response turn this into a conditional
+    // GET: the caller's own, else those of a stale cache entry
+    HttpValidators sent;
+    if (haveStored) {
+        sent = stored;
+    } else if (haveCached && cached.complete) {
+        sent.etag = cached.etag;
+        sent.lastModified = cached.lastModified;
+        sent.bodyBytes = cached.bodyBytes;
+    }
+    if (!sent.etag.empty()) {
+        HttpHeader header;
+        header.name = "If-None-Match";
+        header.value = sent.etag;
+        request.headers.push_back(header);
+    }
+    if (!sent.lastModified.empty()) {
+        HttpHeader header;
+        header.name = "If-Modified-Since";
+        header.value = sent.lastModified;
+        request.headers.push_back(header);
+    }
     
-    // Send request
-    int ret = sceHttpSendRequest(reqId, NULL, 0);
-    if (ret < 0) {
-        result.error = "Failed to send request";
-        lastError = ret;
-        CleanupHTTP(tmplId, connId, reqId);
+    // Transient failures are retried (GETs are idempotent) after a jittered,
+    // growing delay; a host that keeps failing trips its circuit, and further
+    // requests to it fail at once instead of each waiting out the timeouts
+    int connectTimeoutSec = std::min(connectTimeoutSeconds, timeoutSec);
+    bool idempotent = request.method == "GET" || request.method == "HEAD";
+    HttpConnection* conn = nullptr;
+    for (int attempt = 0; ; attempt++) {
+        if (!breaker.Allow(target.host, CircuitBreaker::Clock::now())) {
+            result.error = "Host unavailable (repeated failures)";
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.hostRejections++;
+            break;
+        }
+        
+        // Each attempt spends a request of the budget, and no wait on the
+        // server may run past its deadline
+        if (budget) {
+            if (!budget->BeginRequest()) {
+                result.error = "Over budget";
+                result.overBudget = true;
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats.budgetStops++;
+                break;
+            }
+            request.timeoutSec = budget->ClampTimeout(timeoutSec);
+            connectTimeoutSec = std::min(connectTimeoutSeconds, request.timeoutSec);
+        }
+        
+        bool hostFailed = false;
+        conn = OpenRequest(target, request, connectTimeoutSec, budget, result, hostFailed);
+        if (!conn && budget && budget->IsExhausted()) {
+            // Aborted by the budget: no fault of the host's
+            result.error = "Over budget";
+            result.overBudget = true;
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.budgetStops++;
+            break;
+        }
+        if (conn && result.statusCode >= 500) hostFailed = true;
+        if (hostFailed) {
+            breaker.RecordFailure(target.host, CircuitBreaker::Clock::now());
+        } else if (conn) {
+            breaker.RecordSuccess(target.host);
+        }
+        
+        bool transient = !conn || result.statusCode >= 500 || result.statusCode == 429;
+        if (!transient || !idempotent || attempt >= maxRetries) break;
+        
+        int delayMs = GetRetryDelayMs(attempt, conn);
+        if (delayMs < 0) break;  // Told to come back much later
+        if (budget && budget->GetRemainingMs() >= 0 && delayMs >= budget->GetRemainingMs()) break;
+        if (conn) {
+            ReleaseConnection(conn, target, false, budget);
+            conn = nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.retries++;
+        }
+        
+        // In steps under a budget, so a cancel doesn't wait out the backoff
+        auto wakeAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+        while (std::chrono::steady_clock::now() < wakeAt && !(budget && budget->IsExhausted())) {
+            int step = budget ? std::min(delayMs, BUDGET_POLL_MS) : delayMs;
+            std::this_thread::sleep_for(std::chrono::milliseconds(step));
+        }
+    }
+    if (!conn) {
+        // Unreachable: a stale copy beats nothing
+        if (haveCached && ServeFromCache(cached, onChunk, result)) {
+            result.error.clear();
+            result.overBudget = false;
+        }
         return result;
     }
     
-    // Get status code
-    ret = sceHttpGetStatusCode(reqId, &result.statusCode);
-    if (ret < 0) {
-        result.error = "Failed to get status code";
-        lastError = ret;
-        CleanupHTTP(tmplId, connId, reqId);
+    time_t now = time(nullptr);
+    
+    // Unchanged since the stored copy: no body to read or parse
+    if (result.statusCode == 304 && !sent.Empty()) {
+        result.validators = sent;
+        ReadValidators(conn, result);
+        
+        bool cacheCurrent = haveCached && sent.etag == cached.etag &&
+                            sent.lastModified == cached.lastModified;
+        if (cacheCurrent) {
+            time_t expiresAt = now;
+            if (GetCacheExpiry(conn, now, expiresAt)) {
+                cache->Revalidate(url, expiresAt, result.validators.etag,
+                                  result.validators.lastModified);
+            } else {
+                cache->Remove(url);
+            }
+        }
+        ReleaseConnection(conn, target, true, budget);
+        
+        if (haveStored) {
+            result.success = true;
+            result.notModified = true;
+            if (validatorUpdate) validatorUpdate(url, result.validators);
+            CountTransfer(result, stored.bodyBytes);
+            return result;
+        }
+        
+        // Our own revalidation: the caller gets the cached body
+        CountTransfer(result, 0);
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.notModified++;
+            stats.bytesSaved += cached.bodyBytes;
+        }
+        if (!ServeFromCache(cached, onChunk, result) && result.error.empty()) {
+            result.error = "Cached copy unreadable";
+        }
         return result;
     }
     
     // Check for success status
     if (result.statusCode < 200 || result.statusCode >= 300) {
         result.error = "HTTP error: " + std::to_string(result.statusCode);
-        CleanupHTTP(tmplId, connId, reqId);
+        ReleaseConnection(conn, target, false, budget);
+        
+        // Server trouble: keep serving what we had
+        if (result.statusCode >= 500 && haveCached && ServeFromCache(cached, onChunk, result)) {
+            result.error.clear();
+        }
         return result;
     }
     
+    ReadValidators(conn, result);
+    
+    // Store a copy when the response allows it
+    HttpCacheWriter* store = nullptr;
+    time_t expiresAt = now;
+    if (cache && headers.empty() && result.statusCode == 200 &&
+        GetCacheExpiry(conn, now, expiresAt)) {
+        ContentDecoder::Encoding encoding =
+            ContentDecoder::ParseEncoding(conn->GetResponseHeader("Content-Encoding"));
+        store = cache->BeginStore(encoding == ContentDecoder::ENCODING_GZIP);
+    }
+    
     // Read response
-    if (!ReadResponse(reqId, result.html)) {
-        result.error = "Failed to read response";
-        CleanupHTTP(tmplId, connId, reqId);
+    if (!ReadResponse(conn, onChunk, store, budget, result)) {
+        if (result.overBudget) {
+            result.error = "Over budget";
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.budgetStops++;
+        } else {
+            result.error = "Failed to read response";
+            breaker.RecordFailure(target.host, CircuitBreaker::Clock::now());
+        }
+        ReleaseConnection(conn, target, false, budget);
+        if (store) cache->AbortStore(store);
+        CountTransfer(result, 0);
         return result;
     }
     
     result.success = true;
-    CleanupHTTP(tmplId, connId, reqId);
+    
+    // A body cut short by the consumer still counts at full size for savings
+    int64_t contentLength = conn->GetContentLength();
+    if (contentLength > 0) {
+        result.validators.bodyBytes = (size_t)contentLength;
+    } else {
+        result.validators.bodyBytes = result.bytesRead;
+    }
+    
+    // A body cut off at the size cap is partial; never keep it
+    if (store && result.truncated) {
+        cache->AbortStore(store);
+        store = nullptr;
+    }
+    
+    if (store) {
+        CacheEntry entry;
+        entry.url = url;
+        entry.bodyBytes = result.bytesDecoded;
+        entry.fetchedAt = now;
+        entry.expiresAt = expiresAt;
+        entry.lastUsed = now;
+        entry.complete = !result.stoppedEarly;
+        entry.etag = conn->GetResponseHeader("ETag");
+        entry.lastModified = conn->GetResponseHeader("Last-Modified");
+        cache->CommitStore(store, entry);
+    } else if (haveCached) {
+        cache->Remove(url);  // Replaced by a response we may not keep
+    }
+    
+    // Fully read bodies leave the connection ready for the next request
+    ReleaseConnection(conn, target, true, budget);
+    
+    if (conditional && validatorUpdate && !result.validators.Empty()) {
+        validatorUpdate(url, result.validators);
+    }
+    CountTransfer(result, 0);
     
     return result;
 }
 
-bool NetFetcher::ReadResponse(int reqId, std::string& outHtml) {
+// Sends request on a pooled connection and reads the status. A kept-alive
+// connection the server has since closed fails on send; that one gets a
+// single retry on a fresh connection. hostFailed: the host could not be
+// reached (not just a full pool). The connection returned is attached to
+// budget
+HttpConnection* NetFetcher::OpenRequest(const HttpUrl& target, const HttpRequest& request,
+                                        int connectTimeoutSec, FetchBudget* budget,
+                                        FetchResult& result, bool& hostFailed) {
+    result.statusCode = 0;
+    hostFailed = false;
+    
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = false;
+        int error = 0;
+        HttpConnection* conn = pool->Acquire(target, connectTimeoutSec, reused, error);
+        if (!conn) {
+            result.error = "Failed to create connection";
+            lastError = error;
+            hostFailed = (error != POOL_ERROR_BUSY);
+            return nullptr;
+        }
+        
+        if (budget) budget->Attach(conn);
+        if (conn->SendRequest(request, result.statusCode)) {
+            result.error.clear();
+            return conn;
+        }
+        
+        lastError = conn->GetLastError();
+        ReleaseConnection(conn, target, false, budget);
+        if (budget && budget->IsExhausted()) break;  // Aborted, not a dead kept-alive socket
+        if (!reused) break;
+    }
+    
+    result.error = "Failed to send request";
+    hostFailed = true;
+    return nullptr;
+}
+
+// Ends the request and hands the connection back to the pool (detached
+// from the budget first, so a late Cancel can't abort it while pooled)
+void NetFetcher::ReleaseConnection(HttpConnection* conn, const HttpUrl& target, bool keep,
+                                   FetchBudget* budget) {
+    if (budget) budget->Detach(conn);
+    conn->EndRequest();
+    pool->Release(conn, target, keep && conn->IsReusable());
+}
+
+// Backoff before retry number attempt + 1; -1 when the server's Retry-After
+// is longer than worth waiting for
+int NetFetcher::GetRetryDelayMs(int attempt, HttpConnection* conn) {
+    if (conn) {
+        std::string retryAfter = conn->GetResponseHeader("Retry-After");
+        if (!retryAfter.empty() && isdigit((unsigned char)retryAfter[0])) {
+            int seconds = atoi(retryAfter.c_str());
+            return seconds <= MAX_RETRY_AFTER_SECONDS ? seconds * 1000 : -1;
+        }
+    }
+    
+    int delay = std::min(RETRY_MAX_DELAY_MS, RETRY_BASE_DELAY_MS << std::min(attempt, 10));
+    
+    // Jitter keeps a batch's retries to one host from arriving together
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return delay / 2 + (int)(retryJitter() % (unsigned int)(delay / 2 + 1));
+}
+
+// Replays a cached body as if it had just been fetched
+bool NetFetcher::ServeFromCache(const CacheEntry& entry, const ChunkCallback& onChunk,
+                                FetchResult& result) {
+    result.bytesDecoded = 0;
+    auto deliver = [&result, &onChunk](const char* data, size_t length) {
+        result.bytesDecoded += length;
+        if (!onChunk(data, length)) {
+            result.stoppedEarly = true;
+            return false;
+        }
+        return true;
+    };
+    
+    if (!cache->ReadBody(entry, deliver) && !result.stoppedEarly) {
+        result.error = "Cached copy unreadable";
+        return false;
+    }
+    
+    result.success = true;
+    result.fromCache = true;
+    result.statusCode = 200;
+    result.stoppedEarly = result.stoppedEarly || !entry.complete;
+    result.validators.etag = entry.etag;
+    result.validators.lastModified = entry.lastModified;
+    result.validators.bodyBytes = entry.bodyBytes;
+    
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.cacheHits++;
+    return true;
+}
+
+// Whether the response may be cached, and until when it is fresh
+bool NetFetcher::GetCacheExpiry(HttpConnection* conn, time_t now, time_t& expiresAt) {
+    return HttpCache::ComputeExpiry(conn->GetResponseHeader("Cache-Control"),
+                                    conn->GetResponseHeader("Expires"),
+                                    conn->GetResponseHeader("Last-Modified"),
+                                    conn->GetResponseHeader("Vary"), now, expiresAt);
+}
+
+// ETag / Last-Modified of the response (kept from the stored copy when absent)
+void NetFetcher::ReadValidators(HttpConnection* conn, FetchResult& result) {
+    std::string etag = conn->GetResponseHeader("ETag");
+    if (!etag.empty()) result.validators.etag = etag;
+    
+    std::string lastModified = conn->GetResponseHeader("Last-Modified");
+    if (!lastModified.empty()) result.validators.lastModified = lastModified;
+}
+
+void NetFetcher::CountTransfer(const FetchResult& result, size_t bytesSaved) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.requests++;
+    stats.bytesRead += result.bytesRead;
+    stats.bytesDecoded += result.bytesDecoded;
+    if (result.notModified) {
+        stats.notModified++;
+        stats.bytesSaved += bytesSaved;
+    }
+}
+
+void NetFetcher::SetCache(HttpCache* httpCache) {
+    cache = httpCache;
+}
+
+NetStats NetFetcher::GetStats() {
+    NetStats current;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        current = stats;
+    }
+    
+    if (pool) {
+        PoolStats poolStats = pool->GetStats();
+        current.connectionsOpened = poolStats.opened;
+        current.connectionsReused = poolStats.reused;
+    }
+    return current;
+}
+
+void NetFetcher::CloseIdleConnections() {
+    if (pool) pool->CloseIdle(true);
+}
+
+void NetFetcher::SetValidatorStore(const ValidatorLookup& lookup, const ValidatorUpdate& update) {
+    validatorLookup = lookup;
+    validatorUpdate = update;
+}
+
+bool NetFetcher::ReadResponse(HttpConnection* conn, const ChunkCallback& onChunk,
+                              HttpCacheWriter* store, FetchBudget* budget, FetchResult& result) {
     const int BUFFER_SIZE = 16384;  // 16KB chunks
     char buffer[BUFFER_SIZE];
-    outHtml.clear();
     
-    int totalRead = 0;
-    int maxSize = 5 * 1024 * 1024;  // 5MB max
+    ContentDecoder decoder;
+    if (!decoder.Begin(ContentDecoder::ParseEncoding(conn->GetResponseHeader("Content-Encoding")))) {
+        return false;  // An encoding we never asked for
+    }
+    
+    // A gzip body is cached as received; anything else as decoded
+    bool storeRaw = store && decoder.GetEncoding() == ContentDecoder::ENCODING_GZIP;
     
-    while (totalRead < maxSize) {
-        int read = sceHttpReadData(reqId, buffer, BUFFER_SIZE);
+    // The size cap applies to what the caller gets: one 16KB gzip chunk
+    // can inflate to megabytes, so it is enforced here, not per read
+    auto deliver = [&result, &onChunk, store, storeRaw](const char* data, size_t length) {
+        bool capped = length > MAX_BODY_BYTES - result.bytesDecoded;
+        if (capped) length = MAX_BODY_BYTES - result.bytesDecoded;
+        
+        result.bytesDecoded += length;
+        if (store && !storeRaw) store->Write(data, length);
+        if (length > 0 && !onChunk(data, length)) {
+            result.stoppedEarly = true;
+            return false;
+        }
+        if (capped) {
+            result.truncated = true;
+            return false;
+        }
+        return true;
+    };
+    
+    bool ended = false;
+    while (result.bytesRead < MAX_BODY_BYTES && result.bytesDecoded < MAX_BODY_BYTES) {
+        // Out of time or bytes, or cancelled: the page is dropped with
+        // whatever came of it
+        if (budget && budget->IsExhausted()) {
+            result.overBudget = true;
+            return false;
+        }
+        
+        int read = conn->ReadBody(buffer, BUFFER_SIZE);
         
         if (read < 0) {
-            lastError = read;
+            result.overBudget = budget && budget->IsExhausted();  // Aborted by Cancel
+            if (!result.overBudget) lastError = conn->GetLastError();
             return false;
         }
         
         if (read == 0) {
-            break;  // End of data
+            ended = true;  // End of data
+            break;
+        }
+        
+        result.bytesRead += read;
+        
+        if (budget && !budget->AddBytes(read)) {
+            result.overBudget = true;
+            return false;
         }
+        if (storeRaw) store->Write(buffer, read);
         
-        outHtml.append(buffer, read);
-        totalRead += read;
+        if (!decoder.Decode(buffer, read, deliver)) {
+            // Consumer has what it needs; the connection is dropped, not reused
+            if (decoder.Stopped()) break;
+            return false;  // Corrupt compressed data
+        }
     }
     
-    return true;
-}
-
-void NetFetcher::CleanupHTTP(int tmplId, int connId, int reqId) {
-    if (reqId >= 0) sceHttpDeleteRequest(reqId);
-    if (connId >= 0) sceHttpDeleteConnection(connId);
-    if (tmplId >= 0) sceHttpDeleteTemplate(tmplId);
+    // Left at the size cap rather than at the end of the body
+    if (!ended && !result.stoppedEarly) result.truncated = true;
+    
+    // A compressed stream cut off before its end is a truncated body
+    return !ended || decoder.IsComplete();
 }
 
 FetchResult NetFetcher::FetchWithHeaders(const std::string& url,
                                          const std::vector<HttpHeader>& headers,
                                          int timeoutSec) {
-    // Similar to FetchURL but with custom headers
-    // Implementation would add headers before sending request
-    // For now, just use FetchURL
-    return FetchURL(url, timeoutSec);
+    std::string html;
+    FetchResult result = Fetch(url, timeoutSec, headers, false,
+        [&html](const char* data, size_t length) {
+            html.append(data, length);
+            return true;
+        }, nullptr);
+    result.html.swap(html);
+    return result;
 }
 
 std::vector<FetchResult> NetFetcher::FetchMultiple(const std::vector<std::string>& urls,
-                                                    int maxConcurrent) {
-    std::vector<FetchResult> results;
+                                                    int maxConcurrent,
+                                                    const FetchCallback& onComplete) {
+    std::vector<FetchResult> results(urls.size());
     
-    // For now, fetch sequentially (concurrent fetching is complex on Vita)
-    for (const auto& url : urls) {
-        results.push_back(FetchURL(url));
-        
-        // Small delay between requests (rate limiting)
-        sceKernelDelayThread(1000000);  // 1 second
-    }
+    // Each worker writes only its own slot
+    RunFetches(urls, maxConcurrent, [this, &urls, &results, &onComplete](size_t index) {
+        results[index] = FetchURL(urls[index], timeoutSeconds);
+        if (onComplete) onComplete(index, results[index]);
+    });
     
     return results;
 }
 
+void NetFetcher::RunFetches(const std::vector<std::string>& urls, int maxConcurrent,
+                            const FetchWork& work, FetchBudget* budget) {
+    if (urls.empty()) return;
+    
+    int workers = std::max(1, std::min(maxConcurrent, (int)urls.size()));
+    FetchScheduler scheduler(&hostThrottle, workers);
+    for (size_t i = 0; i < urls.size(); i++) {
+        HttpUrl parsed;
+        std::string host = ParseHttpUrl(urls[i], parsed) ? parsed.host : std::string();
+        scheduler.Submit(host, [&work, i]() { work(i); });
+    }
+    if (!budget) {
+        scheduler.Wait();
+        return;
+    }
+    
+    // Once the budget is spent queued fetches are dropped (they would only
+    // be refused, after waiting on a throttled host), and running ones are
+    // aborted: a read stalled on a silent server ends at the deadline, not
+    // at its socket timeout
+    while (!scheduler.WaitFor(BUDGET_POLL_MS)) {
+        if (budget->IsExhausted()) {
+            budget->Cancel();
+            scheduler.Cancel();
+            scheduler.Wait();
+            break;
+        }
+    }
+}
+
 void NetFetcher::SetUserAgent(const std::string& ua) {
     userAgent = ua;
 }
@@ -246,6 +788,10 @@ void NetFetcher::SetTimeout(int seconds) {
     timeoutSeconds = seconds;
 }
 
+void NetFetcher::SetConnectTimeout(int seconds) {
+    connectTimeoutSeconds = seconds;
+}
+
 void NetFetcher::SetMaxRetries(int retries) {
     maxRetries = retries;
 }
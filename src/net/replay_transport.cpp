@@ -0,0 +1,418 @@
+#include "replay_transport.h"
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <strings.h>
+
+static const char* ARCHIVE_MAGIC = "HTTPARCHIVE 1";
+
+// A paced body comes in pieces of what arrives in this long, as off a
+// slow socket, so readers can stop between them
+static const int PACED_READ_MS = 100;
+
+// Simulated waits look for an abort this often
+static const int ABORT_POLL_MS = 10;
+
+typedef std::chrono::steady_clock Clock;
+
+static int ElapsedMs(Clock::time_point since) {
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+static void SleepMs(int ms) {
+    if (ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static std::string FindHeader(const std::vector<HttpHeader>& headers, const char* name) {
+    for (const auto& header : headers) {
+        if (strcasecmp(header.name.c_str(), name) == 0) return header.value;
+    }
+    return "";
+}
+
+// One line without its newline; false at end of file
+static bool ReadLine(FILE* file, std::string& line) {
+    line.clear();
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\n') return true;
+        line += (char)c;
+    }
+    return !line.empty();
+}
+
+// --- HttpArchive ---
+
+bool HttpArchive::Load(const std::string& path) {
+    responses.clear();
+    
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    
+    std::string line;
+    if (!ReadLine(file, line) || line != ARCHIVE_MAGIC) {
+        fclose(file);
+        return false;
+    }
+    
+    RecordedResponse response;
+    bool ok = true;
+    while (ok && ReadLine(file, line)) {
+        if (line.compare(0, 8, "REQUEST ") == 0) {
+            response = RecordedResponse();
+            size_t space = line.find(' ', 8);
+            if (space == std::string::npos) {
+                ok = false;
+                break;
+            }
+            response.method = line.substr(8, space - 8);
+            response.url = line.substr(space + 1);
+        } else if (line.compare(0, 7, "STATUS ") == 0) {
+            int complete = 0;
+            if (sscanf(line.c_str() + 7, "%d %d %d %d %d", &response.statusCode, &complete,
+                       &response.connectMs, &response.firstByteMs, &response.totalMs) != 5) {
+                ok = false;
+                break;
+            }
+            response.complete = complete != 0;
+        } else if (line.compare(0, 7, "HEADER ") == 0) {
+            size_t colon = line.find(':', 7);
+            if (colon == std::string::npos) continue;
+            HttpHeader header;
+            header.name = line.substr(7, colon - 7);
+            size_t valueStart = line.find_first_not_of(' ', colon + 1);
+            if (valueStart != std::string::npos) header.value = line.substr(valueStart);
+            response.headers.push_back(header);
+        } else if (line.compare(0, 5, "BODY ") == 0) {
+            size_t length = strtoul(line.c_str() + 5, nullptr, 10);
+            response.body.resize(length);
+            if (length > 0 && fread(&response.body[0], 1, length, file) != length) {
+                ok = false;
+                break;
+            }
+            fgetc(file);  // Newline after the body
+            
+            // The record is done; a partial body doesn't replace a whole one
+            std::string key = response.method + " " + response.url;
+            auto it = responses.find(key);
+            if (it == responses.end() || response.complete || !it->second.complete) {
+                responses[key] = response;
+            }
+        } else if (!line.empty()) {
+            ok = false;
+        }
+    }
+    
+    fclose(file);
+    return ok;
+}
+
+const RecordedResponse* HttpArchive::Find(const std::string& method, const std::string& url) const {
+    auto it = responses.find(method + " " + url);
+    return it != responses.end() ? &it->second : nullptr;
+}
+
+bool HttpArchive::Write(FILE* file, const RecordedResponse& response) {
+    if (ftell(file) == 0) fprintf(file, "%s\n", ARCHIVE_MAGIC);
+    
+    fprintf(file, "REQUEST %s %s\n", response.method.c_str(), response.url.c_str());
+    fprintf(file, "STATUS %d %d %d %d %d\n", response.statusCode, response.complete ? 1 : 0,
+            response.connectMs, response.firstByteMs, response.totalMs);
+    for (const auto& header : response.headers) {
+        fprintf(file, "HEADER %s: %s\n", header.name.c_str(), header.value.c_str());
+    }
+    fprintf(file, "BODY %lu\n", (unsigned long)response.body.size());
+    fwrite(response.body.data(), 1, response.body.size(), file);
+    fputc('\n', file);
+    return fflush(file) == 0;
+}
+
+// --- Recording ---
+
+namespace {
+
+class RecordingConnection : public HttpConnection {
+public:
+    RecordingConnection(HttpConnection* inner, RecordingHttpTransport* owner, int connectMs)
+        : inner(inner), owner(owner), connectMs(connectMs), pending(false) {}
+    ~RecordingConnection() {
+        EndRequest();
+        delete inner;
+    }
+    
+    bool SendRequest(const HttpRequest& request, int& statusCode);
+    std::string GetResponseHeader(const char* name) { return inner->GetResponseHeader(name); }
+    void GetResponseHeaders(std::vector<HttpHeader>& headers) { inner->GetResponseHeaders(headers); }
+    int64_t GetContentLength() { return inner->GetContentLength(); }
+    int ReadBody(char* buffer, size_t size);
+    void EndRequest();
+    bool IsReusable() const { return inner->IsReusable(); }
+    int GetLastError() const { return inner->GetLastError(); }
+    void Abort() { inner->Abort(); }
+    
+private:
+    HttpConnection* inner;
+    RecordingHttpTransport* owner;
+    int connectMs;  // Charged to the first request only
+    bool pending;   // A response is being captured
+    RecordedResponse response;
+    Clock::time_point sentAt;
+};
+
+bool RecordingConnection::SendRequest(const HttpRequest& request, int& statusCode) {
+    EndRequest();
+    
+    sentAt = Clock::now();
+    if (!inner->SendRequest(request, statusCode)) return false;
+    
+    response = RecordedResponse();
+    response.method = request.method;
+    response.url = request.url;
+    response.statusCode = statusCode;
+    response.connectMs = connectMs;
+    response.firstByteMs = ElapsedMs(sentAt);
+    inner->GetResponseHeaders(response.headers);
+    response.complete = (request.method == "HEAD" || statusCode == 204);
+    connectMs = 0;
+    
+    // The replay transport makes up its own 304s
+    pending = (statusCode != 304);
+    return true;
+}
+
+int RecordingConnection::ReadBody(char* buffer, size_t size) {
+    int read = inner->ReadBody(buffer, size);
+    if (pending) {
+        if (read > 0) {
+            response.body.append(buffer, read);
+        } else if (read == 0) {
+            response.complete = true;
+        } else {
+            pending = false;  // A broken body is not worth replaying
+        }
+    }
+    return read;
+}
+
+void RecordingConnection::EndRequest() {
+    if (pending) {
+        pending = false;
+        response.totalMs = ElapsedMs(sentAt);
+        owner->Save(response);
+    }
+    inner->EndRequest();
+}
+    
+} // namespace
+
+RecordingHttpTransport::RecordingHttpTransport(HttpTransport* inner, const std::string& archivePath)
+    : inner(inner), recorded(0) {
+    file = fopen(archivePath.c_str(), "ab");
+    if (file) fseek(file, 0, SEEK_END);  // So Write sees whether the archive is new
+}
+
+RecordingHttpTransport::~RecordingHttpTransport() {
+    if (file) fclose(file);
+}
+
+HttpConnection* RecordingHttpTransport::Connect(const HttpUrl& url, int timeoutSec, int& error) {
+    Clock::time_point start = Clock::now();
+    HttpConnection* conn = inner->Connect(url, timeoutSec, error);
+    if (!conn) return nullptr;
+    return new RecordingConnection(conn, this, ElapsedMs(start));
+}
+
+void RecordingHttpTransport::Save(const RecordedResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file && HttpArchive::Write(file, response)) recorded++;
+}
+
+size_t RecordingHttpTransport::GetRecordedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recorded;
+}
+
+// --- Replay ---
+
+namespace {
+
+class ReplayConnection : public HttpConnection {
+public:
+    explicit ReplayConnection(ReplayHttpTransport* owner)
+        : owner(owner), response(nullptr), fresh(true), bodyPos(0), bodyDone(true),
+          lastError(0), aborted(false) {}
+    
+    bool SendRequest(const HttpRequest& request, int& statusCode);
+    std::string GetResponseHeader(const char* name);
+    void GetResponseHeaders(std::vector<HttpHeader>& headers);
+    int64_t GetContentLength();
+    int ReadBody(char* buffer, size_t size);
+    void EndRequest() {}
+    bool IsReusable() const { return bodyDone && !aborted; }
+    int GetLastError() const { return lastError; }
+    void Abort() { aborted = true; }
+    
+private:
+    ReplayHttpTransport* owner;
+    ReplayProfile profile;
+    const RecordedResponse* response;  // nullptr: answering 404
+    bool fresh;         // No request on this connection yet
+    size_t bodyPos;
+    bool bodyDone;
+    int lastError;
+    std::atomic<bool> aborted;
+    
+    bool Wait(int ms);
+};
+
+// Sleeps like the network would; false (and the abort error) once aborted
+bool ReplayConnection::Wait(int ms) {
+    Clock::time_point until = Clock::now() + std::chrono::milliseconds(std::max(0, ms));
+    while (!aborted && Clock::now() < until) {
+        int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            until - Clock::now()).count();
+        SleepMs(std::min(ABORT_POLL_MS, std::max(1, left)));
+    }
+    if (aborted) {
+        lastError = ReplayHttpTransport::REPLAY_ERROR_ABORTED;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayConnection::SendRequest(const HttpRequest& request, int& statusCode) {
+    profile = owner->GetProfile();
+    
+    bool notModified = false;
+    response = owner->Find(request, notModified);
+    
+    // Handshakes on a new connection, then the wait for the first byte
+    int delayMs = 0;
+    if (profile.recordedTimings && response) {
+        delayMs = (fresh ? response->connectMs : 0) + response->firstByteMs;
+    } else {
+        delayMs = (fresh ? profile.latencyMs : 0) + profile.latencyMs;
+    }
+    
+    bodyPos = 0;
+    lastError = 0;
+    if (!Wait(delayMs)) return false;
+    fresh = false;
+    
+    if (!response) {
+        statusCode = 404;
+        bodyDone = true;
+    } else if (notModified || request.method == "HEAD") {
+        statusCode = notModified ? 304 : response->statusCode;
+        bodyDone = true;
+    } else {
+        statusCode = response->statusCode;
+        bodyDone = false;
+    }
+    return true;
+}
+
+std::string ReplayConnection::GetResponseHeader(const char* name) {
+    return response ? FindHeader(response->headers, name) : "";
+}
+
+void ReplayConnection::GetResponseHeaders(std::vector<HttpHeader>& headers) {
+    if (response) {
+        headers = response->headers;
+    } else {
+        headers.clear();
+    }
+}
+
+int64_t ReplayConnection::GetContentLength() {
+    if (!response || bodyDone) return bodyDone ? 0 : -1;
+    return response->complete ? (int64_t)response->body.size() : -1;
+}
+
+int ReplayConnection::ReadBody(char* buffer, size_t size) {
+    if (aborted) {
+        lastError = ReplayHttpTransport::REPLAY_ERROR_ABORTED;
+        return lastError;
+    }
+    if (bodyDone || !response) return 0;
+    
+    size_t left = response->body.size() - bodyPos;
+    if (left == 0) {
+        if (!response->complete) {
+            lastError = ReplayHttpTransport::REPLAY_ERROR_TRUNCATED;
+            return lastError;
+        }
+        bodyDone = true;
+        return 0;
+    }
+    
+    size_t length = std::min(size, left);
+    if (profile.bytesPerSecond > 0) {
+        length = std::min(length, std::max((size_t)1,
+                                           (size_t)profile.bytesPerSecond * PACED_READ_MS / 1000));
+    }
+    memcpy(buffer, response->body.data() + bodyPos, length);
+    bodyPos += length;
+    
+    // Pace the body: the set bandwidth, or the recorded transfer time
+    int delayMs = 0;
+    if (profile.bytesPerSecond > 0) {
+        delayMs = (int)((uint64_t)length * 1000 / profile.bytesPerSecond);
+    } else if (profile.recordedTimings && !response->body.empty()) {
+        int transferMs = std::max(0, response->totalMs - response->firstByteMs);
+        delayMs = (int)((uint64_t)transferMs * length / response->body.size());
+    }
+    if (!Wait(delayMs)) return lastError;
+    return (int)length;
+}
+    
+} // namespace
+
+ReplayHttpTransport::ReplayHttpTransport() {
+}
+
+bool ReplayHttpTransport::Load(const std::string& archivePath) {
+    return archive.Load(archivePath);
+}
+
+void ReplayHttpTransport::SetProfile(const ReplayProfile& newProfile) {
+    profile = newProfile;
+}
+
+HttpConnection* ReplayHttpTransport::Connect(const HttpUrl& url, int timeoutSec, int& error) {
+    error = 0;
+    return new ReplayConnection(this);
+}
+
+const RecordedResponse* ReplayHttpTransport::Find(const HttpRequest& request, bool& notModified) {
+    const RecordedResponse* response = archive.Find(request.method, request.url);
+    notModified = false;
+    
+    if (response && response->statusCode == 200) {
+        std::string etag = FindHeader(response->headers, "ETag");
+        std::string lastModified = FindHeader(response->headers, "Last-Modified");
+        std::string ifNoneMatch = FindHeader(request.headers, "If-None-Match");
+        std::string ifModifiedSince = FindHeader(request.headers, "If-Modified-Since");
+        notModified = (!ifNoneMatch.empty() && ifNoneMatch == etag) ||
+                      (ifNoneMatch.empty() && !ifModifiedSince.empty() &&
+                       ifModifiedSince == lastModified);
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!response) {
+        stats.missing++;
+    } else if (notModified) {
+        stats.notModified++;
+    } else {
+        stats.served++;
+    }
+    return response;
+}
+
+ReplayStats ReplayHttpTransport::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
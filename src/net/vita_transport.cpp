@@ -0,0 +1,192 @@
+#include "vita_transport.h"
+#include <psp2/net/http.h>
+#include <atomic>
+
+namespace {
+
+class VitaHttpConnection : public HttpConnection {
+public:
+    explicit VitaHttpConnection(int connId)
+        : connId(connId), reqId(-1), lastError(0), bodyDone(true), failed(false),
+          aborted(false) {}
+    ~VitaHttpConnection();
+    
+    bool SendRequest(const HttpRequest& request, int& statusCode);
+    std::string GetResponseHeader(const char* name);
+    void GetResponseHeaders(std::vector<HttpHeader>& headers);
+    int64_t GetContentLength();
+    int ReadBody(char* buffer, size_t size);
+    void EndRequest();
+    bool IsReusable() const { return bodyDone && !failed && !aborted; }
+    int GetLastError() const { return lastError; }
+    void Abort();
+    
+private:
+    int connId;
+    std::atomic<int> reqId;  // Read by Abort on another thread
+    int lastError;
+    bool bodyDone;
+    bool failed;
+    std::atomic<bool> aborted;
+};
+
+VitaHttpConnection::~VitaHttpConnection() {
+    if (reqId >= 0) sceHttpDeleteRequest(reqId);
+    sceHttpDeleteConnection(connId);
+}
+
+void VitaHttpConnection::Abort() {
+    aborted = true;
+    int id = reqId;
+    if (id >= 0) sceHttpAbortRequest(id);
+}
+
+bool VitaHttpConnection::SendRequest(const HttpRequest& request, int& statusCode) {
+    EndRequest();
+    bodyDone = false;
+    failed = true;  // Until the status is in
+    
+    bool head = (request.method == "HEAD");
+    reqId = sceHttpCreateRequestWithURL(connId, head ? SCE_HTTP_METHOD_HEAD : SCE_HTTP_METHOD_GET,
+                                        request.url.c_str(), 0);
+    if (reqId < 0) {
+        lastError = reqId;
+        return false;
+    }
+    
+    for (const auto& header : request.headers) {
+        sceHttpAddRequestHeader(reqId, header.name.c_str(), header.value.c_str(),
+                                SCE_HTTP_HEADER_OVERWRITE);
+    }
+    
+    // Aborted before the request existed to abort
+    if (aborted) {
+        lastError = SCE_HTTP_ERROR_ABORTED;
+        return false;
+    }
+    
+    sceHttpSetRequestContentLength(reqId, 0);
+    sceHttpSetSendTimeOut(reqId, request.timeoutSec * 1000000);  // microseconds
+    sceHttpSetRecvTimeOut(reqId, request.timeoutSec * 1000000);
+    
+    int ret = sceHttpSendRequest(reqId, NULL, 0);
+    if (ret < 0) {
+        lastError = ret;
+        return false;
+    }
+    
+    ret = sceHttpGetStatusCode(reqId, &statusCode);
+    if (ret < 0) {
+        lastError = ret;
+        return false;
+    }
+    
+    failed = false;
+    bodyDone = head || statusCode == 204 || statusCode == 304;
+    return true;
+}
+
+std::string VitaHttpConnection::GetResponseHeader(const char* name) {
+    char* headers = nullptr;
+    unsigned int headersSize = 0;
+    if (reqId < 0 || sceHttpGetAllResponseHeaders(reqId, &headers, &headersSize) < 0 || !headers) {
+        return "";
+    }
+    
+    const char* value = nullptr;
+    unsigned int valueLength = 0;
+    if (sceHttpParseResponseHeader(headers, headersSize, name, &value, &valueLength) < 0) {
+        return "";
+    }
+    return std::string(value, valueLength);
+}
+
+void VitaHttpConnection::GetResponseHeaders(std::vector<HttpHeader>& headers) {
+    headers.clear();
+    char* raw = nullptr;
+    unsigned int rawSize = 0;
+    if (reqId < 0 || sceHttpGetAllResponseHeaders(reqId, &raw, &rawSize) < 0 || !raw) return;
+    
+    // "Name: value" lines after the status line
+    std::string text(raw, rawSize);
+    size_t pos = text.find('\n');
+    while (pos != std::string::npos && pos + 1 < text.size()) {
+        size_t start = pos + 1;
+        pos = text.find('\n', start);
+        std::string line = text.substr(start, (pos == std::string::npos ? text.size() : pos) - start);
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        
+        HttpHeader header;
+        header.name = line.substr(0, colon);
+        size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        if (valueStart != std::string::npos) header.value = line.substr(valueStart);
+        headers.push_back(header);
+    }
+}
+
+int64_t VitaHttpConnection::GetContentLength() {
+    SceUInt64 length = 0;
+    if (reqId < 0 || sceHttpGetResponseContentLength(reqId, &length) < 0) return -1;
+    return (int64_t)length;
+}
+
+int VitaHttpConnection::ReadBody(char* buffer, size_t size) {
+    if (failed) return -1;
+    if (bodyDone) return 0;
+    
+    int read = sceHttpReadData(reqId, buffer, size);
+    if (read < 0) {
+        lastError = read;
+        failed = true;
+    } else if (read == 0) {
+        bodyDone = true;
+    }
+    return read;
+}
+
+void VitaHttpConnection::EndRequest() {
+    if (reqId >= 0) {
+        sceHttpDeleteRequest(reqId);
+        reqId = -1;
+    }
+}
+    
+} // namespace
+
+VitaHttpTransport::VitaHttpTransport(const std::string& userAgent)
+    : userAgent(userAgent), tmplId(-1) {
+}
+
+VitaHttpTransport::~VitaHttpTransport() {
+    if (tmplId >= 0) sceHttpDeleteTemplate(tmplId);
+}
+
+HttpConnection* VitaHttpTransport::Connect(const HttpUrl& url, int timeoutSec, int& error) {
+    {
+        std::lock_guard<std::mutex> lock(tmplMutex);
+        if (tmplId < 0) {
+            int ret = sceHttpCreateTemplate(userAgent.c_str(), SCE_HTTP_VERSION_1_1, SCE_TRUE);
+            if (ret < 0) {
+                error = ret;
+                return nullptr;
+            }
+            tmplId = ret;
+        }
+    }
+    
+    // Keep-alive on: later requests on this connection skip the handshakes
+    std::string origin = url.scheme + "://" + url.host + ":" + std::to_string(url.port) + "/";
+    int connId = sceHttpCreateConnectionWithURL(tmplId, origin.c_str(), SCE_TRUE);
+    if (connId < 0) {
+        error = connId;
+        return nullptr;
+    }
+    
+    sceHttpSetResolveTimeOut(connId, timeoutSec * 1000000);
+    sceHttpSetConnectTimeOut(connId, timeoutSec * 1000000);
+    error = 0;
+    return new VitaHttpConnection(connId);
+}
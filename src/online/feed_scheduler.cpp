@@ -0,0 +1,153 @@
+#include "feed_scheduler.h"
+#include <algorithm>
+
+// Bounds on any feed's poll interval
+static const int MIN_POLL_SECONDS = 10 * 60;
+static const int MAX_POLL_SECONDS = 24 * 3600;
+
+// Feeds due within this long of the first due feed are fetched with it
+static const int BATCH_WINDOW_SECONDS = 5 * 60;
+
+// Weight of the newest gap in the learned publishing interval
+static const double GAP_WEIGHT = 0.3;
+
+// Item dates further ahead than this are bad clocks, not news
+static const int FUTURE_SLACK_SECONDS = 3600;
+
+// Priority whose feeds poll at exactly the learned interval
+static const int NEUTRAL_PRIORITY = 5;
+
+FeedScheduler::FeedScheduler()
+    : defaultInterval(3600), bytesPerHour(0), fetchesPerHour(0),
+      windowStart(0), bytesUsed(0), fetchesUsed(0) {
+}
+
+void FeedScheduler::SetDefaultInterval(int seconds) {
+    defaultInterval = std::max(MIN_POLL_SECONDS, std::min(seconds, MAX_POLL_SECONDS));
+}
+
+void FeedScheduler::SetBudget(size_t bytes, int fetches) {
+    bytesPerHour = bytes;
+    fetchesPerHour = fetches;
+}
+
+std::vector<size_t> FeedScheduler::GetDueFeeds(const std::vector<FeedConfig>& feeds,
+                                               const std::vector<FeedState>& states,
+                                               time_t now) const {
+    std::vector<size_t> due;
+    
+    // Stay off the network until something is actually due...
+    bool anyDue = false;
+    for (size_t i = 0; i < feeds.size() && i < states.size(); i++) {
+        if (feeds[i].enabled && states[i].next_poll <= now) {
+            anyDue = true;
+            break;
+        }
+    }
+    if (!anyDue) return due;
+    
+    // ...then take everything due shortly along with it
+    for (size_t i = 0; i < feeds.size() && i < states.size(); i++) {
+        if (feeds[i].enabled && states[i].next_poll <= now + BATCH_WINDOW_SECONDS) {
+            due.push_back(i);
+        }
+    }
+    
+    // Priority first, then whichever has waited longest
+    std::sort(due.begin(), due.end(), [&](size_t a, size_t b) {
+        if (feeds[a].priority != feeds[b].priority) {
+            return feeds[a].priority > feeds[b].priority;
+        }
+        return states[a].next_poll < states[b].next_poll;
+    });
+    return due;
+}
+
+int FeedScheduler::GetSecondsUntilDue(const std::vector<FeedConfig>& feeds,
+                                      const std::vector<FeedState>& states,
+                                      time_t now) const {
+    int wait = MAX_POLL_SECONDS;
+    for (size_t i = 0; i < feeds.size() && i < states.size(); i++) {
+        if (!feeds[i].enabled) continue;
+        if (states[i].next_poll <= now) return 0;
+        wait = (int)std::min<time_t>(wait, states[i].next_poll - now);
+    }
+    return wait;
+}
+
+bool FeedScheduler::HasBudget(time_t now) {
+    if (now < windowStart || now - windowStart >= 3600) {
+        windowStart = now;
+        bytesUsed = 0;
+        fetchesUsed = 0;
+    }
+    
+    if (fetchesPerHour > 0 && fetchesUsed >= fetchesPerHour) return false;
+    if (bytesPerHour > 0 && bytesUsed >= bytesPerHour) return false;
+    return true;
+}
+
+void FeedScheduler::ChargeFetch(size_t bytes, time_t now) {
+    HasBudget(now);  // Rolls the window over if needed
+    bytesUsed += bytes;
+    fetchesUsed++;
+}
+
+void FeedScheduler::UpdateSchedule(FeedState& state, const FeedConfig& feed,
+                                   const std::vector<time_t>& itemDates, int newItems,
+                                   bool success, time_t now) const {
+    int interval = state.poll_interval > 0 ? state.poll_interval : defaultInterval;
+    
+    bool gotNew = false;
+    if (success) {
+        // Dates we haven't seen before, oldest first
+        std::vector<time_t> fresh;
+        for (time_t date : itemDates) {
+            if (date > state.newest_item && date <= now + FUTURE_SLACK_SECONDS) {
+                fresh.push_back(date);
+            }
+        }
+        std::sort(fresh.begin(), fresh.end());
+        
+        time_t previous = state.newest_item;
+        for (time_t date : fresh) {
+            if (previous > 0 && date > previous) {
+                double gap = (double)(date - previous);
+                state.item_gap = state.item_gap > 0 ?
+                    (1.0 - GAP_WEIGHT) * state.item_gap + GAP_WEIGHT * gap : gap;
+            }
+            previous = date;
+        }
+        
+        if (!fresh.empty()) {
+            state.newest_item = fresh.back();
+            gotNew = true;
+        } else if (newItems > 0) {
+            // Undated feed: spread the new items over the time since the last poll
+            gotNew = true;
+            if (state.last_fetched > 0 && now > state.last_fetched) {
+                double gap = (double)(now - state.last_fetched) / newItems;
+                state.item_gap = state.item_gap > 0 ?
+                    (1.0 - GAP_WEIGHT) * state.item_gap + GAP_WEIGHT * gap : gap;
+            }
+        }
+    }
+    
+    if (gotNew) {
+        // About two polls per expected item
+        interval = state.item_gap > 0 ? (int)(state.item_gap / 2) : interval / 2;
+    } else {
+        // Nothing new, unchanged (304) or failed: back off
+        interval = interval + interval / 2;
+    }
+    
+    state.poll_interval = std::max(MIN_POLL_SECONDS, std::min(interval, MAX_POLL_SECONDS));
+    state.next_poll = now + EffectiveInterval(state.poll_interval, feed.priority);
+}
+
+// Priority 10 polls twice as often as the neutral 5, priority 1 five times less
+int FeedScheduler::EffectiveInterval(int baseInterval, int priority) const {
+    int clamped = std::max(1, std::min(priority, 10));
+    long long scaled = (long long)baseInterval * NEUTRAL_PRIORITY / clamped;
+    return (int)std::max<long long>(MIN_POLL_SECONDS, std::min<long long>(scaled, MAX_POLL_SECONDS));
+}
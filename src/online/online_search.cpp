@@ -1,19 +1,41 @@
 #include "online_search.h"
 #include <algorithm>
+#include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <set>
+
+// The refresher sleeps until the next feed is due, within these bounds
+// (the upper one picks up feeds added while it sleeps)
+static const int REFRESH_MIN_SLEEP_SECONDS = 60;
+static const int REFRESH_MAX_SLEEP_SECONDS = 15 * 60;
+
+// Article fetches in flight at once
+static const int FETCH_CONCURRENCY = 3;
+
+// Stored ETag / Last-Modified values unused for this long are dropped
+static const int VALIDATOR_MAX_AGE_DAYS = 30;
 
 OnlineSearch::OnlineSearch() : netFetcher(nullptr), rssParser(nullptr),
-                               extractor(nullptr), database(nullptr) {
+                               extractor(nullptr), database(nullptr), refreshCancel(false),
+                               refreshBudget(nullptr) {
     // Default settings
     settings.enabled = true;
     settings.maxResults = 10;
     settings.timeoutSeconds = 30;
     settings.saveAutomatically = true;
     settings.cacheSizeLimitMB = 100;
+    settings.feedRefreshMinutes = 60;
+    settings.feedBudgetKBPerHour = 2048;
+    settings.feedFetchesPerHour = 60;
+    settings.feedItemMaxAgeDays = 14;
+    settings.searchBudgetSeconds = 20;
+    settings.searchBudgetKB = 1024;
+    settings.searchBudgetRequests = 12;
 }
 
 OnlineSearch::~OnlineSearch() {
+    StopFeedRefresh();
 }
 
 void OnlineSearch::Initialize(NetFetcher* net, RSSParser* rss,
@@ -22,69 +44,99 @@ void OnlineSearch::Initialize(NetFetcher* net, RSSParser* rss,
     rssParser = rss;
     extractor = ext;
     database = db;
+    
+    // Conditional fetches keep their ETag / Last-Modified in the vault; the
+    // fetch workers call these concurrently and Database serialises them
+    if (netFetcher && database) {
+        Database* store = database;
+        netFetcher->SetValidatorStore(
+            [store](const std::string& url, HttpValidators& validators) {
+                int64_t bodyBytes = 0;
+                if (!store->GetHttpValidators(url, validators.etag, validators.lastModified, bodyBytes)) {
+                    return false;
+                }
+                validators.bodyBytes = (size_t)bodyBytes;
+                return !validators.Empty();
+            },
+            [store](const std::string& url, const HttpValidators& validators) {
+                store->SetHttpValidators(url, validators.etag, validators.lastModified,
+                                         (int64_t)validators.bodyBytes);
+            });
+    }
 }
 
 bool OnlineSearch::SearchAndSave(const std::string& query, std::vector<VaultItem>& outItems) {
-    if (!settings.enabled || !IsOnline()) {
+    // Without a limit, ten pages at a 30 s timeout each could hold Ask for minutes
+    FetchBudget* budget = CreateSearchBudget();
+    bool found = SearchAndSave(query, outItems, *budget);
+    delete budget;
+    return found;
+}
+
+FetchBudget* OnlineSearch::CreateSearchBudget() const {
+    return new FetchBudget(std::max(0, settings.searchBudgetSeconds) * 1000,
+                           (uint64_t)std::max(0, settings.searchBudgetKB) * 1024,
+                           settings.searchBudgetRequests);
+}
+
+bool OnlineSearch::SearchAndSave(const std::string& query, std::vector<VaultItem>& outItems,
+                                 FetchBudget& budget) {
+    // Runs offline too: pages in the HTTP cache are extracted without the network
+    if (!settings.enabled) {
         return false;
     }
     
     // Step 1: Search RSS feeds for relevant items
-    auto results = SearchRSSFeeds(query, settings.maxResults);
-    if (results.empty()) {
-        return false;
-    }
-    
-    // Step 2: Fetch and extract content from top results
-    int fetchedCount = 0;
-    for (const auto& result : results) {
-        if (fetchedCount >= settings.maxResults) break;
-        
-        VaultItem item;
-        if (FetchAndExtract(result.url, item)) {
-            // Check if duplicate
-            if (!IsDuplicate(item)) {
-                if (SaveToVault(item)) {
-                    outItems.push_back(item);
-                    fetchedCount++;
-                }
-            }
+    auto results = SearchRSSFeeds(query, settings.maxResults, &budget);
+    if (!results.empty()) {
+        // Step 2: Fetch and extract content from top results, several hosts
+        // at once; only the best ones the budget has requests for are tried
+        std::vector<std::string> urls;
+        for (const auto& result : results) {
+            if (!IsKnownUrl(result.url)) urls.push_back(result.url);
+        }
+        int requestsLeft = budget.GetRemainingRequests();
+        if (requestsLeft >= 0 && (int)urls.size() > requestsLeft) {
+            urls.resize(requestsLeft);
         }
+        FetchAndSaveAll(urls, settings.maxResults, outItems, &budget);
         
-        // Rate limiting - small delay between fetches
-        sceKernelDelayThread(2000000);  // 2 seconds
-    }
-    
-    // Step 3: Check cache size limit
-    if (settings.cacheSizeLimitMB > 0) {
-        CheckCacheSizeLimit();
+        // Step 3: Check cache size limit
+        if (settings.cacheSizeLimitMB > 0) {
+            CheckCacheSizeLimit();
+        }
     }
     
     return !outItems.empty();
 }
 
-std::vector<OnlineResult> OnlineSearch::SearchRSSFeeds(const std::string& query, int limit) {
+std::vector<OnlineResult> OnlineSearch::SearchRSSFeeds(const std::string& query, int limit,
+                                                       FetchBudget* budget) {
     std::vector<OnlineResult> allResults;
     
-    if (!netFetcher || !rssParser) return allResults;
+    if (!database || !rssParser) return allResults;
+    if (budget && budget->IsExhausted()) return allResults;  // Nothing could be fetched
     
-    // Get configured feeds
-    auto feeds = rssParser->GetConfiguredFeeds();
-    
-    // Sort by priority
-    std::sort(feeds.begin(), feeds.end(),
-        [](const FeedConfig& a, const FeedConfig& b) {
-            return a.priority > b.priority;
-        });
+    // Items of feeds switched off since they were stored are left out
+    std::set<std::string> disabledFeeds;
+    for (const auto& feed : rssParser->GetConfiguredFeeds()) {
+        if (!feed.enabled) disabledFeeds.insert(feed.url);
+    }
     
-    // Search each enabled feed
-    for (const auto& feed : feeds) {
-        if (!feed.enabled) continue;
+    // Local store only: the refresher has already downloaded the feeds
+    auto items = database->SearchFeedItems(query, limit * 4);
+    for (const auto& item : items) {
+        if (disabledFeeds.count(item.feed_url) || !FeedItemMatches(item, query)) continue;
         
-        auto feedResults = SearchFeed(feed, query);
-        allResults.insert(allResults.end(), feedResults.begin(), feedResults.end());
+        OnlineResult result;
+        result.url = item.link;
+        result.title = item.title;
+        result.snippet = item.description;
+        result.source = item.source;
+        result.published = item.published_at;
+        result.relevance = CalculateRelevance(result, query);
         
-        if (allResults.size() >= limit * 2) break;  // Get more than needed for filtering
+        allResults.push_back(result);
     }
     
     // Filter and rank
@@ -98,40 +150,7 @@ std::vector<OnlineResult> OnlineSearch::SearchRSSFeeds(const std::string& query,
     return filtered;
 }
 
-std::vector<OnlineResult> OnlineSearch::SearchFeed(const FeedConfig& feed, const std::string& query) {
-    std::vector<OnlineResult> results;
-    
-    // Fetch feed
-    auto fetchResult = netFetcher->FetchURL(feed.url, settings.timeoutSeconds);
-    if (!fetchResult.success) {
-        return results;
-    }
-    
-    // Parse feed
-    RSSFeed parsedFeed;
-    if (!rssParser->ParseFeed(fetchResult.html, parsedFeed)) {
-        return results;
-    }
-    
-    // Filter items by query
-    for (const auto& item : parsedFeed.items) {
-        if (FeedItemMatches(item, query)) {
-            OnlineResult result;
-            result.url = item.link;
-            result.title = item.title;
-            result.snippet = item.description;
-            result.source = feed.name;
-            result.published = item.pubDate;
-            result.relevance = CalculateRelevance(result, query);
-            
-            results.push_back(result);
-        }
-    }
-    
-    return results;
-}
-
-bool OnlineSearch::FeedItemMatches(const RSSItem& item, const std::string& query) {
+bool OnlineSearch::FeedItemMatches(const FeedItem& item, const std::string& query) {
     // Convert to lowercase for matching
     std::string lowerTitle = item.title;
     std::string lowerDesc = item.description;
@@ -159,27 +178,192 @@ bool OnlineSearch::FeedItemMatches(const RSSItem& item, const std::string& query
     return keywords > 0 && (float)matches / keywords >= 0.5f;
 }
 
-bool OnlineSearch::FetchAndExtract(const std::string& url, VaultItem& outItem) {
+bool OnlineSearch::StartFeedRefresh() {
+    if (refreshThread.joinable()) return true;
+    if (!netFetcher || !rssParser || !database) return false;
+    
+    refreshCancel = false;
+    {
+        std::lock_guard<std::mutex> lock(refreshMutex);
+        refreshBudget = new FetchBudget(0, 0, 0);
+    }
+    refreshThread = std::thread([this]() { RefreshLoop(); });
+    return true;
+}
+
+void OnlineSearch::StopFeedRefresh() {
+    refreshCancel = true;
+    if (!refreshThread.joinable()) return;
+    
+    // Aborts a feed download or retry backoff in progress, so the join
+    // doesn't wait out connect/read timeouts
+    refreshBudget->Cancel();
+    refreshThread.join();
+    
+    std::lock_guard<std::mutex> lock(refreshMutex);
+    delete refreshBudget;
+    refreshBudget = nullptr;
+}
+
+void OnlineSearch::RefreshLoop() {
+    while (!refreshCancel) {
+        int wait = REFRESH_MIN_SLEEP_SECONDS;
+        if (settings.enabled && IsOnline()) {
+            RefreshFeeds(false);
+            wait = GetSecondsUntilRefresh();
+        }
+        wait = std::max(REFRESH_MIN_SLEEP_SECONDS, std::min(wait, REFRESH_MAX_SLEEP_SECONDS));
+        
+        // Short steps so StopFeedRefresh doesn't wait out the interval
+        for (int i = 0; i < wait * 4 && !refreshCancel; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        }
+    }
+}
+
+std::vector<FeedState> OnlineSearch::LoadFeedStates(const std::vector<FeedConfig>& feeds) {
+    std::vector<FeedState> states(feeds.size());
+    for (size_t i = 0; i < feeds.size(); i++) {
+        database->GetFeedState(feeds[i].url, states[i]);  // Unknown feeds are due now
+    }
+    return states;
+}
+
+int OnlineSearch::GetSecondsUntilRefresh() {
+    std::lock_guard<std::mutex> lock(refreshMutex);
+    
+    auto feeds = rssParser->GetConfiguredFeeds();
+    return scheduler.GetSecondsUntilDue(feeds, LoadFeedStates(feeds), time(nullptr));
+}
+
+int OnlineSearch::RefreshFeeds(bool force) {
+    if (!netFetcher || !rssParser || !database) return 0;
+    
+    std::lock_guard<std::mutex> lock(refreshMutex);
+    
+    scheduler.SetDefaultInterval(settings.feedRefreshMinutes * 60);
+    scheduler.SetBudget((size_t)std::max(0, settings.feedBudgetKBPerHour) * 1024,
+                        settings.feedFetchesPerHour);
+    
+    auto feeds = rssParser->GetConfiguredFeeds();
+    auto states = LoadFeedStates(feeds);
+    time_t now = time(nullptr);
+    
+    std::vector<size_t> order;
+    if (force) {
+        for (size_t i = 0; i < feeds.size(); i++) {
+            if (feeds[i].enabled) order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&feeds](size_t a, size_t b) {
+            return feeds[a].priority > feeds[b].priority;
+        });
+    } else {
+        order = scheduler.GetDueFeeds(feeds, states, now);
+    }
+    
+    int fetched = 0;
+    for (size_t index : order) {
+        if (refreshCancel) break;
+        
+        // Over budget: the rest stay due and the highest priority goes first next pass
+        if (!force && !scheduler.HasBudget(time(nullptr))) break;
+        
+        if (RefreshFeed(feeds[index])) fetched++;
+    }
+    
+    database->PruneFeedItems(now - (time_t)settings.feedItemMaxAgeDays * 24 * 3600);
+    
+    // Pages not looked at in a month won't be asked for conditionally again
+    database->PruneHttpValidators(now - (time_t)VALIDATOR_MAX_AGE_DAYS * 24 * 3600);
+    return fetched;
+}
+
+bool OnlineSearch::RefreshFeed(const FeedConfig& feed) {
+    // Parse the feed as it downloads
+    RSSFeed parsedFeed;
+    FeedStream stream(rssParser, parsedFeed);
+    auto fetchResult = netFetcher->FetchURLStreaming(feed.url,
+        [this, &stream](const char* data, size_t length) {
+            stream.Feed(data, length);
+            return !refreshCancel;
+        }, settings.timeoutSeconds, true, refreshBudget);
+    
+    time_t now = time(nullptr);
+    scheduler.ChargeFetch(fetchResult.bytesRead, now);
+    
+    FeedState state;
+    database->GetFeedState(feed.url, state);
+    state.url = feed.url;
+    
+    // 304: the stored items are current, nothing to parse. A failed feed
+    // also backs off instead of retrying every pass
+    bool parsed = fetchResult.success && !fetchResult.notModified &&
+                  !fetchResult.stoppedEarly && stream.Finish();
+    if (!parsed) {
+        bool unchanged = fetchResult.success && fetchResult.notModified;
+        scheduler.UpdateSchedule(state, feed, std::vector<time_t>(), 0, unchanged, now);
+        state.last_fetched = now;
+        database->SetFeedState(state);
+        return unchanged;
+    }
+    
+    std::vector<FeedItem> items;
+    std::vector<time_t> itemDates;
+    for (const auto& entry : parsedFeed.items) {
+        if (entry.link.empty() || entry.title.empty()) continue;
+        
+        FeedItem item;
+        item.id = GenerateItemHash(entry.link);
+        item.feed_url = feed.url;
+        item.source = feed.name;
+        item.title = entry.title;
+        item.link = entry.link;
+        item.description = entry.description;
+        item.author = entry.author;
+        item.published_at = entry.pubDate;
+        item.fetched_at = now;
+        item.score = 0.0f;
+        items.push_back(item);
+        
+        if (entry.pubDate > 0) itemDates.push_back(entry.pubDate);
+    }
+    
+    // Learn from what this poll brought before last_fetched moves on
+    int added = database->StoreFeedItems(items);
+    scheduler.UpdateSchedule(state, feed, itemDates, added, true, now);
+    state.last_fetched = now;
+    state.item_count = (int)items.size();
+    return database->SetFeedState(state);
+}
+
+bool OnlineSearch::FetchAndExtract(const std::string& url, VaultItem& outItem,
+                                   FetchBudget* budget) {
     if (!netFetcher || !extractor) return false;
     
-    // Fetch URL
-    auto fetchResult = netFetcher->FetchURL(url, settings.timeoutSeconds);
-    if (!fetchResult.success) {
+    // Extract while the page downloads; stop once the body is in. A page
+    // cut off by the budget is not saved half-read. Not conditional: pages
+    // already in the vault never get here, so a 304 would only lock out a
+    // page whose save failed. The HTTP cache still revalidates its copy
+    ExtractionStream stream(extractor, url);
+    auto fetchResult = netFetcher->FetchURLStreaming(url,
+        [&stream](const char* data, size_t length) {
+            return stream.Feed(data, length);
+        }, settings.timeoutSeconds, false, budget);
+    if (!fetchResult.success || fetchResult.notModified) {
         return false;
     }
     
-    // Extract content
-    auto content = extractor->Extract(fetchResult.html, url);
+    auto content = stream.Finish();
     
     // Skip if paywall detected
     if (content.hasPaywall) {
         return false;
     }
     
-    // Generate ID
-    outItem.id = GenerateItemHash(url, content.title, content.publishDate);
+    // Identity is the canonical URL (tracking params, fragment etc. removed)
+    outItem.id = GenerateItemHash(url);
     outItem.title = content.title;
-    outItem.url = url;
+    outItem.url = CanonicalizeUrl(url);
     outItem.source_domain = content.domain;
     outItem.author = content.author;
     outItem.published_at = content.publishDate;
@@ -188,15 +372,20 @@ bool OnlineSearch::FetchAndExtract(const std::string& url, VaultItem& outItem) {
     outItem.text_clean = content.mainText;
     outItem.language = content.language;
     outItem.content_type = "article";
-    
-    // Convert quotes to JSON (simplified)
-    std::string quotesJson = "[";
-    for (size_t i = 0; i < content.quotes.size(); i++) {
-        if (i > 0) quotesJson += ",";
-        quotesJson += "\"" + content.quotes[i] + "\"";
+    outItem.steps = content.steps;
+    outItem.warnings = content.warnings;
+    outItem.bullets = content.bullets;
+    
+    // Attributed quotes go to the quotes table; quotes_json keeps them in items_fts
+    for (const auto& quote : content.quotes) {
+        VaultQuote vaultQuote;
+        vaultQuote.text = quote.text;
+        vaultQuote.speaker = quote.speaker;
+        vaultQuote.context = quote.context;
+        vaultQuote.position = quote.position;
+        outItem.quotes.push_back(vaultQuote);
     }
-    quotesJson += "]";
-    outItem.quotes_json = quotesJson;
+    outItem.quotes_json = EncodeQuotesJson(outItem.quotes);
     
     return true;
 }
@@ -208,51 +397,70 @@ bool OnlineSearch::SaveToVault(const VaultItem& item) {
 }
 
 bool OnlineSearch::FetchMultipleAndSave(const std::vector<std::string>& urls,
-                                       std::vector<VaultItem>& outItems) {
+                                       std::vector<VaultItem>& outItems,
+                                       FetchBudget* budget) {
+    std::vector<std::string> unknown;
     for (const auto& url : urls) {
-        VaultItem item;
-        if (FetchAndExtract(url, item)) {
-            if (!IsDuplicate(item)) {
-                if (SaveToVault(item)) {
-                    outItems.push_back(item);
-                }
-            }
-        }
-        
-        // Rate limiting
-        sceKernelDelayThread(2000000);  // 2 seconds between fetches
+        if (!IsKnownUrl(url)) unknown.push_back(url);
     }
     
+    FetchAndSaveAll(unknown, (int)unknown.size(), outItems, budget);
     return !outItems.empty();
 }
 
+void OnlineSearch::FetchAndSaveAll(const std::vector<std::string>& urls, int limit,
+                                   std::vector<VaultItem>& outItems, FetchBudget* budget) {
+    if (!netFetcher) return;
+    
+    // Fetch and extract concurrently (per-host politeness is the fetcher's)...
+    std::vector<VaultItem> items(urls.size());
+    std::vector<char> fetched(urls.size(), 0);
+    netFetcher->RunFetches(urls, FETCH_CONCURRENCY,
+        [this, &urls, &items, &fetched, budget](size_t index) {
+            fetched[index] = FetchAndExtract(urls[index], items[index], budget);
+        }, budget);
+    
+    // ...then dedupe and save in ranking order, so duplicates within the
+    // batch are caught too; pages dropped for the budget are simply missing
+    int saved = 0;
+    for (size_t i = 0; i < urls.size() && saved < limit; i++) {
+        if (!fetched[i] || IsDuplicate(items[i])) continue;
+        if (SaveToVault(items[i])) {
+            outItems.push_back(items[i]);
+            saved++;
+        }
+    }
+}
+
 bool OnlineSearch::IsDuplicate(const VaultItem& item) {
     if (!database) return false;
     
     // Check if item with same ID already exists
     VaultItem existing;
-    return database->GetItemById(item.id, existing);
+    if (database->GetItemById(item.id, existing)) {
+        return true;
+    }
+    
+    // Same article under another URL (second feed, tracking params, syndication)
+    std::string duplicateId;
+    return database->FindNearDuplicate(ComputeBodySimHash(item.text_clean), duplicateId);
 }
 
-std::string OnlineSearch::GenerateItemHash(const std::string& url,
-                                          const std::string& title,
-                                          time_t published) {
-    // Simple hash generation (should use proper hash function)
-    std::stringstream ss;
-    ss << url << "_" << title << "_" << published;
-    
-    // Take first 16 chars of combined string as hash
-    std::string combined = ss.str();
-    if (combined.length() > 16) {
-        combined = combined.substr(0, 16);
-    }
+std::string OnlineSearch::GenerateItemHash(const std::string& url) {
+    return ComputeItemId(url);
+}
+
+bool OnlineSearch::IsKnownUrl(const std::string& url) {
+    if (!database) return false;
     
-    // Replace non-alphanumeric with underscores
-    for (char& c : combined) {
-        if (!isalnum(c)) c = '_';
-    }
+    // The Bloom filter answers "new" without touching SQLite; a hit can be
+    // a false positive, and skipping a new article would lose it, so the
+    // database has the final word
+    std::string id = GenerateItemHash(url);
+    if (!database->MayHaveItem(id)) return false;
     
-    return combined;
+    VaultItem existing;
+    return database->GetItemById(id, existing);
 }
 
 std::vector<OnlineResult> OnlineSearch::FilterAndRank(const std::vector<OnlineResult>& results,
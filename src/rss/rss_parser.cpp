@@ -1,7 +1,13 @@
 #include "rss_parser.h"
+#include "html_tokenizer.h"
+#include "text_normalize.h"
+#include "page_metadata.h"
 #include <algorithm>
 #include <sstream>
 #include <fstream>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
 
 RSSParser::RSSParser() {
 }
@@ -9,178 +15,368 @@ RSSParser::RSSParser() {
 RSSParser::~RSSParser() {
 }
 
-bool RSSParser::ParseFeed(const std::string& xmlContent, RSSFeed& outFeed) {
-    // Auto-detect RSS vs Atom
-    if (xmlContent.find("<rss") != std::string::npos) {
-        return ParseRSS(xmlContent, outFeed);
-    } else if (xmlContent.find("<feed") != std::string::npos) {
-        return ParseAtom(xmlContent, outFeed);
+// Prefixes feeds use, keyed by namespace URI
+static const struct {
+    const char* uri;
+    const char* alias;
+} KNOWN_NAMESPACES[] = {
+    { "http://purl.org/dc/elements/1.1/", "dc" },
+    { "http://purl.org/dc/terms/", "dcterms" },
+    { "http://purl.org/rss/1.0/modules/content/", "content" },
+    { "http://www.w3.org/2005/Atom", "atom" },
+    { "http://www.w3.org/1999/02/22-rdf-syntax-ns#", "rdf" },
+    { nullptr, nullptr }
+};
+
+static const size_t MAX_NAME_LENGTH = 64;
+
+static bool NameIs(const char* name, const char* expected) {
+    return strcasecmp(name, expected) == 0;
+}
+
+// Decoded text that still looks like HTML ("<p>", "</b>")
+static bool HasMarkup(const std::string& text) {
+    for (size_t i = 0; i + 1 < text.length(); i++) {
+        if (text[i] == '<' && (isalpha((unsigned char)text[i + 1]) || text[i + 1] == '/')) {
+            return true;
+        }
     }
     return false;
 }
 
+bool RSSParser::ParseFeed(const std::string& xmlContent, RSSFeed& outFeed) {
+    FeedStream stream(this, outFeed);
+    stream.Feed(xmlContent.data(), xmlContent.length());
+    return stream.Finish();
+}
+
 bool RSSParser::ParseRSS(const std::string& xmlContent, RSSFeed& outFeed) {
-    // Extract channel metadata
-    outFeed.title = ExtractTag(xmlContent, "title");
-    outFeed.link = ExtractTag(xmlContent, "link");
-    outFeed.description = ExtractTag(xmlContent, "description");
-    
-    // Extract items
-    std::vector<std::string> itemXmls = ExtractAllTags(xmlContent, "item");
-    
-    for (const auto& itemXml : itemXmls) {
-        RSSItem item;
-        item.title = StripTags(ExtractTag(itemXml, "title"));
-        item.link = ExtractTag(itemXml, "link");
-        item.description = StripTags(ExtractTag(itemXml, "description"));
-        item.author = ExtractTag(itemXml, "author");
-        if (item.author.empty()) {
-            item.author = ExtractTag(itemXml, "dc:creator");
-        }
-        item.guid = ExtractTag(itemXml, "guid");
-        
-        // Parse date
-        std::string pubDateStr = ExtractTag(itemXml, "pubDate");
-        if (pubDateStr.empty()) {
-            pubDateStr = ExtractTag(itemXml, "dc:date");
-        }
-        item.pubDate = ParseRFC822Date(pubDateStr);
-        
-        outFeed.items.push_back(item);
+    return ParseFeed(xmlContent, outFeed);
+}
+
+bool RSSParser::ParseAtom(const std::string& xmlContent, RSSFeed& outFeed) {
+    return ParseFeed(xmlContent, outFeed);
+}
+
+FeedStream::FeedStream(RSSParser* parser, RSSFeed& feed)
+    : parser(parser), feed(feed), tokenizer(nullptr, 0, false), format(FORMAT_UNKNOWN),
+      depth(0), channelDepth(0), itemDepth(0), authorDepth(0),
+      fieldDepth(0), fieldText(nullptr), fieldDate(nullptr), fieldFallback(false) {
+    feed.lastBuildDate = 0;
+}
+
+void FeedStream::Feed(const char* data, size_t length) {
+    if (carry.empty()) {
+        Consume(data, length, false);
+    } else {
+        std::string buffer;
+        buffer.swap(carry);
+        buffer.append(data, length);
+        Consume(buffer.data(), buffer.length(), false);
+    }
+}
+
+bool FeedStream::Finish() {
+    if (!carry.empty()) {
+        std::string buffer;
+        buffer.swap(carry);
+        Consume(buffer.data(), buffer.length(), true);
     }
     
-    return !outFeed.items.empty();
+    // Truncated feed: keep what the open field had
+    if (fieldDepth) EndField();
+    
+    return !feed.items.empty();
 }
 
-bool RSSParser::ParseAtom(const std::string& xmlContent, RSSFeed& outFeed) {
-    // Extract feed metadata
-    outFeed.title = ExtractTag(xmlContent, "title");
+void FeedStream::Consume(const char* data, size_t length, bool final) {
+    tokenizer.Reset(data, length, final);
+    
+    HtmlToken token;
+    while (tokenizer.Next(token)) {
+        ConsumeToken(token);
+    }
+    
+    size_t offset = tokenizer.GetOffset();
+    if (!final && offset < length) {
+        carry.assign(data + offset, length - offset);
+    }
+}
+
+void FeedStream::ConsumeToken(const HtmlToken& token) {
+    if (token.type == HTML_TEXT) {
+        // CDATA comes through as text too; entities are decoded either way
+        if (fieldDepth) {
+            AppendNormalizedText(text, token.text.data, token.text.length,
+                                 TEXT_DECODE_ENTITIES | TEXT_COLLAPSE_SPACE);
+        }
+        return;
+    }
+    if (token.type == HTML_RAW_TEXT || format == FORMAT_OTHER) return;
     
-    std::string linkTag = ExtractTag(xmlContent, "link");
-    size_t hrefPos = linkTag.find("href=\"");
-    if (hrefPos != std::string::npos) {
-        size_t start = hrefPos + 6;
-        size_t end = linkTag.find("\"", start);
-        outFeed.link = linkTag.substr(start, end - start);
+    if (token.type == HTML_END_TAG) {
+        if (depth == 0) return;
+        if (depth == fieldDepth) EndField();
+        if (depth == authorDepth) authorDepth = 0;
+        if (depth == itemDepth) itemDepth = 0;
+        if (depth == channelDepth) channelDepth = 0;
+        depth--;
+        return;
     }
     
-    outFeed.description = ExtractTag(xmlContent, "subtitle");
+    // Self-closing elements don't change the depth but sit one level down
+    int level = depth + 1;
+    if (!token.selfClosing) depth = level;
     
-    // Extract entries
-    std::vector<std::string> entryXmls = ExtractAllTags(xmlContent, "entry");
+    // Markup inside a field (Atom xhtml content, unescaped HTML) is dropped
+    if (fieldDepth) {
+        AppendNormalizedText(text, " ", 1, TEXT_COLLAPSE_SPACE);
+        return;
+    }
     
-    for (const auto& entryXml : entryXmls) {
-        RSSItem item;
-        item.title = StripTags(ExtractTag(entryXml, "title"));
-        
-        // Extract link
-        std::string linkTag = ExtractTag(entryXml, "link");
-        size_t hrefPos = linkTag.find("href=\"");
-        if (hrefPos != std::string::npos) {
-            size_t start = hrefPos + 6;
-            size_t end = linkTag.find("\"", start);
-            item.link = linkTag.substr(start, end - start);
-        }
-        
-        item.description = StripTags(ExtractTag(entryXml, "summary"));
-        if (item.description.empty()) {
-            item.description = StripTags(ExtractTag(entryXml, "content"));
+    StartElement(token, level);
+}
+
+void FeedStream::StartElement(const HtmlToken& token, int level) {
+    if (token.attributes.Contains("xmlns:")) ReadNamespaces(token);
+    
+    char name[MAX_NAME_LENGTH];
+    QualifiedName(token.name, name, sizeof(name));
+    
+    if (format == FORMAT_UNKNOWN) {
+        if (NameIs(name, "rss") || NameIs(name, "rdf:RDF")) {
+            format = FORMAT_RSS;
+        } else if (NameIs(name, "feed")) {
+            format = FORMAT_ATOM;
+            channelDepth = level;
+        } else {
+            format = FORMAT_OTHER;
         }
-        
-        item.author = ExtractTag(entryXml, "author");
-        item.guid = ExtractTag(entryXml, "id");
-        
-        // Parse date
-        std::string pubDateStr = ExtractTag(entryXml, "published");
-        if (pubDateStr.empty()) {
-            pubDateStr = ExtractTag(entryXml, "updated");
+        return;
+    }
+    
+    if (itemDepth) {
+        StartItemElement(token, name, level);
+        return;
+    }
+    
+    if (NameIs(name, format == FORMAT_RSS ? "item" : "entry")) {
+        feed.items.push_back(RSSItem());
+        itemDepth = level;
+        return;
+    }
+    if (format == FORMAT_RSS && NameIs(name, "channel")) {
+        channelDepth = level;
+        return;
+    }
+    
+    // Feed-level metadata
+    if (!channelDepth || level != channelDepth + 1) return;
+    
+    if (NameIs(name, "title")) {
+        StartField(level, &feed.title, nullptr, false);
+    } else if (NameIs(name, "description") || NameIs(name, "subtitle")) {
+        StartField(level, &feed.description, nullptr, false);
+    } else if (NameIs(name, "lastBuildDate") || NameIs(name, "updated")) {
+        StartField(level, nullptr, &feed.lastBuildDate, false);
+    } else if (NameIs(name, "link")) {
+        HtmlSpan rel, href;
+        if (format == FORMAT_RSS) {
+            StartField(level, &feed.link, nullptr, false);
+        } else if (feed.link.empty() && HtmlTokenizer::GetAttribute(token, "href", href) &&
+                   (!HtmlTokenizer::GetAttribute(token, "rel", rel) || rel.Equals("alternate"))) {
+            feed.link = href.ToString();
         }
-        item.pubDate = ParseISO8601Date(pubDateStr);
-        
-        outFeed.items.push_back(item);
     }
     
-    return !outFeed.items.empty();
+    // An empty element has no end tag to close the field
+    if (token.selfClosing && fieldDepth) EndField();
 }
 
-std::string RSSParser::ExtractTag(const std::string& xml, const std::string& tag) {
-    std::string openTag = "<" + tag;
-    std::string closeTag = "</" + tag + ">";
+void FeedStream::StartItemElement(const HtmlToken& token, const char* name, int level) {
+    RSSItem& item = feed.items.back();
     
-    size_t start = xml.find(openTag);
-    if (start == std::string::npos) return "";
+    // Atom <author><name>
+    if (authorDepth) {
+        if (level == authorDepth + 1 && NameIs(name, "name")) {
+            StartField(level, &item.author, nullptr, false);
+        }
+    } else if (level == itemDepth + 1) {
+        if (NameIs(name, "title")) {
+            StartField(level, &item.title, nullptr, false);
+        } else if (NameIs(name, "description") || NameIs(name, "summary")) {
+            StartField(level, &item.description, nullptr, false);
+        } else if (NameIs(name, "content:encoded") || NameIs(name, "content")) {
+            // Full text only when there is no summary (first value wins)
+            StartField(level, &item.description, nullptr, false);
+        } else if (NameIs(name, "guid") || NameIs(name, "id")) {
+            StartField(level, &item.guid, nullptr, false);
+        } else if (NameIs(name, "pubDate") || NameIs(name, "published")) {
+            StartField(level, nullptr, &item.pubDate, false);
+        } else if (NameIs(name, "dc:date") || NameIs(name, "updated")) {
+            StartField(level, nullptr, &item.pubDate, true);
+        } else if (format == FORMAT_ATOM && NameIs(name, "author")) {
+            if (!token.selfClosing) authorDepth = level;
+        } else if (NameIs(name, "author") || NameIs(name, "dc:creator")) {
+            StartField(level, &item.author, nullptr, false);
+        } else if (NameIs(name, "link")) {
+            HtmlSpan rel, href;
+            if (format == FORMAT_RSS) {
+                StartField(level, &item.link, nullptr, false);
+            } else if (item.link.empty() && HtmlTokenizer::GetAttribute(token, "href", href) &&
+                       (!HtmlTokenizer::GetAttribute(token, "rel", rel) || rel.Equals("alternate"))) {
+                item.link = href.ToString();
+            }
+        }
+    }
     
-    // Find end of opening tag
-    start = xml.find(">", start);
-    if (start == std::string::npos) return "";
-    start++;
+    if (token.selfClosing && fieldDepth) EndField();
+}
+
+void FeedStream::StartField(int level, std::string* target, time_t* date, bool fallback) {
+    fieldDepth = level;
+    fieldText = target;
+    fieldDate = date;
+    fieldFallback = fallback;
+    text.clear();
+}
+
+void FeedStream::EndField() {
+    // Escaped or CDATA-wrapped HTML only shows up once decoded
+    std::string value;
+    if (HasMarkup(text)) {
+        value = parser->StripTags(text);
+    } else {
+        value.swap(text);
+        while (!value.empty() && value[value.length() - 1] == ' ') {
+            value.erase(value.length() - 1);
+        }
+    }
     
-    size_t end = xml.find(closeTag, start);
-    if (end == std::string::npos) return "";
+    // First value wins, so <description> beats a later <content:encoded>
+    if (fieldText && fieldText->empty()) {
+        fieldText->swap(value);
+    } else if (fieldDate && (!fieldFallback || *fieldDate == 0)) {
+        time_t date = parser->ParseRFC822Date(value);
+        if (date > 0) *fieldDate = date;
+    }
     
-    return xml.substr(start, end - start);
+    fieldDepth = 0;
+    fieldText = nullptr;
+    fieldDate = nullptr;
+    text.clear();
 }
 
-std::vector<std::string> RSSParser::ExtractAllTags(const std::string& xml, const std::string& tag) {
-    std::vector<std::string> results;
-    std::string openTag = "<" + tag;
-    std::string closeTag = "</" + tag + ">";
+// xmlns:prefix="uri" declarations; feeds put them on the root element
+void FeedStream::ReadNamespaces(const HtmlToken& token) {
+    const char* p = token.attributes.data;
+    const char* end = p + token.attributes.length;
     
-    size_t pos = 0;
-    while (true) {
-        size_t start = xml.find(openTag, pos);
-        if (start == std::string::npos) break;
+    while (p < end) {
+        const char* hit = static_cast<const char*>(memchr(p, 'x', end - p));
+        if (!hit) break;
+        p = hit + 1;
+        if (end - hit < 7 || strncmp(hit, "xmlns:", 6) != 0) continue;
+        
+        const char* prefixStart = hit + 6;
+        const char* prefixEnd = prefixStart;
+        while (prefixEnd < end && *prefixEnd != '=' && !isspace((unsigned char)*prefixEnd)) prefixEnd++;
         
-        size_t end = xml.find(closeTag, start);
-        if (end == std::string::npos) break;
+        const char* valueStart = prefixEnd;
+        while (valueStart < end && (*valueStart == '=' || isspace((unsigned char)*valueStart))) valueStart++;
+        if (valueStart >= end || (*valueStart != '"' && *valueStart != '\'')) continue;
+        char quote = *valueStart++;
+        const char* valueEnd = valueStart;
+        while (valueEnd < end && *valueEnd != quote) valueEnd++;
+        p = valueEnd;
+        
+        HtmlSpan uri(valueStart, valueEnd - valueStart);
+        for (int i = 0; KNOWN_NAMESPACES[i].uri; i++) {
+            if (uri.Equals(KNOWN_NAMESPACES[i].uri)) {
+                Namespace ns;
+                ns.prefix.assign(prefixStart, prefixEnd - prefixStart);
+                ns.alias = KNOWN_NAMESPACES[i].alias;
+                namespaces.push_back(ns);
+                break;
+            }
+        }
+    }
+}
+
+// Element name with its prefix replaced by the usual one for its namespace
+void FeedStream::QualifiedName(const HtmlSpan& name, char* buffer, size_t size) const {
+    const char* colon = static_cast<const char*>(memchr(name.data, ':', name.length));
+    const char* local = name.data;
+    size_t localLength = name.length;
+    const char* prefix = nullptr;
+    size_t prefixLength = 0;
+    
+    if (colon) {
+        prefix = name.data;
+        prefixLength = colon - name.data;
+        local = colon + 1;
+        localLength = name.length - prefixLength - 1;
         
-        end += closeTag.length();
-        results.push_back(xml.substr(start, end - start));
-        pos = end;
+        for (const auto& ns : namespaces) {
+            if (ns.prefix.length() == prefixLength &&
+                strncmp(ns.prefix.data(), prefix, prefixLength) == 0) {
+                prefix = ns.alias;
+                prefixLength = strlen(ns.alias);
+                break;
+            }
+        }
     }
     
-    return results;
+    size_t length = 0;
+    if (prefix && prefixLength + 1 < size) {
+        memcpy(buffer, prefix, prefixLength);
+        buffer[prefixLength] = ':';
+        length = prefixLength + 1;
+    }
+    if (length + localLength >= size) localLength = size - 1 - length;
+    memcpy(buffer + length, local, localLength);
+    buffer[length + localLength] = '\0';
 }
 
+// Text of a tag body: CDATA unwrapped, tags dropped, entities decoded and
+// whitespace collapsed. Escaped markup ("&lt;p&gt;...") is common in
+// <description>; once decoded it is stripped in a second pass.
 std::string RSSParser::StripTags(const std::string& html) {
     std::string result;
-    bool inTag = false;
-    
-    for (char c : html) {
-        if (c == '<') {
-            inTag = true;
-        } else if (c == '>') {
-            inTag = false;
-        } else if (!inTag) {
-            result += c;
+    
+    for (int pass = 0; pass < 2; pass++) {
+        std::string source;
+        source.swap(result);
+        const std::string& input = (pass == 0) ? html : source;
+        
+        HtmlTokenizer tokenizer(input);
+        HtmlToken token;
+        while (tokenizer.Next(token)) {
+            if (token.type == HTML_TEXT) {
+                AppendNormalizedText(result, token.text.data, token.text.length,
+                                     TEXT_DECODE_ENTITIES | TEXT_COLLAPSE_SPACE);
+            } else if (token.type != HTML_RAW_TEXT) {
+                AppendNormalizedText(result, " ", 1, TEXT_COLLAPSE_SPACE);
+            }
         }
+        
+        if (!HasMarkup(result)) break;
     }
     
+    while (!result.empty() && result[result.length() - 1] == ' ') {
+        result.erase(result.length() - 1);
+    }
     return result;
 }
 
 time_t RSSParser::ParseRFC822Date(const std::string& dateStr) {
-    // Simplified RFC 822 parser
-    // Format: "Mon, 15 Jun 2024 10:30:00 GMT"
-    
-    if (dateStr.empty()) return 0;
-    
-    struct tm tm = {0};
-    // This would need proper date parsing implementation
-    // For now, return current time as placeholder
-    return time(nullptr);
+    // "Mon, 15 Jun 2024 10:30:00 GMT"; 0 when missing or malformed
+    return ParseWebDate(dateStr);
 }
 
 time_t RSSParser::ParseISO8601Date(const std::string& dateStr) {
-    // Simplified ISO 8601 parser
-    // Format: "2024-06-15T10:30:00Z"
-    
-    if (dateStr.empty()) return 0;
-    
-    struct tm tm = {0};
-    // This would need proper date parsing implementation
-    // For now, return current time as placeholder
-    return time(nullptr);
+    // "2024-06-15T10:30:00Z"
+    return ParseWebDate(dateStr);
 }
 
 bool RSSParser::LoadFeedConfig(const std::string& configPath) {
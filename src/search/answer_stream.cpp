@@ -0,0 +1,71 @@
+#include "answer_stream.h"
+#include "fetch_budget.h"
+
+AnswerStream::AnswerStream() : finished(false), cancelled(false), budget(nullptr) {
+}
+
+AnswerStream::~AnswerStream() {
+}
+
+void AnswerStream::PushPartial(const Answer& answer) {
+    AnswerEvent event;
+    event.type = ANSWER_EVENT_PARTIAL;
+    event.answer = answer;
+    Push(event);
+}
+
+void AnswerStream::PushToken(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    // Coalesce consecutive tokens so a slow UI frame drains one event
+    if (!events.empty() && events.back().type == ANSWER_EVENT_TOKEN) {
+        events.back().token += token;
+        return;
+    }
+    
+    AnswerEvent event;
+    event.type = ANSWER_EVENT_TOKEN;
+    event.token = token;
+    events.push_back(event);
+}
+
+void AnswerStream::PushFinal(const Answer& answer) {
+    AnswerEvent event;
+    event.type = ANSWER_EVENT_FINAL;
+    event.answer = answer;
+    Push(event);
+    finished = true;
+}
+
+void AnswerStream::Push(const AnswerEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(event);
+}
+
+bool AnswerStream::Poll(AnswerEvent& outEvent) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (events.empty()) return false;
+    
+    outEvent = events.front();
+    events.pop_front();
+    return true;
+}
+
+void AnswerStream::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    if (budget) budget->Cancel();
+}
+
+void AnswerStream::SetBudget(FetchBudget* newBudget) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = newBudget;
+    if (budget && cancelled) budget->Cancel();
+}
+
+void AnswerStream::Reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+    finished = false;
+    cancelled = false;
+}
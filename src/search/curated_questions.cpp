@@ -0,0 +1,23 @@
+#include "curated_questions.h"
+
+const CuratedQuestion SCENARIO_QUESTIONS[] = {
+    {"scenario:bleeding",  "Bleeding",        "how to stop bleeding"},
+    {"scenario:burns",     "Burns",           "how to treat burns"},
+    {"scenario:lost",      "Lost/Navigation", "what to do if you are lost"},
+    {"scenario:water",     "No Water",        "how to purify water"},
+    {"scenario:cold",      "Cold Weather",    "how to treat hypothermia"},
+    {"scenario:heat",      "Hot Weather",     "how to treat heat stroke"},
+    {"scenario:shelter",   "Shelter",         "how to build an emergency shelter"},
+    {"scenario:food",      "Food/Hunting",    "how to find food in the wild"}
+};
+const int SCENARIO_QUESTION_COUNT = sizeof(SCENARIO_QUESTIONS) / sizeof(SCENARIO_QUESTIONS[0]);
+
+const CuratedQuestion MANUAL_QUESTIONS[] = {
+    {"manual:first-aid",   "First Aid Basics",       "first aid basics"},
+    {"manual:water",       "Water Purification",     "how to purify water"},
+    {"manual:fire",        "Fire Starting",          "how to build a fire"},
+    {"manual:signaling",   "Signaling for Rescue",   "how to signal for rescue"},
+    {"manual:navigation",  "Navigation",             "how to use a compass"},
+    {"manual:kit",         "Emergency Kit",          "what is in an emergency kit"}
+};
+const int MANUAL_QUESTION_COUNT = sizeof(MANUAL_QUESTIONS) / sizeof(MANUAL_QUESTIONS[0]);
@@ -1,9 +1,22 @@
 #include "search_engine.h"
 #include "llm_engine.h"
+#include "answer_stream.h"
+#include "simhash.h"
+#ifdef __vita__
+#include "survival_ai.h"
+#include "online_search.h"
+#endif
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 
+// MMR trade-off between relevance (1.0) and novelty (0.0)
+static const float MMR_LAMBDA = 0.7f;
+// Bodies this similar are the same story; the lower-ranked copy is dropped
+static const float DUPLICATE_SIMILARITY = 0.9f;
+
 SearchEngine::SearchEngine() : database(nullptr), zimReader(nullptr), 
                                onlineSearch(nullptr), llmEngine(nullptr) {
 }
@@ -20,11 +33,12 @@ void SearchEngine::Initialize(Database* db, ZIMReader* zim, OnlineSearch* online
 
 Answer SearchEngine::Ask(const std::string& query) {
     // Auto-detect online/offline and route accordingly
+#ifdef __vita__
     if (onlineSearch && onlineSearch->IsOnline() && g_app.onlineModeEnabled) {
         return AskOnline(query);
-    } else {
-        return AskOffline(query);
     }
+#endif
+    return AskOffline(query);
 }
 
 Answer SearchEngine::AskOnline(const std::string& query) {
@@ -36,27 +50,21 @@ Answer SearchEngine::AskOnline(const std::string& query) {
         return answer;
     }
     
-    // Step 1: Search online and save results
+    // Step 1: Search online and save results (host builds have no network stack)
     std::vector<VaultItem> onlineItems;
+#ifdef __vita__
     if (onlineSearch) {
         onlineSearch->SearchAndSave(query, onlineItems);
     }
+#endif
     
     // Step 2: Search vault (includes newly saved items)
-    std::vector<SearchResult> vaultResults;
-    if (database) {
-        QueryAnalysis analysis = AnalyzeQuery(query);
-        if (analysis.intent == INTENT_QUOTE) {
-            vaultResults = database->SearchQuotes(analysis.person, analysis.secondaryTopic, 10);
-        } else {
-            vaultResults = database->SearchFTS(query, 10);
-        }
-    }
+    std::vector<SearchResult> vaultResults = SearchVault(query, 10);
     
     // Step 3: Fallback to Wikipedia if needed
     std::vector<ZIMSearchResult> zimResults;
-    if (vaultResults.empty() && zimReader && zimReader->IsLoaded()) {
-        zimResults = zimReader->SearchArticles(query, 5);
+    if (vaultResults.empty()) {
+        zimResults = SearchWikipedia(query, 5);
     }
     
     // Step 4: Generate answer
@@ -72,24 +80,215 @@ Answer SearchEngine::AskOffline(const std::string& query) {
         return answer;
     }
     
-    // Analyze query intent
+    // Search vault
+    std::vector<SearchResult> vaultResults = SearchVault(query, 10);
+    
+    // Search Wikipedia
+    std::vector<ZIMSearchResult> zimResults = SearchWikipedia(query, 5);
+    
+    return GenerateAnswer(query, vaultResults, zimResults);
+}
+
+Answer SearchEngine::AskStreaming(const std::string& query, AnswerStream& stream) {
+    Answer answer;
+    answer.type = ANSWER_NONE;
+    answer.confidence = 0.0f;
+    
+    if (query.empty()) {
+        stream.PushFinal(answer);
+        return answer;
+    }
+    
     QueryAnalysis analysis = AnalyzeQuery(query);
     
-    // Search vault
-    std::vector<SearchResult> vaultResults;
-    if (database) {
-        if (analysis.intent == INTENT_QUOTE) {
-            vaultResults = database->SearchQuotes(analysis.person, analysis.secondaryTopic, 10);
-        } else {
-            vaultResults = database->SearchFTS(query, 10);
+    // Stage 1: local retrieval - sources and extractive summary go out now
+    std::vector<SearchResult> vaultResults = SearchVault(query, 10);
+    std::vector<ZIMSearchResult> zimResults = SearchWikipedia(query, 5);
+    answer = GenerateAnswer(query, vaultResults, zimResults);
+    stream.PushPartial(answer);
+
+#ifdef __vita__
+    // Stage 2: fetch fresh articles (or cached copies when offline), then
+    // rebuild with them included
+    if (!stream.IsCancelled() && onlineSearch && g_app.onlineModeEnabled) {
+        // Cancelling the stream cancels the budget and aborts its fetches
+        FetchBudget* budget = onlineSearch->CreateSearchBudget();
+        stream.SetBudget(budget);
+        
+        std::vector<VaultItem> onlineItems;
+        bool found = onlineSearch->SearchAndSave(query, onlineItems, *budget);
+        stream.SetBudget(nullptr);
+        delete budget;
+        
+        if (found) {
+            vaultResults = SearchVault(query, 10);
+            answer = GenerateAnswer(query, vaultResults, zimResults);
+            stream.PushPartial(answer);
         }
     }
+#endif
     
-    // Search Wikipedia
-    std::vector<ZIMSearchResult> zimResults;
+    // Stage 3: LLM synthesis, streamed token by token
+    if (!stream.IsCancelled() && llmEngine && llmEngine->IsModelLoaded() &&
+        !vaultResults.empty()) {
+        Answer llmAnswer = GenerateAnswerWithLLM(query, analysis, vaultResults, &stream);
+        
+        // Keep the extractive steps/quotes/sources alongside the synthesis
+        answer.summary = llmAnswer.summary;
+        answer.confidence = llmAnswer.confidence;
+    }
+    
+    stream.PushFinal(answer);
+    return answer;
+}
+
+std::vector<SearchResult> SearchEngine::SearchVault(const std::string& query, int limit) {
+    std::vector<SearchResult> results;
+    if (!database) return results;
+    
+    // Over-fetch so diversification has distinct candidates to promote
+    int candidates = limit * 2;
+    
+    QueryAnalysis analysis = AnalyzeQuery(query);
+    if (analysis.intent == INTENT_QUOTE) {
+        results = database->SearchQuotes(analysis.person, analysis.secondaryTopic, candidates);
+    } else {
+        // Recency/authority are applied by the ranking function in SQLite
+        RankingOptions ranking;
+        if (analysis.needsRecent) {
+            ranking.recencyWeight = 0.8f;
+            ranking.halfLifeDays = 14.0f;
+        }
+        if (analysis.needsOfficial) {
+            ranking.authorityStrength = 2.0f;
+        }
+        results = database->SearchFTSCandidates(query, candidates, ranking);
+    }
+    
+    DiversifyResults(results, limit);
+    
+    // Candidates carry no bodies; load the full rows of the picks only
+    if (analysis.intent != INTENT_QUOTE) {
+        std::vector<SearchResult> loaded;
+        for (auto& result : results) {
+            if (database->GetItemById(result.item.id, result.item)) {
+                loaded.push_back(result);
+            }
+        }
+        results.swap(loaded);
+    }
+    return results;
+}
+
+// Stored body fingerprints when both results have one, else the snippets';
+// 0 means "no fingerprint" and never matches
+static float BodySimilarity(const std::vector<uint64_t>& bodies,
+                            const std::vector<uint64_t>& snippets, size_t a, size_t b) {
+    if (bodies[a] && bodies[b]) return SimHashSimilarity(bodies[a], bodies[b]);
+    if (snippets[a] && snippets[b]) return SimHashSimilarity(snippets[a], snippets[b]);
+    return 0.0f;
+}
+
+void SearchEngine::DiversifyResults(std::vector<SearchResult>& results, int limit) {
+    if (results.size() < 2) return;
+    
+    // Cheap per-result signals: body fingerprint (the stored one, else the
+    // snippet's), title shingles, domain and its authority
+    size_t count = results.size();
+    std::vector<uint64_t> fingerprints(count);
+    std::vector<uint64_t> snippetPrints(count);
+    std::vector<std::vector<uint32_t> > titles(count);
+    std::vector<float> relevance(count);
+    std::vector<float> authority(count);
+    float best = -results[0].score, worst = -results[0].score;
+    
+    for (size_t i = 0; i < count; i++) {
+        const VaultItem& item = results[i].item;
+        fingerprints[i] = item.simhash;
+        snippetPrints[i] = ComputeSimHash(item.text_snippet);
+        titles[i] = WordShingles(item.title);
+        authority[i] = database ? database->GetSourceAuthority(item.source_domain) : 1.0f;
+        
+        // Scores are negative (lower is better), like FTS rank
+        relevance[i] = -results[i].score;
+        best = std::max(best, relevance[i]);
+        worst = std::min(worst, relevance[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        relevance[i] = (best > worst) ? (relevance[i] - worst) / (best - worst) : 1.0f;
+    }
+    
+    std::vector<SearchResult> selected;
+    std::vector<size_t> selectedIndex;
+    std::vector<bool> used(count, false);
+    
+    while ((int)selected.size() < limit) {
+        int pick = -1;
+        float pickValue = 0.0f;
+        
+        for (size_t i = 0; i < count; i++) {
+            if (used[i]) continue;
+            
+            float maxSimilarity = 0.0f;
+            int duplicateOf = -1;
+            for (size_t k = 0; k < selectedIndex.size(); k++) {
+                size_t s = selectedIndex[k];
+                float body = BodySimilarity(fingerprints, snippetPrints, i, s);
+                if (body >= DUPLICATE_SIMILARITY) {
+                    duplicateOf = (int)k;
+                    break;
+                }
+                float similarity = 0.5f * body +
+                                   0.3f * ShingleJaccard(titles[i], titles[s]) +
+                                   0.2f * (results[i].item.source_domain == results[s].item.source_domain ? 1.0f : 0.0f);
+                maxSimilarity = std::max(maxSimilarity, similarity);
+            }
+            if (duplicateOf >= 0) {
+                // Keep the original of a syndicated story in the copy's slot:
+                // higher authority, else the earlier publication
+                size_t kept = selectedIndex[duplicateOf];
+                const VaultItem& item = results[i].item;
+                const VaultItem& keptItem = results[kept].item;
+                bool earlier = item.published_at > 0 &&
+                               (keptItem.published_at == 0 || item.published_at < keptItem.published_at);
+                if (authority[i] > authority[kept] ||
+                    (authority[i] == authority[kept] && earlier)) {
+                    selectedIndex[duplicateOf] = i;
+                    selected[duplicateOf] = results[i];
+                }
+                used[i] = true;
+                continue;
+            }
+            
+            float value = MMR_LAMBDA * relevance[i] - (1.0f - MMR_LAMBDA) * maxSimilarity;
+            if (pick < 0 || value > pickValue) {
+                pick = (int)i;
+                pickValue = value;
+            }
+        }
+        
+        if (pick < 0) break;
+        used[pick] = true;
+        selectedIndex.push_back(pick);
+        selected.push_back(results[pick]);
+    }
+    
+    results.swap(selected);
+}
+
+std::vector<ZIMSearchResult> SearchEngine::SearchWikipedia(const std::string& query, int limit) {
+    std::vector<ZIMSearchResult> results;
     if (zimReader && zimReader->IsLoaded()) {
-        zimResults = zimReader->SearchArticles(query, 5);
+        results = zimReader->SearchArticles(query, limit);
     }
+    return results;
+}
+
+Answer SearchEngine::GenerateAnswer(const std::string& query,
+                                    const std::vector<SearchResult>& vaultResults,
+                                    const std::vector<ZIMSearchResult>& zimResults) {
+    Answer answer;
+    QueryAnalysis analysis = AnalyzeQuery(query);
     
     // Generate answer based on intent
     switch (analysis.intent) {
@@ -125,6 +324,28 @@ Answer SearchEngine::AskOffline(const std::string& query) {
     return answer;
 }
 
+bool SearchEngine::GetMaterializedAnswer(const std::string& key, Answer& outAnswer) {
+    if (!database) return false;
+    
+    std::string blob;
+    if (!database->GetAnswer(key, blob)) {
+        return false;
+    }
+    
+    return DeserializeAnswer(blob, outAnswer);
+}
+
+bool SearchEngine::MaterializeAnswer(const std::string& key, const std::string& query) {
+    if (!database) return false;
+    
+    Answer answer = AskOffline(query);
+    if (answer.type == ANSWER_NONE || answer.sources.empty()) {
+        return false;
+    }
+    
+    return database->StoreAnswer(key, query, SerializeAnswer(answer));
+}
+
 QueryAnalysis SearchEngine::AnalyzeQuery(const std::string& query) {
     QueryAnalysis analysis;
     analysis.intent = INTENT_GENERAL;
@@ -258,13 +479,17 @@ Answer SearchEngine::BuildQuotesAnswer(const QueryAnalysis& analysis,
     }
     answer.summary += ":";
     
-    // Extract quotes from results
+    // Individual quotes come from the quotes index, attributed per speaker
     for (const auto& result : results) {
-        // Parse quotes_json (simplified - should use proper JSON parser)
-        if (!result.item.quotes_json.empty()) {
-            // For now, just add the raw quote data
-            answer.quotes.push_back(result.item.quotes_json);
-        } else if (!result.item.text_snippet.empty()) {
+        for (const auto& quote : result.quotes) {
+            if (answer.quotes.size() >= 3) break;
+            std::string line = "\"" + quote.text + "\"";
+            if (!quote.speaker.empty()) {
+                line += " - " + quote.speaker;
+            }
+            answer.quotes.push_back(line);
+        }
+        if (result.quotes.empty() && !result.item.text_snippet.empty()) {
             answer.quotes.push_back(result.item.text_snippet);
         }
         
@@ -298,33 +523,27 @@ Answer SearchEngine::BuildStepsAnswer(const QueryAnalysis& analysis,
         return answer;
     }
     
-    // Use first result for main content
-    const auto& topResult = results[0];
+    // Steps were extracted at ingest: prefer the best-ranked item that has them
+    const VaultItem* stepsItem = &results[0].item;
+    for (size_t i = 0; i < std::min(results.size(), size_t(3)); i++) {
+        if (!results[i].item.steps.empty()) {
+            stepsItem = &results[i].item;
+            break;
+        }
+    }
     answer.summary = "Instructions:";
     
-    // Extract steps from text (simplified)
-    std::string text = topResult.item.text_clean.empty() ? 
-                      topResult.item.text_snippet : topResult.item.text_clean;
-    
-    // Look for numbered steps or bullet points
-    std::istringstream iss(text);
-    std::string line;
-    int stepNum = 1;
-    
-    while (std::getline(iss, line) && answer.steps.size() < 10) {
-        // Check if line looks like a step
-        if (!line.empty() && (
-            line.find(std::to_string(stepNum)) == 0 ||
-            line[0] == '-' || line[0] == '*' ||
-            line.find("step") != std::string::npos)) {
-            
-            answer.steps.push_back(line);
-            stepNum++;
-        }
+    answer.steps = stepsItem->steps;
+    if (answer.steps.size() > 10) {
+        answer.steps.resize(10);
     }
+    answer.warnings = stepsItem->warnings;
+    answer.bullets = stepsItem->bullets;
     
     // If no steps found, create generic summary
     if (answer.steps.empty()) {
+        std::string text = stepsItem->text_clean.empty() ? 
+                          stepsItem->text_snippet : stepsItem->text_clean;
         answer.steps.push_back(text.substr(0, 200) + "...");
     }
     
@@ -362,6 +581,8 @@ Answer SearchEngine::BuildDirectAnswer(const QueryAnalysis& analysis,
     if (!topResult.item.text_clean.empty()) {
         answer.raw_text = topResult.item.text_clean;
     }
+    answer.bullets = topResult.item.bullets;
+    answer.warnings = topResult.item.warnings;
     
     // Add sources
     for (size_t i = 0; i < std::min(results.size(), size_t(5)); i++) {
@@ -396,6 +617,13 @@ Answer SearchEngine::BuildSummaryAnswer(const QueryAnalysis& analysis,
     for (size_t i = 0; i < std::min(results.size(), size_t(3)); i++) {
         combined += results[i].item.text_snippet + "\n\n";
         
+        for (const auto& warning : results[i].item.warnings) {
+            if (answer.warnings.size() >= 5) break;
+            if (std::find(answer.warnings.begin(), answer.warnings.end(), warning) == answer.warnings.end()) {
+                answer.warnings.push_back(warning);
+            }
+        }
+        
         SourceInfo source;
         source.title = results[i].item.title;
         source.url = results[i].item.url;
@@ -414,7 +642,8 @@ Answer SearchEngine::BuildSummaryAnswer(const QueryAnalysis& analysis,
 
 Answer SearchEngine::GenerateAnswerWithLLM(const std::string& query,
                                           const QueryAnalysis& analysis,
-                                          const std::vector<SearchResult>& results) {
+                                          const std::vector<SearchResult>& results,
+                                          AnswerStream* stream) {
     Answer answer;
     answer.type = ANSWER_SUMMARY;
     
@@ -427,9 +656,14 @@ Answer SearchEngine::GenerateAnswerWithLLM(const std::string& query,
     // Generate answer with LLM (streaming to show progress)
     std::string llmAnswer;
     llmEngine->GenerateStreaming(prompt, 
-        [&llmAnswer](const std::string& token) {
+        [this, &llmAnswer, stream](const std::string& token) {
             llmAnswer += token;
-            // Could update UI here for streaming effect
+            if (stream) {
+                stream->PushToken(token);
+                if (stream->IsCancelled()) {
+                    llmEngine->StopGeneration();
+                }
+            }
         }, 
         200 // Max tokens
     );
@@ -455,3 +689,151 @@ Answer SearchEngine::GenerateAnswerWithLLM(const std::string& query,
     
     return answer;
 }
+
+// Answer serialization
+// Layout: "ANS1", u8 type, f32 confidence, then length-prefixed strings and
+// string lists, then sources. Integers are little-endian.
+
+static void WriteU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out += (char)((value >> (i * 8)) & 0xFF);
+    }
+}
+
+static void WriteI64(std::string& out, int64_t value) {
+    uint64_t v = (uint64_t)value;
+    for (int i = 0; i < 8; i++) {
+        out += (char)((v >> (i * 8)) & 0xFF);
+    }
+}
+
+static void WriteF32(std::string& out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    WriteU32(out, bits);
+}
+
+static void WriteStr(std::string& out, const std::string& str) {
+    WriteU32(out, (uint32_t)str.size());
+    out += str;
+}
+
+static void WriteList(std::string& out, const std::vector<std::string>& list) {
+    WriteU32(out, (uint32_t)list.size());
+    for (const auto& str : list) {
+        WriteStr(out, str);
+    }
+}
+
+struct BlobReader {
+    const std::string& data;
+    size_t pos;
+    bool ok;
+    
+    BlobReader(const std::string& d) : data(d), pos(0), ok(true) {}
+    
+    bool Need(size_t n) {
+        if (!ok || data.size() - pos < n) ok = false;
+        return ok;
+    }
+    
+    uint64_t ReadLE(int bytes) {
+        if (!Need(bytes)) return 0;
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) {
+            v |= (uint64_t)(unsigned char)data[pos + i] << (i * 8);
+        }
+        pos += bytes;
+        return v;
+    }
+    
+    float ReadF32() {
+        uint32_t bits = (uint32_t)ReadLE(4);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    
+    std::string ReadStr() {
+        uint32_t len = (uint32_t)ReadLE(4);
+        if (!Need(len)) return "";
+        std::string str = data.substr(pos, len);
+        pos += len;
+        return str;
+    }
+    
+    std::vector<std::string> ReadList() {
+        std::vector<std::string> list;
+        uint32_t count = (uint32_t)ReadLE(4);
+        for (uint32_t i = 0; i < count && ok; i++) {
+            list.push_back(ReadStr());
+        }
+        return list;
+    }
+};
+
+std::string SerializeAnswer(const Answer& answer) {
+    std::string out = "ANS1";
+    out += (char)answer.type;
+    WriteF32(out, answer.confidence);
+    WriteStr(out, answer.summary);
+    WriteStr(out, answer.raw_text);
+    WriteList(out, answer.steps);
+    WriteList(out, answer.bullets);
+    WriteList(out, answer.warnings);
+    WriteList(out, answer.quotes);
+    
+    WriteU32(out, (uint32_t)answer.sources.size());
+    for (const auto& source : answer.sources) {
+        WriteStr(out, source.title);
+        WriteStr(out, source.url);
+        WriteStr(out, source.domain);
+        WriteStr(out, source.author);
+        WriteStr(out, source.content_type);
+        WriteI64(out, source.published);
+        WriteI64(out, source.retrieved);
+        WriteF32(out, source.confidence);
+    }
+    
+    return out;
+}
+
+bool DeserializeAnswer(const std::string& blob, Answer& outAnswer) {
+    if (blob.size() < 5 || blob.compare(0, 4, "ANS1") != 0) {
+        return false;
+    }
+    
+    BlobReader reader(blob);
+    reader.pos = 4;
+    
+    Answer answer;
+    answer.type = (AnswerType)reader.ReadLE(1);
+    answer.confidence = reader.ReadF32();
+    answer.summary = reader.ReadStr();
+    answer.raw_text = reader.ReadStr();
+    answer.steps = reader.ReadList();
+    answer.bullets = reader.ReadList();
+    answer.warnings = reader.ReadList();
+    answer.quotes = reader.ReadList();
+    
+    uint32_t sourceCount = (uint32_t)reader.ReadLE(4);
+    for (uint32_t i = 0; i < sourceCount && reader.ok; i++) {
+        SourceInfo source;
+        source.title = reader.ReadStr();
+        source.url = reader.ReadStr();
+        source.domain = reader.ReadStr();
+        source.author = reader.ReadStr();
+        source.content_type = reader.ReadStr();
+        source.published = (time_t)(int64_t)reader.ReadLE(8);
+        source.retrieved = (time_t)(int64_t)reader.ReadLE(8);
+        source.confidence = reader.ReadF32();
+        answer.sources.push_back(source);
+    }
+    
+    if (!reader.ok || answer.type > ANSWER_NONE) {
+        return false;
+    }
+    
+    outAnswer = answer;
+    return true;
+}
@@ -0,0 +1,97 @@
+#include "simhash.h"
+#include <algorithm>
+#include <cctype>
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Calls fn(hash) for each lowercase alphanumeric word, without allocating
+template <typename Fn>
+static void ForEachWordHash(const std::string& text, Fn fn) {
+    uint64_t hash = FNV_OFFSET;
+    bool inWord = false;
+    
+    for (size_t i = 0; i <= text.length(); i++) {
+        unsigned char c = i < text.length() ? text[i] : ' ';
+        if (isalnum(c) || c >= 0x80) {
+            hash = (hash ^ (unsigned char)tolower(c)) * FNV_PRIME;
+            inWord = true;
+        } else if (inWord) {
+            fn(hash);
+            hash = FNV_OFFSET;
+            inWord = false;
+        }
+    }
+}
+
+uint64_t ComputeSimHash(const std::string& text) {
+    int weights[64] = {0};
+    
+    ForEachWordHash(text, [&weights](uint64_t hash) {
+        for (int bit = 0; bit < 64; bit++) {
+            weights[bit] += ((hash >> bit) & 1) ? 1 : -1;
+        }
+    });
+    
+    uint64_t fingerprint = 0;
+    for (int bit = 0; bit < 64; bit++) {
+        if (weights[bit] > 0) fingerprint |= (1ULL << bit);
+    }
+    return fingerprint;
+}
+
+int HammingDistance(uint64_t a, uint64_t b) {
+    uint64_t x = a ^ b;
+    int count = 0;
+    while (x) {
+        x &= x - 1;
+        count++;
+    }
+    return count;
+}
+
+float SimHashSimilarity(uint64_t a, uint64_t b) {
+    int distance = HammingDistance(a, b);
+    return distance >= 32 ? 0.0f : 1.0f - distance / 32.0f;
+}
+
+std::vector<uint32_t> WordShingles(const std::string& text) {
+    std::vector<uint32_t> shingles;
+    uint64_t previous = 0;
+    bool hasPrevious = false;
+    
+    ForEachWordHash(text, [&](uint64_t hash) {
+        if (hasPrevious) {
+            shingles.push_back((uint32_t)((previous * FNV_PRIME) ^ hash));
+        }
+        previous = hash;
+        hasPrevious = true;
+    });
+    
+    if (shingles.empty() && hasPrevious) {
+        shingles.push_back((uint32_t)previous);
+    }
+    
+    std::sort(shingles.begin(), shingles.end());
+    shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+    return shingles;
+}
+
+float ShingleJaccard(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    if (a.empty() || b.empty()) return 0.0f;
+    
+    // Both sorted: count the intersection in one merge pass
+    size_t i = 0, j = 0, shared = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] == b[j]) {
+            shared++;
+            i++;
+            j++;
+        } else if (a[i] < b[j]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+    return (float)shared / (float)(a.size() + b.size() - shared);
+}
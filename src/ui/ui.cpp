@@ -1,13 +1,14 @@
 #include "ui.h"
 #include "survival_ai.h"
+#include "curated_questions.h"
 #include <sstream>
 #include <ctime>
 #include <iomanip>
 
 UI::UI() : currentScreen(SCREEN_MAIN_MENU), previousScreen(SCREEN_MAIN_MENU),
            selectedIndex(0), scrollOffset(0), currentAnswer(nullptr),
-           answerScrollPos(0), notificationTimer(0.0f), isLoading(false),
-           loadingSpinner(0.0f) {
+           answerScrollPos(0), askInFlight(false), answerHasTokens(false),
+           notificationTimer(0.0f), isLoading(false), loadingSpinner(0.0f) {
     keyboard.active = false;
     keyboard.submitted = false;
     memset(keyboard.inputTextBuffer, 0, sizeof(keyboard.inputTextBuffer));
@@ -15,6 +16,8 @@ UI::UI() : currentScreen(SCREEN_MAIN_MENU), previousScreen(SCREEN_MAIN_MENU),
 }
 
 UI::~UI() {
+    CancelAsk();
+    
     if (currentAnswer) {
         delete currentAnswer;
     }
@@ -29,12 +32,19 @@ bool UI::Initialize() {
 }
 
 void UI::Shutdown() {
+    CancelAsk();
+    
     if (fontLarge) {
         vita2d_free_pgf(fontLarge);
     }
 }
 
 void UI::Update(float deltaTime) {
+    // Consume progressive answer events from the search worker
+    if (askInFlight) {
+        PumpAnswerStream();
+    }
+    
     // Update notification timer
     if (notificationTimer > 0.0f) {
         notificationTimer -= deltaTime;
@@ -129,10 +139,7 @@ void UI::HandleInput(const SceCtrlData& pad, const SceCtrlData& oldPad) {
                 
                 // Process the query
                 if (!keyboard.text.empty() && g_app.search) {
-                    SetLoading(true, "Searching...");
-                    Answer answer = g_app.search->Ask(keyboard.text);
-                    SetLoading(false);
-                    DisplayAnswer(answer);
+                    StartAsk(keyboard.text);
                 }
             }
         }
@@ -156,7 +163,7 @@ void UI::HandleInput(const SceCtrlData& pad, const SceCtrlData& oldPad) {
                 }
             }
             break;
-            
+        
         case SCREEN_ASK:
             if (IsButtonPressed(SCE_CTRL_CROSS)) {
                 ShowKeyboard("Enter your question:", "");
@@ -171,7 +178,7 @@ void UI::HandleInput(const SceCtrlData& pad, const SceCtrlData& oldPad) {
                 SetScreen(SCREEN_MAIN_MENU);
             }
             break;
-            
+        
         case SCREEN_ASK_RESULTS:
             // Handle scrolling through answer
             if (IsButtonHeld(SCE_CTRL_UP)) {
@@ -187,11 +194,32 @@ void UI::HandleInput(const SceCtrlData& pad, const SceCtrlData& oldPad) {
                 }
             }
             if (IsButtonPressed(SCE_CTRL_CIRCLE)) {
+                CancelAsk();
                 SetScreen(SCREEN_ASK);
                 ClearAnswer();
             }
             break;
-            
+        
+        case SCREEN_SCENARIOS:
+            HandleListInput(pad, oldPad, SCENARIO_QUESTION_COUNT);
+            if (IsButtonPressed(SCE_CTRL_CROSS)) {
+                OpenCuratedQuestion(SCENARIO_QUESTIONS[selectedIndex]);
+            }
+            if (IsButtonPressed(SCE_CTRL_CIRCLE)) {
+                SetScreen(SCREEN_MAIN_MENU);
+            }
+            break;
+        
+        case SCREEN_MANUALS:
+            HandleListInput(pad, oldPad, MANUAL_QUESTION_COUNT);
+            if (IsButtonPressed(SCE_CTRL_CROSS)) {
+                OpenCuratedQuestion(MANUAL_QUESTIONS[selectedIndex]);
+            }
+            if (IsButtonPressed(SCE_CTRL_CIRCLE)) {
+                SetScreen(SCREEN_MAIN_MENU);
+            }
+            break;
+        
         case SCREEN_WIKIPEDIA:
             HandleListInput(pad, oldPad, listItems.size());
             if (IsButtonPressed(SCE_CTRL_CROSS)) {
@@ -202,7 +230,7 @@ void UI::HandleInput(const SceCtrlData& pad, const SceCtrlData& oldPad) {
                 SetScreen(SCREEN_MAIN_MENU);
             }
             break;
-            
+        
         default:
             if (IsButtonPressed(SCE_CTRL_CIRCLE)) {
                 SetScreen(SCREEN_MAIN_MENU);
@@ -280,6 +308,86 @@ void UI::ClearAnswer() {
     answerScrollPos = 0;
 }
 
+void UI::StartAsk(const std::string& query) {
+    CancelAsk();
+    ClearAnswer();
+    
+    answerStream.Reset();
+    answerHasTokens = false;
+    askInFlight = true;
+    SetLoading(true, "Searching...");
+    
+    askThread = std::thread([this, query]() {
+        g_app.search->AskStreaming(query, answerStream);
+    });
+}
+
+void UI::OpenCuratedQuestion(const CuratedQuestion& entry) {
+    if (!g_app.search) return;
+    
+    // The worker owns the database until it finishes
+    CancelAsk();
+    
+    // Precomputed in the pack: a single indexed read, no search or LLM
+    Answer answer;
+    if (g_app.search->GetMaterializedAnswer(entry.key, answer)) {
+        DisplayAnswer(answer);
+        return;
+    }
+    
+    // Older packs without materialized answers fall back to a live search
+    StartAsk(entry.question);
+}
+
+void UI::CancelAsk() {
+    if (askThread.joinable()) {
+        // Also aborts the online search's fetches, so the join is quick
+        answerStream.Cancel();
+        askThread.join();
+    }
+    askInFlight = false;
+}
+
+void UI::PumpAnswerStream() {
+    AnswerEvent event;
+    while (answerStream.Poll(event)) {
+        switch (event.type) {
+            case ANSWER_EVENT_PARTIAL:
+                // First useful content: drop the overlay and show sources
+                if (!currentAnswer) {
+                    SetLoading(false);
+                    DisplayAnswer(event.answer);
+                } else {
+                    *currentAnswer = event.answer;
+                }
+                break;
+            
+            case ANSWER_EVENT_TOKEN:
+                if (!currentAnswer) break;
+                // LLM synthesis replaces the extractive summary as it arrives
+                if (!answerHasTokens) {
+                    currentAnswer->summary.clear();
+                    answerHasTokens = true;
+                }
+                currentAnswer->summary += event.token;
+                break;
+            
+            case ANSWER_EVENT_FINAL:
+                SetLoading(false);
+                if (!currentAnswer) {
+                    DisplayAnswer(event.answer);
+                } else {
+                    *currentAnswer = event.answer;
+                }
+                if (askThread.joinable()) {
+                    askThread.join();
+                }
+                askInFlight = false;
+                return;
+        }
+    }
+}
+
 void UI::ShowNotification(const std::string& message, float duration) {
     notification = message;
     notificationTimer = duration;
@@ -401,6 +509,25 @@ void UI::RenderAskResults() {
         }
     }
     
+    // Warnings
+    if (!currentAnswer->warnings.empty()) {
+        DrawText("Warnings:", 40, y - answerScrollPos, COLOR_RED, font);
+        y += 30;
+        for (const auto& warning : currentAnswer->warnings) {
+            DrawTextWrapped("! " + warning, 60, y - answerScrollPos, SCREEN_WIDTH - 100, COLOR_WHITE);
+            y += 40;
+        }
+    }
+    
+    // Bullets
+    if (!currentAnswer->bullets.empty()) {
+        y += 10;
+        for (const auto& bullet : currentAnswer->bullets) {
+            DrawTextWrapped("- " + bullet, 60, y - answerScrollPos, SCREEN_WIDTH - 100, COLOR_WHITE);
+            y += 40;
+        }
+    }
+    
     // Quotes
     if (!currentAnswer->quotes.empty()) {
         DrawText("Quotes:", 40, y - answerScrollPos, COLOR_YELLOW, font);
@@ -420,6 +547,9 @@ void UI::RenderAskResults() {
     }
     
     // Controls
+    if (askInFlight) {
+        DrawText("Generating...", SCREEN_WIDTH - 200, 80, COLOR_YELLOW, fontSmall);
+    }
     DrawText("Up/Down: Scroll | Triangle: Speak | Circle: Back", 20, SCREEN_HEIGHT - 40, COLOR_GRAY, fontSmall);
 }
 
@@ -455,22 +585,22 @@ void UI::RenderVault() {
 
 void UI::RenderManuals() {
     RenderHeader("Manuals");
-    DrawText("Coming soon...", 40, 120, COLOR_GRAY, font);
+    
+    std::vector<std::string> manuals;
+    for (int i = 0; i < MANUAL_QUESTION_COUNT; i++) {
+        manuals.push_back(MANUAL_QUESTIONS[i].label);
+    }
+    
+    RenderList(manuals, selectedIndex, scrollOffset);
 }
 
 void UI::RenderScenarios() {
     RenderHeader("Scenarios");
     
-    std::vector<std::string> scenarios = {
-        "Bleeding",
-        "Burns",
-        "Lost/Navigation",
-        "No Water",
-        "Cold Weather",
-        "Hot Weather",
-        "Shelter",
-        "Food/Hunting"
-    };
+    std::vector<std::string> scenarios;
+    for (int i = 0; i < SCENARIO_QUESTION_COUNT; i++) {
+        scenarios.push_back(SCENARIO_QUESTIONS[i].label);
+    }
     
     RenderList(scenarios, selectedIndex, scrollOffset);
 }
@@ -0,0 +1,408 @@
+// Online pipeline benchmark for Vita Survival AI
+// Runs feed refresh and SearchAndSave against a recorded HTTP archive
+// (ReplayHttpTransport), so fetch, decode, extraction and dedupe are
+// measured the same way every run on a host with no network. With
+// --record the same run goes to the live sites (http only on the host)
+// and appends what it reads to the archive.
+
+#include "database.h"
+#include "net_fetcher.h"
+#include "rss_parser.h"
+#include "content_extractor.h"
+#include "online_search.h"
+#include "http_transport.h"
+#include "replay_transport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "fixtures"
+#endif
+
+struct BenchSettings {
+    std::string fixtureDir;
+    std::string archivePath;  // Default: <fixtureDir>/archive.rec
+    std::string dbPath;
+    std::string outPath;
+    bool record;
+    ReplayProfile profile;
+    int budgetSeconds;   // Per-query budget; -1 keeps the OnlineSearch default
+    int budgetKB;
+    int budgetRequests;
+
+    BenchSettings() :
+        fixtureDir(BENCH_FIXTURE_DIR "/online"),
+        dbPath("bench_online.sqlite"),
+        record(false),
+        budgetSeconds(-1),
+        budgetKB(-1),
+        budgetRequests(-1) {}
+};
+
+struct OnlineQuery {
+    std::string query;
+    std::vector<std::string> relevant;  // URLs that should end up in the vault
+};
+
+struct QueryResult {
+    OnlineQuery golden;
+    std::vector<std::string> saved;
+    double recall;
+    double latencyMs;
+    uint64_t requests;
+    uint64_t bytesRead;
+};
+
+// Helpers
+
+static std::vector<std::string> Split(const std::string& str, char delim) {
+    std::vector<std::string> parts;
+    std::string part;
+    std::istringstream iss(str);
+    while (std::getline(iss, part, delim)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+static std::string JsonEscape(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    result += buf;
+                } else {
+                    result += c;
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+static double Percentile(std::vector<double> samples, double pct) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = (size_t)(pct / 100.0 * samples.size() + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > samples.size()) rank = samples.size();
+    return samples[rank - 1];
+}
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Fixture loading
+
+static bool LoadFeeds(const std::string& path, RSSParser& rss) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    int count = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> cols = Split(line, '\t');
+        if (cols.size() < 4) continue;
+
+        FeedConfig feed;
+        feed.name = cols[0];
+        feed.url = cols[1];
+        feed.category = cols[2];
+        feed.priority = atoi(cols[3].c_str());
+        feed.enabled = true;
+        rss.AddFeed(feed);
+        count++;
+    }
+
+    return count > 0;
+}
+
+static bool LoadQueries(const std::string& path, std::vector<OnlineQuery>& outQueries) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> cols = Split(line, '\t');
+        if (cols.size() < 2) continue;
+
+        OnlineQuery query;
+        query.query = cols[0];
+        query.relevant = Split(cols[1], ',');
+        outQueries.push_back(query);
+    }
+
+    return !outQueries.empty();
+}
+
+// Query execution
+
+// Queries run in file order against one vault, so a page saved by an
+// earlier query counts towards a later one without being fetched again
+static QueryResult Measure(const OnlineQuery& golden, OnlineSearch& online, NetFetcher& net,
+                           std::set<std::string>& vaultUrls) {
+    QueryResult result;
+    result.golden = golden;
+
+    NetStats before = net.GetStats();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<VaultItem> items;
+    online.SearchAndSave(golden.query, items);
+
+    result.latencyMs = ElapsedMs(start);
+    NetStats after = net.GetStats();
+    result.requests = after.requests - before.requests;
+    result.bytesRead = after.bytesRead - before.bytesRead;
+
+    for (const auto& item : items) {
+        result.saved.push_back(item.url);
+        vaultUrls.insert(item.url);
+    }
+
+    int hits = 0;
+    for (const auto& url : golden.relevant) {
+        if (vaultUrls.count(url)) hits++;
+    }
+    result.recall = golden.relevant.empty() ? 0.0 : (double)hits / golden.relevant.size();
+
+    return result;
+}
+
+// Reporting
+
+static void WriteReport(std::ostream& out, const BenchSettings& settings,
+                        double refreshMs, int feedsFetched, int feedItems, int vaultItems,
+                        const NetStats& net, const ReplayStats& replay,
+                        const std::vector<QueryResult>& results) {
+    std::vector<double> latencies;
+    double recallSum = 0.0;
+    for (const auto& r : results) {
+        latencies.push_back(r.latencyMs);
+        recallSum += r.recall;
+    }
+    double recall = results.empty() ? 0.0 : recallSum / results.size();
+
+    char buf[512];
+    out << "{\n";
+    out << "  \"mode\": \"" << (settings.record ? "record" : "replay") << "\",\n";
+    out << "  \"budget\": {\"seconds\": " << settings.budgetSeconds
+        << ", \"kb\": " << settings.budgetKB
+        << ", \"requests\": " << settings.budgetRequests << "},\n";
+    out << "  \"profile\": {\"recorded_timings\": "
+        << (settings.profile.recordedTimings ? "true" : "false")
+        << ", \"latency_ms\": " << settings.profile.latencyMs
+        << ", \"bytes_per_second\": " << settings.profile.bytesPerSecond << "},\n";
+    snprintf(buf, sizeof(buf),
+        "  \"refresh\": {\"ms\": %.1f, \"feeds_fetched\": %d, \"feed_items\": %d},\n",
+        refreshMs, feedsFetched, feedItems);
+    out << buf;
+    snprintf(buf, sizeof(buf),
+        "  \"search\": {\"queries\": %d, \"recall\": %.4f, \"p50_ms\": %.1f, "
+        "\"p95_ms\": %.1f, \"max_ms\": %.1f, \"vault_items\": %d},\n",
+        (int)results.size(), recall, Percentile(latencies, 50), Percentile(latencies, 95),
+        Percentile(latencies, 100), vaultItems);
+    out << buf;
+    out << "  \"net\": {\"requests\": " << net.requests
+        << ", \"bytes_read\": " << net.bytesRead
+        << ", \"bytes_decoded\": " << net.bytesDecoded
+        << ", \"not_modified\": " << net.notModified
+        << ", \"connections_opened\": " << net.connectionsOpened
+        << ", \"connections_reused\": " << net.connectionsReused
+        << ", \"retries\": " << net.retries
+        << ", \"budget_stops\": " << net.budgetStops << "},\n";
+    out << "  \"replay\": {\"served\": " << replay.served
+        << ", \"not_modified\": " << replay.notModified
+        << ", \"missing\": " << replay.missing << "},\n";
+
+    out << "  \"queries\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"query\": \"" << JsonEscape(r.golden.query) << "\", "
+            << "\"recall\": " << r.recall << ", "
+            << "\"ms\": " << r.latencyMs << ", "
+            << "\"requests\": " << r.requests << ", "
+            << "\"bytes_read\": " << r.bytesRead << ", "
+            << "\"saved\": [";
+        for (size_t j = 0; j < r.saved.size(); j++) {
+            out << (j ? ", " : "") << "\"" << JsonEscape(r.saved[j]) << "\"";
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+
+    fprintf(stderr, "refresh %.0fms feeds=%d items=%d\n", refreshMs, feedsFetched, feedItems);
+    fprintf(stderr, "search  n=%-3d recall=%.3f p50=%.0fms p95=%.0fms vault=%d\n",
+            (int)results.size(), recall, Percentile(latencies, 50), Percentile(latencies, 95),
+            vaultItems);
+    fprintf(stderr, "net     requests=%llu bytes=%llu retries=%llu budget_stops=%llu "
+            "replay served=%llu 304=%llu missing=%llu\n",
+            (unsigned long long)net.requests, (unsigned long long)net.bytesRead,
+            (unsigned long long)net.retries, (unsigned long long)net.budgetStops,
+            (unsigned long long)replay.served,
+            (unsigned long long)replay.notModified, (unsigned long long)replay.missing);
+}
+
+static void PrintUsage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --fixtures DIR        Fixture directory (feeds.tsv, queries.tsv, archive.rec)\n"
+        "  --archive PATH        HTTP archive to replay or record (default DIR/archive.rec)\n"
+        "  --record              Fetch from the network and append to the archive\n"
+        "  --latency-ms N        Replay: added per connection and per request\n"
+        "  --recorded-timings    Replay: wait as long as each request took when recorded\n"
+        "  --bandwidth-kbps N    Replay: pace response bodies to N KB/s\n"
+        "  --budget-seconds N    Per-query fetch time limit (0 = unlimited)\n"
+        "  --budget-kb N         Per-query download limit (0 = unlimited)\n"
+        "  --budget-requests N   Per-query request limit (0 = unlimited)\n"
+        "  --db PATH             Vault database to (re)create (default bench_online.sqlite)\n"
+        "  --out FILE            Write JSON results to FILE instead of stdout\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    BenchSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--fixtures" && hasValue) settings.fixtureDir = argv[++i];
+        else if (arg == "--archive" && hasValue) settings.archivePath = argv[++i];
+        else if (arg == "--record") settings.record = true;
+        else if (arg == "--latency-ms" && hasValue) settings.profile.latencyMs = atoi(argv[++i]);
+        else if (arg == "--recorded-timings") settings.profile.recordedTimings = true;
+        else if (arg == "--bandwidth-kbps" && hasValue) settings.profile.bytesPerSecond = atoi(argv[++i]) * 1024;
+        else if (arg == "--budget-seconds" && hasValue) settings.budgetSeconds = atoi(argv[++i]);
+        else if (arg == "--budget-kb" && hasValue) settings.budgetKB = atoi(argv[++i]);
+        else if (arg == "--budget-requests" && hasValue) settings.budgetRequests = atoi(argv[++i]);
+        else if (arg == "--db" && hasValue) settings.dbPath = argv[++i];
+        else if (arg == "--out" && hasValue) settings.outPath = argv[++i];
+        else {
+            PrintUsage(argv[0]);
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+    if (settings.archivePath.empty()) {
+        settings.archivePath = settings.fixtureDir + "/archive.rec";
+    }
+
+    RSSParser rss;
+    if (!LoadFeeds(settings.fixtureDir + "/feeds.tsv", rss)) {
+        fprintf(stderr, "Failed to load feeds from %s\n", settings.fixtureDir.c_str());
+        return 1;
+    }
+
+    std::vector<OnlineQuery> queries;
+    if (!LoadQueries(settings.fixtureDir + "/queries.tsv", queries)) {
+        fprintf(stderr, "Failed to load queries from %s\n", settings.fixtureDir.c_str());
+        return 1;
+    }
+
+    // Network side: the archive, or the live sites with a recorder in front
+    PosixHttpTransport posix;
+    RecordingHttpTransport* recorder = nullptr;
+    ReplayHttpTransport replay;
+    HttpTransport* transport = &replay;
+
+    if (settings.record) {
+        recorder = new RecordingHttpTransport(&posix, settings.archivePath);
+        if (!recorder->IsOpen()) {
+            fprintf(stderr, "Failed to open archive %s for recording\n", settings.archivePath.c_str());
+            delete recorder;
+            return 1;
+        }
+        transport = recorder;
+    } else {
+        if (!replay.Load(settings.archivePath)) {
+            fprintf(stderr, "Failed to load archive %s\n", settings.archivePath.c_str());
+            return 1;
+        }
+        replay.SetProfile(settings.profile);
+    }
+
+    // Always start from a fresh vault so runs are comparable
+    remove(settings.dbPath.c_str());
+    remove((settings.dbPath + "-wal").c_str());
+    remove((settings.dbPath + "-shm").c_str());
+
+    Database db;
+    if (!db.Initialize(settings.dbPath)) {
+        fprintf(stderr, "Failed to initialize vault at %s\n", settings.dbPath.c_str());
+        delete recorder;
+        return 1;
+    }
+
+    NetFetcher net;
+    net.Initialize(transport);
+
+    ContentExtractor extractor;
+    OnlineSearch online;
+    online.Initialize(&net, &rss, &extractor, &db);
+
+    // Archived items keep their dates, so nothing is pruned for age, and
+    // the vault is not trimmed mid-run
+    OnlineSearchSettings onlineSettings = online.GetSettings();
+    onlineSettings.feedItemMaxAgeDays = 36500;
+    onlineSettings.cacheSizeLimitMB = 0;
+    if (settings.budgetSeconds >= 0) onlineSettings.searchBudgetSeconds = settings.budgetSeconds;
+    if (settings.budgetKB >= 0) onlineSettings.searchBudgetKB = settings.budgetKB;
+    if (settings.budgetRequests >= 0) onlineSettings.searchBudgetRequests = settings.budgetRequests;
+    online.SetSettings(onlineSettings);
+
+    auto start = std::chrono::steady_clock::now();
+    int feedsFetched = online.RefreshFeeds(true);
+    double refreshMs = ElapsedMs(start);
+
+    std::set<std::string> vaultUrls;
+    std::vector<QueryResult> results;
+    for (const auto& q : queries) {
+        results.push_back(Measure(q, online, net, vaultUrls));
+    }
+
+    NetStats netStats = net.GetStats();
+    ReplayStats replayStats = replay.GetStats();
+    int feedItems = db.GetFeedItemCount();
+    int vaultItems = db.GetTotalItems();
+
+    if (settings.outPath.empty()) {
+        WriteReport(std::cout, settings, refreshMs, feedsFetched, feedItems, vaultItems,
+                    netStats, replayStats, results);
+    } else {
+        std::ofstream out(settings.outPath.c_str());
+        WriteReport(out, settings, refreshMs, feedsFetched, feedItems, vaultItems,
+                    netStats, replayStats, results);
+    }
+
+    if (recorder) {
+        fprintf(stderr, "recorded %zu responses to %s\n", recorder->GetRecordedCount(),
+                settings.archivePath.c_str());
+    }
+
+    net.Shutdown();
+    db.Close();
+    delete recorder;
+    return 0;
+}
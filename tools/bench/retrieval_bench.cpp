@@ -0,0 +1,521 @@
+// Retrieval benchmark for Vita Survival AI
+// Builds a fixture vault on the host, runs the golden query set through
+// SearchEngine::AskOffline, Database::SearchFTS and Database::SearchQuotes,
+// and reports recall@k / MRR alongside latency percentiles and allocations
+// per query as JSON.
+
+#include "database.h"
+#include "zim_reader.h"
+#include "search_engine.h"
+#include "content_extractor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "fixtures"
+#endif
+
+// Allocation counting (operator new only - SQLite allocates through malloc)
+static std::atomic<unsigned long> g_allocCount(0);
+static std::atomic<unsigned long> g_allocBytes(0);
+
+void* operator new(size_t size) {
+    g_allocCount++;
+    g_allocBytes += size;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+struct BenchSettings {
+    std::string fixtureDir;
+    std::string dbPath;
+    std::string zimPath;
+    std::string outPath;
+    int fillerDocs;
+    int iterations;
+    int k;
+    unsigned int seed;
+
+    BenchSettings() :
+        fixtureDir(BENCH_FIXTURE_DIR),
+        dbPath("bench_vault.sqlite"),
+        fillerDocs(2000),
+        iterations(20),
+        k(5),
+        seed(1234) {}
+};
+
+struct GoldenQuery {
+    std::string mode;     // "ask", "fts" or "quotes"
+    std::string query;
+    std::vector<std::string> relevant;
+};
+
+struct QueryResult {
+    GoldenQuery golden;
+    std::vector<std::string> ranked;
+    double recall;
+    double reciprocalRank;
+    std::vector<double> latenciesUs;
+    double allocsPerQuery;
+    double bytesPerQuery;
+};
+
+static const char* FIXTURE_URL_PREFIX = "fixture://";
+
+// Helpers
+
+static std::vector<std::string> Split(const std::string& str, char delim) {
+    std::vector<std::string> parts;
+    std::string part;
+    std::istringstream iss(str);
+    while (std::getline(iss, part, delim)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+static std::string Unescape(const std::string& str) {
+    std::string result;
+    for (size_t i = 0; i < str.length(); i++) {
+        if (str[i] == '\\' && i + 1 < str.length() && str[i + 1] == 'n') {
+            result += '\n';
+            i++;
+        } else {
+            result += str[i];
+        }
+    }
+    return result;
+}
+
+static std::string JsonEscape(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    result += buf;
+                } else {
+                    result += c;
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+static double Percentile(std::vector<double> samples, double pct) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = (size_t)(pct / 100.0 * samples.size() + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > samples.size()) rank = samples.size();
+    return samples[rank - 1];
+}
+
+// Fixture loading
+
+static bool LoadCorpus(const std::string& path, std::vector<VaultItem>& outItems) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> cols = Split(line, '\t');
+        if (cols.size() < 9) continue;
+
+        VaultItem item;
+        item.id = cols[0];
+        item.url = FIXTURE_URL_PREFIX + cols[0];
+        item.source_domain = cols[1];
+        item.content_type = cols[2];
+        item.author = cols[3];
+        item.published_at = (time_t)atol(cols[4].c_str());
+        item.retrieved_at = item.published_at;
+        item.topic_tags = cols[5];
+        item.title = cols[6];
+        item.text_clean = Unescape(cols[8]);
+        item.text_snippet = item.text_clean.substr(0, 500);
+        item.language = "en";
+        item.license_note = "fixture";
+        item.relevance_score = 0.0f;
+
+        // Ingest-time structure, as ContentExtractor::Extract produces it
+        ContentExtractor extractor;
+        ExtractedContent structure;
+        extractor.ExtractStructure(item.text_clean, structure);
+        item.steps = structure.steps;
+        item.warnings = structure.warnings;
+        item.bullets = structure.bullets;
+
+        // Attributed quotes, as ContentExtractor::Extract finds them; the
+        // quotes column is the fallback for texts without quotation marks
+        std::vector<Quote> quotes = extractor.ExtractQuotes(item.text_clean);
+        for (const auto& quote : quotes) {
+            VaultQuote vaultQuote;
+            vaultQuote.text = quote.text;
+            vaultQuote.speaker = quote.speaker;
+            vaultQuote.context = quote.context;
+            vaultQuote.position = quote.position;
+            item.quotes.push_back(vaultQuote);
+        }
+        if (item.quotes.empty() && !cols[7].empty()) {
+            size_t start = 0;
+            while (start <= cols[7].length()) {
+                size_t end = cols[7].find(" | ", start);
+                if (end == std::string::npos) end = cols[7].length();
+                VaultQuote vaultQuote;
+                vaultQuote.text = cols[7].substr(start, end - start);
+                vaultQuote.position = (int)start;
+                item.quotes.push_back(vaultQuote);
+                start = end + 3;
+            }
+        }
+        item.quotes_json = EncodeQuotesJson(item.quotes);
+
+        outItems.push_back(item);
+    }
+
+    return !outItems.empty();
+}
+
+static bool LoadGolden(const std::string& path, std::vector<GoldenQuery>& outQueries) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> cols = Split(line, '\t');
+        if (cols.size() < 3) continue;
+
+        GoldenQuery golden;
+        golden.mode = cols[0];
+        golden.query = cols[1];
+        golden.relevant = Split(cols[2], ',');
+        outQueries.push_back(golden);
+    }
+
+    return !outQueries.empty();
+}
+
+// Deterministic filler documents so latency is measured against a vault of
+// realistic size rather than just the hand-written fixtures
+static std::vector<VaultItem> GenerateFiller(int count, unsigned int seed) {
+    static const char* vocab[] = {
+        "the", "a", "of", "and", "to", "in", "is", "for", "on", "with",
+        "report", "county", "officials", "said", "weather", "road", "season",
+        "supply", "market", "local", "family", "camp", "trail", "river",
+        "storm", "power", "outage", "school", "hospital", "volunteer",
+        "training", "equipment", "battery", "radio", "map", "forest",
+        "mountain", "winter", "summer", "community", "safety", "plan",
+        "water", "fire", "food", "shelter", "cold", "heat", "injury", "rescue"
+    };
+    static const char* domains[] = {
+        "localnews.example", "outdoors.example", "weekly.example", "blog.example"
+    };
+    const int vocabSize = sizeof(vocab) / sizeof(vocab[0]);
+
+    std::vector<VaultItem> items;
+    unsigned int state = seed ? seed : 1;
+
+    for (int i = 0; i < count; i++) {
+        VaultItem item;
+        std::string text;
+        std::string title;
+
+        for (int w = 0; w < 180; w++) {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            const char* word = vocab[state % vocabSize];
+            if (w < 6) title += std::string(w ? " " : "") + word;
+            text += std::string(w ? " " : "") + word;
+        }
+
+        item.id = "filler-" + std::to_string(i);
+        item.url = FIXTURE_URL_PREFIX + item.id;
+        item.title = title;
+        item.source_domain = domains[i % 4];
+        item.author = "";
+        item.published_at = 1600000000 + i * 3600;
+        item.retrieved_at = item.published_at;
+        item.topic_tags = "filler";
+        item.text_clean = text;
+        item.text_snippet = text.substr(0, 500);
+        item.language = "en";
+        item.content_type = "article";
+        item.license_note = "fixture";
+        item.relevance_score = 0.0f;
+        items.push_back(item);
+    }
+
+    return items;
+}
+
+// Query execution
+
+static std::vector<std::string> RunQuery(const GoldenQuery& golden, Database& db,
+                                         SearchEngine& search, int k) {
+    std::vector<std::string> ranked;
+
+    if (golden.mode == "ask") {
+        Answer answer = search.AskOffline(golden.query);
+        size_t prefixLen = strlen(FIXTURE_URL_PREFIX);
+        for (const auto& source : answer.sources) {
+            if (source.url.compare(0, prefixLen, FIXTURE_URL_PREFIX) == 0) {
+                ranked.push_back(source.url.substr(prefixLen));
+            }
+        }
+    } else {
+        std::vector<SearchResult> results;
+        if (golden.mode == "quotes") {
+            size_t bar = golden.query.find('|');
+            std::string person = golden.query.substr(0, bar);
+            std::string topic = (bar == std::string::npos) ? "" : golden.query.substr(bar + 1);
+            results = db.SearchQuotes(person, topic, k);
+        } else {
+            results = db.SearchFTS(golden.query, k);
+        }
+        for (const auto& result : results) {
+            ranked.push_back(result.item.id);
+        }
+    }
+
+    if ((int)ranked.size() > k) {
+        ranked.resize(k);
+    }
+    return ranked;
+}
+
+static QueryResult Measure(const GoldenQuery& golden, Database& db,
+                           SearchEngine& search, const BenchSettings& settings) {
+    QueryResult result;
+    result.golden = golden;
+
+    // Warm-up run doubles as the quality measurement
+    result.ranked = RunQuery(golden, db, search, settings.k);
+
+    std::set<std::string> relevant(golden.relevant.begin(), golden.relevant.end());
+    int hits = 0;
+    result.reciprocalRank = 0.0;
+    for (size_t i = 0; i < result.ranked.size(); i++) {
+        if (relevant.count(result.ranked[i])) {
+            hits++;
+            if (result.reciprocalRank == 0.0) {
+                result.reciprocalRank = 1.0 / (i + 1);
+            }
+        }
+    }
+    result.recall = relevant.empty() ? 0.0 : (double)hits / relevant.size();
+
+    unsigned long allocsBefore = g_allocCount;
+    unsigned long bytesBefore = g_allocBytes;
+
+    for (int i = 0; i < settings.iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        RunQuery(golden, db, search, settings.k);
+        auto end = std::chrono::steady_clock::now();
+        result.latenciesUs.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    int runs = std::max(settings.iterations, 1);
+    result.allocsPerQuery = (double)(g_allocCount - allocsBefore) / runs;
+    result.bytesPerQuery = (double)(g_allocBytes - bytesBefore) / runs;
+
+    return result;
+}
+
+// Reporting
+
+static void WriteModeSummary(std::ostream& out, const std::string& mode,
+                             const std::vector<QueryResult>& results, bool& first) {
+    std::vector<double> latencies;
+    double recallSum = 0.0, rrSum = 0.0, allocSum = 0.0, bytesSum = 0.0;
+    int count = 0;
+
+    for (const auto& r : results) {
+        if (r.golden.mode != mode) continue;
+        latencies.insert(latencies.end(), r.latenciesUs.begin(), r.latenciesUs.end());
+        recallSum += r.recall;
+        rrSum += r.reciprocalRank;
+        allocSum += r.allocsPerQuery;
+        bytesSum += r.bytesPerQuery;
+        count++;
+    }
+    if (count == 0) return;
+
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "%s    \"%s\": {\"queries\": %d, \"recall_at_k\": %.4f, \"mrr\": %.4f, "
+        "\"p50_us\": %.1f, \"p95_us\": %.1f, \"p99_us\": %.1f, "
+        "\"allocs_per_query\": %.1f, \"bytes_per_query\": %.1f}",
+        first ? "" : ",\n", mode.c_str(), count, recallSum / count, rrSum / count,
+        Percentile(latencies, 50), Percentile(latencies, 95), Percentile(latencies, 99),
+        allocSum / count, bytesSum / count);
+    out << buf;
+    first = false;
+
+    fprintf(stderr, "%-7s n=%-3d recall@k=%.3f mrr=%.3f p50=%.0fus p95=%.0fus p99=%.0fus allocs=%.0f\n",
+            mode.c_str(), count, recallSum / count, rrSum / count,
+            Percentile(latencies, 50), Percentile(latencies, 95), Percentile(latencies, 99),
+            allocSum / count);
+}
+
+static void WriteReport(std::ostream& out, const BenchSettings& settings,
+                        int vaultItems, bool zimLoaded,
+                        const std::vector<QueryResult>& results) {
+    out << "{\n";
+    out << "  \"k\": " << settings.k << ",\n";
+    out << "  \"iterations\": " << settings.iterations << ",\n";
+    out << "  \"vault_items\": " << vaultItems << ",\n";
+    out << "  \"zim_loaded\": " << (zimLoaded ? "true" : "false") << ",\n";
+    out << "  \"modes\": {\n";
+
+    bool first = true;
+    WriteModeSummary(out, "ask", results, first);
+    WriteModeSummary(out, "fts", results, first);
+    WriteModeSummary(out, "quotes", results, first);
+    out << "\n  },\n";
+
+    out << "  \"queries\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"mode\": \"" << r.golden.mode << "\", "
+            << "\"query\": \"" << JsonEscape(r.golden.query) << "\", "
+            << "\"recall\": " << r.recall << ", "
+            << "\"rr\": " << r.reciprocalRank << ", "
+            << "\"p50_us\": " << Percentile(r.latenciesUs, 50) << ", "
+            << "\"allocs\": " << r.allocsPerQuery << ", "
+            << "\"ranked\": [";
+        for (size_t j = 0; j < r.ranked.size(); j++) {
+            out << (j ? ", " : "") << "\"" << JsonEscape(r.ranked[j]) << "\"";
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+static void PrintUsage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --fixtures DIR     Fixture directory (corpus.tsv, golden_queries.tsv)\n"
+        "  --db PATH          Vault database to (re)create (default bench_vault.sqlite)\n"
+        "  --zim PATH         Optional test ZIM for Wikipedia fallback\n"
+        "  --filler N         Synthetic filler documents (default 2000)\n"
+        "  --iterations N     Timed runs per query (default 20)\n"
+        "  -k N               Cut-off for recall@k / MRR (default 5)\n"
+        "  --seed N           Filler generator seed (default 1234)\n"
+        "  --out FILE         Write JSON results to FILE instead of stdout\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    BenchSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--fixtures" && hasValue) settings.fixtureDir = argv[++i];
+        else if (arg == "--db" && hasValue) settings.dbPath = argv[++i];
+        else if (arg == "--zim" && hasValue) settings.zimPath = argv[++i];
+        else if (arg == "--out" && hasValue) settings.outPath = argv[++i];
+        else if (arg == "--filler" && hasValue) settings.fillerDocs = atoi(argv[++i]);
+        else if (arg == "--iterations" && hasValue) settings.iterations = atoi(argv[++i]);
+        else if (arg == "-k" && hasValue) settings.k = atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) settings.seed = (unsigned int)atol(argv[++i]);
+        else {
+            PrintUsage(argv[0]);
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    std::vector<VaultItem> corpus;
+    if (!LoadCorpus(settings.fixtureDir + "/corpus.tsv", corpus)) {
+        fprintf(stderr, "Failed to load corpus from %s\n", settings.fixtureDir.c_str());
+        return 1;
+    }
+
+    std::vector<GoldenQuery> golden;
+    if (!LoadGolden(settings.fixtureDir + "/golden_queries.tsv", golden)) {
+        fprintf(stderr, "Failed to load golden queries from %s\n", settings.fixtureDir.c_str());
+        return 1;
+    }
+
+    // Always start from a fresh vault so runs are comparable
+    remove(settings.dbPath.c_str());
+    remove((settings.dbPath + "-wal").c_str());
+    remove((settings.dbPath + "-shm").c_str());
+
+    Database db;
+    if (!db.Initialize(settings.dbPath)) {
+        fprintf(stderr, "Failed to initialize vault at %s\n", settings.dbPath.c_str());
+        return 1;
+    }
+
+    std::vector<VaultItem> filler = GenerateFiller(settings.fillerDocs, settings.seed);
+    db.RunInTransaction([&]() {
+        for (const auto& item : corpus) db.InsertItem(item);
+        for (const auto& item : filler) db.InsertItem(item);
+        return true;
+    });
+    db.OptimizeFTS();
+
+    ZIMReader zim;
+    if (!settings.zimPath.empty()) {
+        zim.LoadZIM(settings.zimPath);
+    }
+
+    SearchEngine search;
+    search.Initialize(&db, &zim);
+
+    std::vector<QueryResult> results;
+    for (const auto& q : golden) {
+        results.push_back(Measure(q, db, search, settings));
+    }
+
+    if (settings.outPath.empty()) {
+        WriteReport(std::cout, settings, db.GetTotalItems(), zim.IsLoaded(), results);
+    } else {
+        std::ofstream out(settings.outPath.c_str());
+        WriteReport(out, settings, db.GetTotalItems(), zim.IsLoaded(), results);
+    }
+
+    db.Close();
+    return 0;
+}
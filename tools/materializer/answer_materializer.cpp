@@ -0,0 +1,74 @@
+// Answer materializer for Vita Survival AI
+// Runs retrieval + answer building on the host for every curated Scenario
+// and Manual question and stores the serialized Answer in the pack, so the
+// Vita can show them with a single indexed read.
+
+#include "database.h"
+#include "zim_reader.h"
+#include "search_engine.h"
+#include "curated_questions.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static int MaterializeList(SearchEngine& search, const CuratedQuestion* list, int count) {
+    int built = 0;
+    for (int i = 0; i < count; i++) {
+        if (search.MaterializeAnswer(list[i].key, list[i].question)) {
+            printf("  %-22s ok\n", list[i].key);
+            built++;
+        } else {
+            printf("  %-22s no answer (live search will be used)\n", list[i].key);
+        }
+    }
+    return built;
+}
+
+int main(int argc, char** argv) {
+    std::string vaultPath;
+    std::string zimPath;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--vault" && i + 1 < argc) vaultPath = argv[++i];
+        else if (arg == "--zim" && i + 1 < argc) zimPath = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s --vault PATH [--zim PATH]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (vaultPath.empty()) {
+        fprintf(stderr, "Usage: %s --vault PATH [--zim PATH]\n", argv[0]);
+        return 1;
+    }
+    
+    Database db;
+    if (!db.Initialize(vaultPath)) {
+        fprintf(stderr, "Failed to open vault at %s\n", vaultPath.c_str());
+        return 1;
+    }
+    
+    ZIMReader zim;
+    if (!zimPath.empty()) {
+        zim.LoadZIM(zimPath);
+    }
+    
+    // No LLM: materialized answers must be reproducible and cheap to rebuild
+    SearchEngine search;
+    search.Initialize(&db, &zim);
+    
+    printf("Materializing answers into %s\n", vaultPath.c_str());
+    
+    int built = 0;
+    db.RunInTransaction([&]() {
+        built = MaterializeList(search, SCENARIO_QUESTIONS, SCENARIO_QUESTION_COUNT);
+        built += MaterializeList(search, MANUAL_QUESTIONS, MANUAL_QUESTION_COUNT);
+        return true;
+    });
+    
+    printf("Stored %d of %d answers\n", built, SCENARIO_QUESTION_COUNT + MANUAL_QUESTION_COUNT);
+    
+    db.Close();
+    return 0;
+}
@@ -5,9 +5,9 @@ Collects, processes, and packages web references for offline access
 """
 
 import argparse
-import hashlib
 import json
 import os
+import re
 import sqlite3
 import time
 from datetime import datetime
@@ -27,6 +27,92 @@ except ImportError:
     print("Install with: pip install requests beautifulsoup4 readability-lxml feedparser")
 
 
+# Query parameters that only track the click (same list as item_identity.cpp)
+TRACKING_PARAMS = {
+    'fbclid', 'gclid', 'dclid', 'msclkid', 'yclid', 'igshid', 'mc_cid',
+    'mc_eid', '_ga', '_hsenc', '_hsmi', 'ref_src', 'spm'
+}
+
+
+def canonicalize_url(url: str) -> str:
+    """Same rules as CanonicalizeUrl() on the Vita"""
+    url = url.strip().split('#', 1)[0]
+    if '://' not in url:
+        return url
+    scheme, rest = url.split('://', 1)
+    scheme = scheme.lower()
+    host_end = len(rest)
+    for sep in '/?':
+        pos = rest.find(sep)
+        if pos != -1:
+            host_end = min(host_end, pos)
+    host, rest = rest[:host_end].lower(), rest[host_end:]
+    colon = host.rfind(':')
+    if colon != -1 and ']' not in host[colon:]:
+        port = host[colon + 1:]
+        if (scheme == 'http' and port == '80') or (scheme == 'https' and port == '443') or not port:
+            host = host[:colon]
+    path, _, query = rest.partition('?')
+    params = sorted(p for p in query.split('&')
+                    if p and not (p.split('=', 1)[0].lower().startswith('utm_')
+                                  or p.split('=', 1)[0].lower() in TRACKING_PARAMS))
+    canonical = f"{scheme}://{host}{path or '/'}"
+    if params:
+        canonical += '?' + '&'.join(params)
+    return canonical
+
+
+def murmur3_x64_128(data: bytes, seed: int = 0) -> (int, int):
+    """Reference MurmurHash3_x64_128 (matches item_identity.cpp)"""
+    mask = 0xFFFFFFFFFFFFFFFF
+    c1, c2 = 0x87c37b91114253d5, 0x4cf5ad432745937f
+    rotl = lambda x, r: ((x << r) | (x >> (64 - r))) & mask
+    
+    def fmix(k):
+        k ^= k >> 33
+        k = (k * 0xff51afd7ed558ccd) & mask
+        k ^= k >> 33
+        k = (k * 0xc4ceb9fe1a85ec53) & mask
+        return k ^ (k >> 33)
+    
+    h1 = h2 = seed
+    blocks = len(data) // 16
+    for i in range(blocks):
+        k1 = int.from_bytes(data[i * 16:i * 16 + 8], 'little')
+        k2 = int.from_bytes(data[i * 16 + 8:i * 16 + 16], 'little')
+        k1 = (rotl((k1 * c1) & mask, 31) * c2) & mask
+        h1 ^= k1
+        h1 = (rotl(h1, 27) + h2) & mask
+        h1 = (h1 * 5 + 0x52dce729) & mask
+        k2 = (rotl((k2 * c2) & mask, 33) * c1) & mask
+        h2 ^= k2
+        h2 = (rotl(h2, 31) + h1) & mask
+        h2 = (h2 * 5 + 0x38495ab5) & mask
+    
+    tail = data[blocks * 16:]
+    if len(tail) > 8:
+        k2 = int.from_bytes(tail[8:], 'little')
+        h2 ^= (rotl((k2 * c2) & mask, 33) * c1) & mask
+    if len(tail) > 0:
+        k1 = int.from_bytes(tail[:8], 'little')
+        h1 ^= (rotl((k1 * c1) & mask, 31) * c2) & mask
+    
+    h1 ^= len(data)
+    h2 ^= len(data)
+    h1 = (h1 + h2) & mask
+    h2 = (h2 + h1) & mask
+    h1, h2 = fmix(h1), fmix(h2)
+    h1 = (h1 + h2) & mask
+    h2 = (h2 + h1) & mask
+    return h1, h2
+
+
+def compute_item_id(url: str) -> str:
+    """Item ID shared with ComputeItemId() so the Vita recognizes packed items"""
+    h1, h2 = murmur3_x64_128(canonicalize_url(url).encode('utf-8'))
+    return f"{h1:016x}{h2:016x}"
+
+
 class VaultCollector:
     def __init__(self, output_dir: str):
         self.output_dir = output_dir
@@ -58,10 +144,19 @@ class VaultCollector:
                 quotes_json TEXT,
                 language TEXT DEFAULT 'en',
                 content_type TEXT,
-                license_note TEXT
+                license_note TEXT,
+                steps TEXT,
+                warnings TEXT,
+                bullets TEXT
             )
         """)
         
+        # Older packs predate the structured columns
+        existing = {row[1] for row in cursor.execute("PRAGMA table_info(items)")}
+        for column in ('steps', 'warnings', 'bullets'):
+            if column not in existing:
+                cursor.execute(f"ALTER TABLE items ADD COLUMN {column} TEXT")
+        
         # Create FTS5 index
         cursor.execute("""
             CREATE VIRTUAL TABLE IF NOT EXISTS items_fts USING fts5(
@@ -83,8 +178,118 @@ class VaultCollector:
             END
         """)
         
+        # Attributed quotes, same schema as Database::CreateTables on the Vita
+        cursor.execute("""
+            CREATE TABLE IF NOT EXISTS quotes (
+                quote_id INTEGER PRIMARY KEY,
+                item_rowid INTEGER NOT NULL,
+                speaker TEXT,
+                text TEXT NOT NULL,
+                context TEXT,
+                position INTEGER
+            )
+        """)
+        cursor.execute("CREATE INDEX IF NOT EXISTS idx_quotes_item ON quotes(item_rowid)")
+        cursor.execute("""
+            CREATE VIRTUAL TABLE IF NOT EXISTS quotes_fts USING fts5(
+                speaker,
+                text,
+                context,
+                content='quotes',
+                content_rowid='quote_id'
+            )
+        """)
+        cursor.execute("""
+            CREATE TRIGGER IF NOT EXISTS quotes_ai AFTER INSERT ON quotes BEGIN
+                INSERT INTO quotes_fts(rowid, speaker, text, context)
+                VALUES (new.quote_id, new.speaker, new.text, new.context);
+            END
+        """)
+        cursor.execute("""
+            CREATE TRIGGER IF NOT EXISTS quotes_ad AFTER DELETE ON quotes BEGIN
+                INSERT INTO quotes_fts(quotes_fts, rowid, speaker, text, context)
+                VALUES('delete', old.quote_id, old.speaker, old.text, old.context);
+            END
+        """)
+        
         self.conn.commit()
         
+    # Limits match ContentExtractor on the Vita
+    MAX_STEPS = 20
+    MAX_WARNINGS = 10
+    MAX_BULLETS = 20
+    
+    STEP_RE = re.compile(r'^(?:step\s+)?(\d{1,2})\s*[.):]\s*-?\s*(.+)$', re.IGNORECASE)
+    WARNING_LABEL_RE = re.compile(r'^(?:warning|caution|danger|important)\s*[:!]?\s+(.+)$', re.IGNORECASE)
+    WARNING_IMPERATIVE_RE = re.compile(r"^(?:do not|don't|never)\s", re.IGNORECASE)
+    
+    QUOTE_RE = re.compile(r'["\u201c]([^"\u201c\u201d]{20,200})["\u201d]')
+    ATTRIBUTION_VERBS = r'(?:said|says|told|stated|added|explained|warned|urged|wrote|announced)'
+    SPEAKER_AFTER_RE = re.compile(r'^\s*,?\s*(?:' + ATTRIBUTION_VERBS + r'\s+(?:the\s+)?([\w.\- ]{2,60}?)|(?:the\s+)?([\w.\- ]{2,60}?)\s+' + ATTRIBUTION_VERBS + r')\b', re.IGNORECASE)
+    PRONOUNS = {'he', 'she', 'they', 'it', 'we', 'i'}
+    
+    def extract_quotes(self, text: str) -> List[Dict]:
+        """Quoted spans with the speaker named right after them (if any)"""
+        quotes = []
+        for match in self.QUOTE_RE.finditer(text):
+            speaker = ''
+            attribution = self.SPEAKER_AFTER_RE.match(text[match.end():match.end() + 120])
+            if attribution:
+                speaker = (attribution.group(1) or attribution.group(2) or '').strip()
+                if speaker.lower() in self.PRONOUNS or len(speaker.split()) > 5:
+                    speaker = ''
+            start = max(0, match.start() - 80)
+            quotes.append({
+                'text': match.group(1).strip(),
+                'speaker': speaker,
+                'context': ' '.join(text[start:match.end() + 80].split()),
+                'position': match.start()
+            })
+        return quotes
+    
+    def extract_structure(self, soup, text: str) -> Dict[str, List[str]]:
+        """Detect steps, warnings and bullets once at packaging time"""
+        steps = []
+        for li in soup.select('ol > li'):
+            item = ' '.join(li.get_text(' ', strip=True).split())
+            if len(item.split()) >= 2:
+                steps.append(item)
+        
+        bullets = []
+        for li in soup.select('ul > li'):
+            links = ''.join(a.get_text() for a in li.find_all('a'))
+            item = ' '.join(li.get_text(' ', strip=True).split())
+            if len(item.split()) >= 2 and len(links) <= len(item) / 2:
+                bullets.append(item)
+        
+        # Plain-text numbering ("1.", "2)", "Step 3:") when there is no <ol>
+        if not steps:
+            expected = 1
+            for line in text.split('\n'):
+                match = self.STEP_RE.match(line.strip())
+                if match and int(match.group(1)) == expected:
+                    steps.append(match.group(2).strip())
+                    expected += 1
+        
+        warnings = []
+        for sentence in re.split(r'(?<=[.!?])\s+|\n', text):
+            sentence = sentence.strip()
+            if not 15 <= len(sentence) <= 300:
+                continue
+            label = self.WARNING_LABEL_RE.match(sentence)
+            if label:
+                warnings.append(label.group(1))
+            elif self.WARNING_IMPERATIVE_RE.match(sentence):
+                warnings.append(sentence)
+            if len(warnings) >= self.MAX_WARNINGS:
+                break
+        
+        return {
+            'steps': steps[:self.MAX_STEPS],
+            'warnings': warnings,
+            'bullets': bullets[:self.MAX_BULLETS]
+        }
+    
     def fetch_url(self, url: str) -> Optional[Dict]:
         """Fetch and parse a URL"""
         if not HAS_DEPS:
@@ -131,15 +336,14 @@ class VaultCollector:
             soup_clean = BeautifulSoup(text_clean, 'html.parser')
             text_clean = soup_clean.get_text(separator='\n', strip=True)
             
+            # Steps/warnings/bullets stored as columns, never re-parsed on device
+            structure = self.extract_structure(soup_clean, text_clean)
+            
             # Create snippet (first 500 chars)
             text_snippet = text_clean[:500] + "..." if len(text_clean) > 500 else text_clean
             
-            # Extract quotes (simplified - look for quotation marks)
-            quotes = []
-            for paragraph in soup_clean.find_all('p'):
-                text = paragraph.get_text()
-                if '"' in text or '"' in text:
-                    quotes.append(text.strip())
+            # Individual quotes with speakers (quotes table)
+            quotes = self.extract_quotes(text_clean)
             
             return {
                 'url': url,
@@ -149,6 +353,9 @@ class VaultCollector:
                 'text_snippet': text_snippet,
                 'text_clean': text_clean,
                 'quotes': quotes,
+                'steps': structure['steps'],
+                'warnings': structure['warnings'],
+                'bullets': structure['bullets'],
                 'domain': urlparse(url).netloc
             }
             
@@ -161,21 +368,26 @@ class VaultCollector:
         if not self.conn:
             self.init_database()
         
-        # Generate ID from URL
-        item_id = hashlib.sha256(data['url'].encode()).hexdigest()[:16]
+        # Generate ID from the canonical URL
+        data['url'] = canonicalize_url(data['url'])
+        item_id = compute_item_id(data['url'])
         
         # Prepare data
         retrieved_at = int(time.time())
         topic_tags = ','.join(tags) if tags else ''
-        quotes_json = json.dumps(data.get('quotes', [])) if data.get('quotes') else ''
+        quotes = data.get('quotes', [])
+        quotes_json = json.dumps([q['text'] for q in quotes], ensure_ascii=False) if quotes else ''
         
-        # Insert into database
+        # Insert into database (REPLACE doesn't fire delete triggers, so drop old quotes)
         cursor = self.conn.cursor()
+        cursor.execute("DELETE FROM quotes WHERE item_rowid IN (SELECT rowid FROM items WHERE id = ?)",
+                       (item_id,))
         cursor.execute("""
             INSERT OR REPLACE INTO items 
             (id, title, url, source_domain, author, published_at, retrieved_at,
-             topic_tags, text_snippet, text_clean, quotes_json, content_type)
-            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+             topic_tags, text_snippet, text_clean, quotes_json, content_type,
+             steps, warnings, bullets)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
         """, (
             item_id,
             data['title'],
@@ -188,9 +400,20 @@ class VaultCollector:
             data['text_snippet'],
             data['text_clean'],
             quotes_json,
-            content_type
+            content_type,
+            '\n'.join(data.get('steps', [])),
+            '\n'.join(data.get('warnings', [])),
+            '\n'.join(data.get('bullets', []))
         ))
         
+        item_rowid = cursor.lastrowid
+        for quote in quotes:
+            cursor.execute("""
+                INSERT INTO quotes (item_rowid, speaker, text, context, position)
+                VALUES (?, ?, ?, ?, ?)
+            """, (item_rowid, quote['speaker'] or data.get('author') or '',
+                  quote['text'], quote['context'], quote['position']))
+        
         self.conn.commit()
         
         # Save text file